@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "cpu/cpu.hpp"
+#include "mmu.hpp"
+#include "serial.hpp"
+#include "workloads.hpp"
+
+#ifndef GBE_TEST_ROM_DIR
+#define GBE_TEST_ROM_DIR "tests/testroms"
+#endif
+
+namespace
+{
+
+constexpr std::uint64_t cyclesPerFrame = 70224;
+constexpr double hardwareMHz = 4.194304;
+constexpr std::uint64_t defaultFrames = 600;
+// Run returns at least this often, so the cycle target is overshot by at most as many instructions.
+constexpr std::uint64_t instructionsPerBatch = 1024;
+
+// Bumped whenever a field changes meaning or goes away, new fields keep the version.
+constexpr int schemaVersion = 1;
+
+struct Workload
+{
+  std::string rom;
+  std::uint64_t cycles;
+  // Generated instead of loaded from rom, which is then just its name.
+  const SyntheticROM* synthetic = nullptr;
+};
+
+/**
+ * @brief Bundled ROMs with the frames each needs to finish, so a preset measures the test and not its final loop.
+ */
+struct PresetROM
+{
+  const char* path;
+  std::uint64_t frames;
+};
+
+// Synthetic workloads end by halting for good, this only bounds a broken one.
+constexpr std::uint64_t syntheticFrameLimit = 10000;
+
+// cpu_instrs.gb reports on all eleven tests a little after frame 3100. Without a timer its interrupt test fails.
+const std::vector<PresetROM> cpuInstrsPreset = {{"cpu_instrs.gb", 3200}};
+
+const std::vector<PresetROM> cputestsPreset = {
+    {"cputests/01-special.gb", 150},
+    {"cputests/02-interrupts.gb", 30},
+    {"cputests/03-op sp,hl.gb", 150},
+    {"cputests/04-op r,imm.gb", 180},
+    {"cputests/05-op rp.gb", 240},
+    {"cputests/06-ld r,r.gb", 40},
+    {"cputests/07-jr,jp,call,ret,rst.gb", 40},
+    {"cputests/08-misc instrs.gb", 40},
+    {"cputests/09-op r,r.gb", 600},
+    {"cputests/10-bit ops.gb", 900},
+    {"cputests/11-op a,(hl).gb", 1100},
+};
+
+struct Result
+{
+  std::string rom;
+  std::uint64_t cycles = 0;
+  std::uint64_t instructions = 0;
+  double seconds = 0.0;
+  // Last "Passed" or "Failed" the ROM sent over the serial port, empty if neither. Synthetic workloads pass if
+  // their final state matches.
+  std::string verdict;
+};
+
+/**
+ * @brief Peak resident set size of the process so far in KiB.
+ */
+std::uint64_t PeakRSSKiB()
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters{};
+  GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+  return counters.PeakWorkingSetSize / 1024;
+#else
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+  return static_cast<std::uint64_t>(usage.ru_maxrss) / 1024;
+#else
+  return static_cast<std::uint64_t>(usage.ru_maxrss);
+#endif
+#endif
+}
+
+std::string Verdict(const std::string& output)
+{
+  std::size_t passed = output.rfind("Passed");
+  std::size_t failed = output.rfind("Failed");
+
+  if (passed == std::string::npos && failed == std::string::npos)
+  {
+    return "";
+  }
+  if (failed == std::string::npos || (passed != std::string::npos && passed > failed))
+  {
+    return "Passed";
+  }
+  return "Failed";
+}
+
+/**
+ * @brief Runs the ROM from power on until it reaches the cycle target, or halts for good, and times it.
+ */
+Result Run(const Workload& workload, CPU::Dispatch dispatch)
+{
+  MMU mmu;
+  if (workload.synthetic)
+  {
+    mmu.LoadROM(workload.synthetic->image);
+  }
+  else
+  {
+    mmu.LoadROM(workload.rom);
+  }
+
+  CPU cpu{mmu};
+  cpu.SetDispatch(dispatch);
+
+  std::string output;
+  Serial serial{mmu, cpu};
+  serial.SetSink([&output](std::uint8_t byte) { output += static_cast<char>(byte); });
+
+  Result result;
+  result.rom = workload.rom;
+
+  auto start = std::chrono::steady_clock::now();
+  while (cpu.GetCycles() < workload.cycles)
+  {
+    std::uint64_t executed = cpu.Run(instructionsPerBatch);
+    if (executed == 0 && cpu.IsHalted() && cpu.GetScheduler().NextCycle() == Scheduler::never)
+    {
+      break;
+    }
+    result.instructions += executed;
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  result.cycles = cpu.GetCycles();
+  result.seconds = std::chrono::duration<double>(end - start).count();
+  result.verdict = Verdict(output);
+
+  if (workload.synthetic)
+  {
+    std::string mismatch = workload.synthetic->Mismatch(cpu, mmu);
+    if (!mismatch.empty())
+    {
+      std::cerr << workload.rom << ": " << mismatch << std::endl;
+    }
+    result.verdict = mismatch.empty() ? "Passed" : "Failed";
+  }
+  return result;
+}
+
+std::string Escape(const std::string& text)
+{
+  std::ostringstream escaped;
+  for (char character : text)
+  {
+    if (character == '"' || character == '\\')
+    {
+      escaped << '\\' << character;
+    }
+    else if (static_cast<unsigned char>(character) < 0x20)
+    {
+      escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(character) << std::dec;
+    }
+    else
+    {
+      escaped << character;
+    }
+  }
+  return escaped.str();
+}
+
+double EmulatedMHz(const Result& result)
+{
+  return (result.seconds > 0.0) ? result.cycles / result.seconds / 1e6 : 0.0;
+}
+
+double FramesPerSecond(const Result& result)
+{
+  return (result.seconds > 0.0) ? static_cast<double>(result.cycles) / cyclesPerFrame / result.seconds : 0.0;
+}
+
+double NanosecondsPerInstruction(const Result& result)
+{
+  return (result.instructions != 0) ? result.seconds * 1e9 / result.instructions : 0.0;
+}
+
+void WriteJSON(std::ostream& stream, const std::string& dispatch, int repeat, const std::vector<Result>& results)
+{
+  stream << std::setprecision(6) << std::fixed;
+  stream << "{\n";
+  stream << "  \"schema\": " << schemaVersion << ",\n";
+  stream << "  \"dispatch\": \"" << dispatch << "\",\n";
+  stream << "  \"repeat\": " << repeat << ",\n";
+  stream << "  \"results\": [";
+
+  for (std::size_t i = 0; i < results.size(); ++i)
+  {
+    const Result& result = results[i];
+    stream << (i == 0 ? "\n" : ",\n");
+    stream << "    {\"rom\": \"" << Escape(std::filesystem::path{result.rom}.filename().string()) << "\", "
+           << "\"cycles\": " << result.cycles << ", "
+           << "\"frames\": " << result.cycles / cyclesPerFrame << ", "
+           << "\"instructions\": " << result.instructions << ", "
+           << "\"seconds\": " << result.seconds << ", "
+           << "\"emulatedMHz\": " << EmulatedMHz(result) << ", "
+           << "\"framesPerSecond\": " << FramesPerSecond(result) << ", "
+           << "\"nsPerInstruction\": " << NanosecondsPerInstruction(result) << ", "
+           << "\"verdict\": \"" << Escape(result.verdict) << "\"}";
+  }
+
+  stream << "\n  ],\n";
+  stream << "  \"peakRssKiB\": " << PeakRSSKiB() << "\n";
+  stream << "}\n";
+}
+
+void WriteTable(std::ostream& stream, const std::vector<Result>& results)
+{
+  stream << std::left << std::setw(36) << "rom" << std::right << std::setw(8) << "frames" << std::setw(12) << "MHz"
+         << std::setw(8) << "speed" << std::setw(12) << "frames/s" << std::setw(12) << "ns/instr" << "  verdict\n";
+  stream << std::fixed;
+
+  for (const Result& result : results)
+  {
+    stream << std::left << std::setw(36) << std::filesystem::path{result.rom}.filename().string() << std::right
+           << std::setw(8) << result.cycles / cyclesPerFrame << std::setw(12) << std::setprecision(1)
+           << EmulatedMHz(result) << std::setw(7) << std::setprecision(0) << EmulatedMHz(result) / hardwareMHz << "x"
+           << std::setw(12) << std::setprecision(0) << FramesPerSecond(result) << std::setw(12)
+           << std::setprecision(2) << NanosecondsPerInstruction(result) << "  " << result.verdict << "\n";
+  }
+
+  stream << "\npeak RSS: " << PeakRSSKiB() << " KiB\n";
+}
+
+bool ParseDispatch(const std::string& name, CPU::Dispatch& dispatch)
+{
+  if (name == "table")
+  {
+    dispatch = CPU::Dispatch::Table;
+  }
+  else if (name == "threaded")
+  {
+    dispatch = CPU::Dispatch::Threaded;
+  }
+  else if (name == "blockcache")
+  {
+    dispatch = CPU::Dispatch::BlockCache;
+  }
+  else if (name == "jit")
+  {
+    dispatch = CPU::Dispatch::Jit;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+void Usage()
+{
+  std::cerr << "Usage: gbe-bench [--preset cpu_instrs|cputests|synthetic|all] [--rom-dir Dir] [--frames N | --cycles N]\n"
+               "                 [--dispatch table|threaded|blockcache|jit] [--repeat N] [--json] [PathToRom...]."
+            << std::endl;
+  std::exit(EXIT_FAILURE);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::vector<PresetROM> preset;
+  bool synthetic = false;
+  std::vector<std::string> roms;
+  std::string romDir = GBE_TEST_ROM_DIR;
+  std::uint64_t cycles = 0;
+  std::string dispatchName = "threaded";
+  int repeat = 1;
+  bool json = false;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string argument = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (argument == "--preset" && hasValue)
+    {
+      std::string name = argv[++i];
+      if (name == "cpu_instrs" || name == "all")
+      {
+        preset.insert(preset.end(), cpuInstrsPreset.begin(), cpuInstrsPreset.end());
+      }
+      if (name == "cputests" || name == "all")
+      {
+        preset.insert(preset.end(), cputestsPreset.begin(), cputestsPreset.end());
+      }
+      if (name == "synthetic" || name == "all")
+      {
+        synthetic = true;
+      }
+      if (name != "cpu_instrs" && name != "cputests" && name != "synthetic" && name != "all")
+      {
+        Usage();
+      }
+    }
+    else if (argument == "--rom-dir" && hasValue)
+    {
+      romDir = argv[++i];
+    }
+    else if (argument == "--frames" && hasValue)
+    {
+      cycles = std::stoull(argv[++i]) * cyclesPerFrame;
+    }
+    else if (argument == "--cycles" && hasValue)
+    {
+      cycles = std::stoull(argv[++i]);
+    }
+    else if (argument == "--dispatch" && hasValue)
+    {
+      dispatchName = argv[++i];
+    }
+    else if (argument == "--repeat" && hasValue)
+    {
+      repeat = std::max(1, std::stoi(argv[++i]));
+    }
+    else if (argument == "--json")
+    {
+      json = true;
+    }
+    else if (argument.rfind("--", 0) == 0)
+    {
+      Usage();
+    }
+    else
+    {
+      roms.push_back(argument);
+    }
+  }
+
+  CPU::Dispatch dispatch;
+  if (!ParseDispatch(dispatchName, dispatch) || (preset.empty() && !synthetic && roms.empty()))
+  {
+    Usage();
+  }
+
+  // Presets bring their own length, --frames and --cycles override it.
+  std::vector<Workload> workloads;
+  for (const PresetROM& rom : preset)
+  {
+    workloads.push_back({(std::filesystem::path{romDir} / rom.path).string(),
+                         (cycles != 0) ? cycles : rom.frames * cyclesPerFrame});
+  }
+  if (synthetic)
+  {
+    for (const SyntheticROM& rom : SyntheticROMs())
+    {
+      workloads.push_back({rom.name, (cycles != 0) ? cycles : syntheticFrameLimit * cyclesPerFrame, &rom});
+    }
+  }
+  for (const std::string& rom : roms)
+  {
+    workloads.push_back({rom, (cycles != 0) ? cycles : defaultFrames * cyclesPerFrame});
+  }
+
+  std::vector<Result> results;
+  // Synthetic workloads know their final state, so any run ending elsewhere fails the benchmark.
+  bool correct = true;
+  for (const Workload& workload : workloads)
+  {
+    // The fastest run is the one least disturbed by the host.
+    Result best;
+    for (int i = 0; i < repeat; ++i)
+    {
+      Result result = Run(workload, dispatch);
+      if (workload.synthetic && result.verdict != "Passed")
+      {
+        correct = false;
+      }
+      if (i == 0 || result.seconds < best.seconds)
+      {
+        best = result;
+      }
+    }
+    results.push_back(best);
+  }
+
+  if (json)
+  {
+    WriteJSON(std::cout, dispatchName, repeat, results);
+  }
+  else
+  {
+    WriteTable(std::cout, results);
+  }
+
+  return correct ? EXIT_SUCCESS : EXIT_FAILURE;
+}
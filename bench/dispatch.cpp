@@ -0,0 +1,62 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "cpu/cpu.hpp"
+#include "mmu.hpp"
+
+namespace
+{
+
+constexpr std::uint64_t defaultInstructionCount = 50'000'000;
+
+/**
+ * @brief Runs the ROM from power on for instructionCount instructions and returns emulated MIPS.
+ */
+double MeasureMIPS(const std::string& romPath, CPU::Dispatch dispatch, std::uint64_t instructionCount)
+{
+  MMU mmu;
+  mmu.LoadROM(romPath);
+
+  CPU cpu{mmu};
+  cpu.SetDispatch(dispatch);
+
+  auto start = std::chrono::steady_clock::now();
+  std::uint64_t executed = cpu.Run(instructionCount);
+  auto end = std::chrono::steady_clock::now();
+
+  std::chrono::duration<double> seconds = end - start;
+  return static_cast<double>(executed) / seconds.count() / 1e6;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc != 2 && argc != 3)
+  {
+    std::cerr << "Usage: gbe-dispatch-bench PathToRom [InstructionCount]." << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  std::string romPath = argv[1];
+  std::uint64_t instructionCount = (argc == 3) ? std::stoull(argv[2]) : defaultInstructionCount;
+
+  double tableMIPS = MeasureMIPS(romPath, CPU::Dispatch::Table, instructionCount);
+  double threadedMIPS = MeasureMIPS(romPath, CPU::Dispatch::Threaded, instructionCount);
+  double blockCacheMIPS = MeasureMIPS(romPath, CPU::Dispatch::BlockCache, instructionCount);
+  double jitMIPS = Jit::IsAvailable() ? MeasureMIPS(romPath, CPU::Dispatch::Jit, instructionCount) : 0.0;
+
+  std::cout << "\n";
+  std::cout << "table dispatch:    " << tableMIPS << " MIPS\n";
+  std::cout << "threaded dispatch: " << threadedMIPS << " MIPS (" << threadedMIPS / tableMIPS << "x)\n";
+  std::cout << "block cache:       " << blockCacheMIPS << " MIPS (" << blockCacheMIPS / tableMIPS << "x)\n";
+  if (Jit::IsAvailable())
+  {
+    std::cout << "jit:               " << jitMIPS << " MIPS (" << jitMIPS / tableMIPS << "x)\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,136 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cpu/cpu.hpp"
+#include "mmu.hpp"
+
+namespace
+{
+
+constexpr std::uint64_t defaultInstructionCount = 20'000'000;
+
+// Copies of the measured instruction between two jumps back to the start.
+constexpr int unrollCount = 256;
+
+constexpr std::size_t romSize = 0x8000;
+constexpr Address entryPoint = 0x0100;
+// After the cartridge header, which has to stay zero for a plain ROM.
+constexpr Address programStart = 0x0150;
+
+struct Benchmark
+{
+  const char* name;
+  std::vector<std::uint8_t> instruction;
+};
+
+// Flag producing instructions, plus two sequences where something reads the flags right away.
+const std::vector<Benchmark> benchmarks = {
+    {"INC B", {0x04}},
+    {"DEC B", {0x05}},
+    {"ADD A,B", {0x80}},
+    {"ADC A,B", {0x88}},
+    {"SUB A,B", {0x90}},
+    {"SBC A,B", {0x98}},
+    {"AND A,B", {0xA0}},
+    {"XOR A,B", {0xA8}},
+    {"OR A,B", {0xB0}},
+    {"CP A,B", {0xB8}},
+    {"ADD A,n8", {0xC6, 0x11}},
+    {"CP A,n8", {0xFE, 0x11}},
+    {"ADD A,B; PUSH AF; POP AF", {0x80, 0xF5, 0xF1}},
+    {"DEC B; JR NZ,+0", {0x05, 0x20, 0x00}},
+};
+
+struct Result
+{
+  double mips;
+  // The program stayed in its loop, instead of running off into whatever else the ROM holds.
+  bool ran;
+};
+
+/**
+ * @brief Runs unrolled copies of the instruction in a loop and returns emulated MIPS.
+ *
+ * ROM ignores writes, so the program goes into a cartridge image instead of through Set.
+ */
+Result MeasureMIPS(const Benchmark& benchmark, bool lazyFlags, std::uint64_t instructionCount)
+{
+  std::vector<std::uint8_t> image(romSize, 0x00);
+
+  // JP programStart
+  image[entryPoint] = 0xC3;
+  image[entryPoint + 1] = programStart & 0xFF;
+  image[entryPoint + 2] = programStart >> 8;
+
+  std::size_t address = programStart;
+  for (int i = 0; i < unrollCount; ++i)
+  {
+    for (std::uint8_t byte : benchmark.instruction)
+    {
+      image[address++] = byte;
+    }
+  }
+
+  // JP programStart
+  image[address++] = 0xC3;
+  image[address++] = programStart & 0xFF;
+  image[address++] = programStart >> 8;
+
+  MMU mmu;
+  mmu.LoadROM(image);
+
+  CPU cpu{mmu};
+  cpu.SetDispatch(CPU::Dispatch::Threaded);
+  cpu.SetLazyFlags(lazyFlags);
+
+  auto start = std::chrono::steady_clock::now();
+  std::uint64_t executed = cpu.Run(instructionCount);
+  auto end = std::chrono::steady_clock::now();
+
+  std::uint16_t pc = cpu.GetState().PC;
+  bool ran = executed == instructionCount && pc >= programStart && pc < address;
+
+  std::chrono::duration<double> seconds = end - start;
+  return {static_cast<double>(executed) / seconds.count() / 1e6, ran};
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc > 2)
+  {
+    std::cerr << "Usage: gbe-flags-bench [InstructionCount]." << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  std::uint64_t instructionCount = (argc == 2) ? std::stoull(argv[1]) : defaultInstructionCount;
+
+  std::cout << std::left << std::setw(28) << "instruction" << std::right << std::setw(12) << "eager MIPS"
+            << std::setw(12) << "lazy MIPS" << std::setw(10) << "gain" << "\n";
+  std::cout << std::fixed << std::setprecision(1);
+  bool ran = true;
+
+  for (const Benchmark& benchmark : benchmarks)
+  {
+    Result eager = MeasureMIPS(benchmark, false, instructionCount);
+    Result lazy = MeasureMIPS(benchmark, true, instructionCount);
+
+    if (!eager.ran || !lazy.ran)
+    {
+      std::cerr << "The program for " << benchmark.name << " did not run." << std::endl;
+      ran = false;
+    }
+
+    std::cout << std::left << std::setw(28) << benchmark.name << std::right << std::setw(12) << eager.mips
+              << std::setw(12) << lazy.mips << std::setw(9) << std::setprecision(2) << lazy.mips / eager.mips << "x"
+              << std::setprecision(1) << "\n";
+  }
+
+  return ran ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cpu/cpu.hpp"
+#include "mmu.hpp"
+
+namespace
+{
+
+constexpr int defaultFrameCount = 600;
+constexpr std::uint64_t cyclesPerFrame = 70224;
+
+constexpr std::size_t romSize = 0x8000;
+constexpr Address programStart = 0x0100;
+constexpr Address vblankFlag = 0xC000;
+
+// Counts B down as the frame's work, then polls a flag the VBlank "handler" sets, clears it and starts over.
+std::vector<std::uint8_t> MakeProgram(std::uint8_t workIterations)
+{
+  return {
+      0x06, workIterations,   // LD B,n8
+      0x05,                   // DEC B
+      0x20, 0xFD,             // JR NZ,-3
+      0xFA, 0x00, 0xC0,       // LD A,(C000)
+      0xA7,                   // AND A
+      0x28, 0xFA,             // JR Z,-6
+      0xAF,                   // XOR A
+      0xEA, 0x00, 0xC0,       // LD (C000),A
+      0x18, 0xEF,             // JR -17
+  };
+}
+
+struct Result
+{
+  double seconds;
+  std::uint64_t instructions;
+  std::uint64_t skippedCycles;
+  CPU::State state;
+  std::uint64_t cycles;
+  bool ran;
+};
+
+/**
+ * @brief Runs frames of the polling program, a scheduled event at the end of each frame sets the flag.
+ *
+ * ROM ignores writes, so the program goes into a cartridge image instead of through Set.
+ */
+Result RunFrames(int frameCount, std::uint8_t workIterations, bool skipping)
+{
+  std::vector<std::uint8_t> program = MakeProgram(workIterations);
+  std::vector<std::uint8_t> image(romSize, 0x00);
+  std::copy(program.begin(), program.end(), image.begin() + programStart);
+
+  MMU mmu;
+  mmu.LoadROM(image);
+  mmu.Set(vblankFlag, 0);
+
+  CPU cpu{mmu};
+  cpu.SetIdleLoopSkipping(skipping);
+
+  Scheduler& scheduler = cpu.GetScheduler();
+  Scheduler::EventId frameEnd = 0;
+  frameEnd = scheduler.Register(
+      [&](std::uint64_t cycle)
+      {
+        mmu.Set(vblankFlag, 1);
+        scheduler.Schedule(frameEnd, cycle + cyclesPerFrame);
+      });
+  scheduler.Schedule(frameEnd, cyclesPerFrame);
+
+  std::uint64_t instructions = 0;
+  std::uint64_t end = frameCount * cyclesPerFrame;
+
+  auto start = std::chrono::steady_clock::now();
+  while (cpu.GetCycles() < end)
+  {
+    cpu.Tick();
+    ++instructions;
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  // An image without the program runs off through the whole address space instead of staying in the loop.
+  CPU::State state = cpu.GetState();
+  bool ran = state.PC >= programStart && state.PC < programStart + program.size();
+
+  std::chrono::duration<double> seconds = stop - start;
+  return {seconds.count(), instructions, cpu.GetIdleCyclesSkipped(), state, cpu.GetCycles(), ran};
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc > 2)
+  {
+    std::cerr << "Usage: gbe-idle-bench [FrameCount]." << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  int frameCount = (argc == 2) ? std::stoi(argv[1]) : defaultFrameCount;
+  bool identical = true;
+
+  std::cout << std::left << std::setw(8) << "work" << std::right << std::setw(16) << "idle cyc/frame"
+            << std::setw(16) << "skipped/frame" << std::setw(12) << "off fps" << std::setw(12) << "on fps"
+            << std::setw(10) << "gain" << "\n";
+  std::cout << std::fixed << std::setprecision(1);
+
+  for (int workIterations : {1, 64, 255})
+  {
+    Result off = RunFrames(frameCount, workIterations, false);
+    Result on = RunFrames(frameCount, workIterations, true);
+
+    // The skipping run has to skip something, the idle part of every frame is well above one loop iteration.
+    if (!off.ran || !on.ran || on.skippedCycles == 0)
+    {
+      std::cerr << "The program for " << workIterations << " work iterations did not run." << std::endl;
+      identical = false;
+    }
+
+    // Skipping must not change anything the program can observe.
+    if (on.state != off.state || on.cycles != off.cycles)
+    {
+      std::cerr << "State differs with idle loop skipping for " << workIterations << " work iterations."
+                << std::endl;
+      identical = false;
+    }
+
+    // DEC B; JR NZ takes 16 cycles per iteration, 12 on the last one.
+    std::uint64_t workCycles = 8 + 16 * workIterations - 4;
+    double offFps = frameCount / off.seconds;
+    double onFps = frameCount / on.seconds;
+
+    std::cout << std::left << std::setw(8) << workIterations << std::right << std::setw(16)
+              << cyclesPerFrame - workCycles << std::setw(16) << on.skippedCycles / frameCount << std::setw(12)
+              << offFps << std::setw(12) << onFps << std::setw(9) << std::setprecision(2) << onFps / offFps << "x"
+              << std::setprecision(1) << "\n";
+  }
+
+  return identical ? EXIT_SUCCESS : EXIT_FAILURE;
+}
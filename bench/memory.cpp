@@ -0,0 +1,189 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+#include "cpu/cpu.hpp"
+#include "mmu.hpp"
+
+namespace
+{
+
+constexpr std::size_t defaultInstanceCount = 1000;
+
+std::size_t allocationCount = 0;
+std::size_t allocatedBytes = 0;
+
+struct HeapUsage
+{
+  std::size_t allocations;
+  std::size_t bytes;
+};
+
+HeapUsage CurrentHeapUsage()
+{
+  return {allocationCount, allocatedBytes};
+}
+
+HeapUsage operator-(const HeapUsage& lhs, const HeapUsage& rhs)
+{
+  return {lhs.allocations - rhs.allocations, lhs.bytes - rhs.bytes};
+}
+
+void* Allocate(std::size_t size, std::size_t alignment = 0)
+{
+  ++allocationCount;
+  allocatedBytes += size;
+
+  if (size == 0)
+  {
+    size = 1;
+  }
+#if defined(_WIN32)
+  void* pointer = (alignment != 0) ? _aligned_malloc(size, alignment) : std::malloc(size);
+#else
+  // aligned_alloc wants a whole number of alignments.
+  void* pointer = (alignment != 0) ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+                                   : std::malloc(size);
+#endif
+  if (!pointer)
+  {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void Free(void* pointer, [[maybe_unused]] bool aligned = false)
+{
+#if defined(_WIN32)
+  if (aligned)
+  {
+    _aligned_free(pointer);
+    return;
+  }
+#endif
+  std::free(pointer);
+}
+
+} // namespace
+
+// Counts every heap allocation of the process, frees are not subtracted so the numbers are what construction cost.
+// Every form of new and delete is replaced so each pointer is freed by the allocator that returned it.
+void* operator new(std::size_t size)
+{
+  return Allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+  return Allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  return Allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+  return Allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept
+{
+  Free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+  Free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+  Free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+  Free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+  Free(pointer, true);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+  Free(pointer, true);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+  Free(pointer, true);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept
+{
+  Free(pointer, true);
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 2)
+  {
+    std::cerr << "Usage: gbe-memory-report [InstanceCount]." << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  std::size_t instanceCount = (argc == 2) ? std::stoull(argv[1]) : defaultInstanceCount;
+  if (instanceCount < 1)
+  {
+    std::cerr << "InstanceCount must be at least 1." << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  MMU mmu;
+
+  // Every instance shares the MMU, only what the CPU itself costs is counted.
+  std::vector<std::unique_ptr<CPU>> cpus;
+  cpus.reserve(instanceCount);
+
+  HeapUsage before = CurrentHeapUsage();
+  for (std::size_t i = 0; i < instanceCount; ++i)
+  {
+    cpus.push_back(std::make_unique<CPU>(mmu));
+  }
+  HeapUsage constructed = CurrentHeapUsage() - before;
+
+  std::size_t objectBytes = sizeof(CPU);
+  std::size_t heapAllocations = constructed.allocations / instanceCount - 1;
+  std::size_t heapBytes = constructed.bytes / instanceCount - objectBytes;
+  std::size_t instanceBytes = objectBytes + heapBytes;
+
+  std::cout << std::left << std::setw(36) << "instances" << instanceCount << "\n";
+  std::cout << std::setw(36) << "sizeof(CPU)" << objectBytes << " B\n";
+  std::cout << std::setw(36) << "heap allocations per instance" << heapAllocations << "\n";
+  std::cout << std::setw(36) << "heap bytes per instance" << heapBytes << " B\n";
+  std::cout << std::setw(36) << "total per instance" << instanceBytes << " B\n";
+  std::cout << std::setw(36) << "total for all instances" << std::fixed << std::setprecision(1)
+            << static_cast<double>(instanceBytes * instanceCount) / (1024.0 * 1024.0) << " MiB\n";
+  std::cout << std::setw(36) << "shared opcode metadata"
+            << sizeof(CPU::opcodeTable) + sizeof(CPU::extendedOpcodeTable) << " B ("
+            << sizeof(CPU::OpcodeDescription) << " B per opcode)\n";
+  // Only heap memory is counted above. The JIT maps its code outside the heap, once a CPU compiles its first block.
+  std::cout << std::setw(36) << "JIT code mapping, not counted" << Jit::codeCapacity / 1024
+            << " KiB per instance that compiled a block\n";
+
+  return 0;
+}
@@ -0,0 +1,236 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "scheduler.hpp"
+
+namespace
+{
+
+constexpr int defaultOperationCount = 1000000;
+
+// Fixed seed, so every run schedules the same cycles.
+class Random
+{
+public:
+  std::uint32_t Next()
+  {
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    return static_cast<std::uint32_t>(state >> 33);
+  }
+
+private:
+  std::uint64_t state = 0x2545F4914F6CDD1Dull;
+};
+
+double NanosecondsPer(std::chrono::steady_clock::duration duration, int operationCount)
+{
+  return std::chrono::duration<double, std::nano>(duration).count() / operationCount;
+}
+
+struct Timings
+{
+  double schedule;
+  double cancel;
+  double dispatch;
+};
+
+/**
+ * @brief Times rescheduling, cancelling and dispatching with eventCount events registered.
+ */
+Timings Measure(int eventCount, int operationCount)
+{
+  Scheduler scheduler;
+  std::uint64_t now = 0;
+  std::uint64_t handled = 0;
+
+  std::vector<Scheduler::EventId> ids;
+  for (int i = 0; i < eventCount; ++i)
+  {
+    // Every dispatched event comes back its own period later, like a periodic device would.
+    ids.push_back(scheduler.Register(
+        [&, i, period = 64 + 16 * static_cast<std::uint64_t>(i)](std::uint64_t cycle)
+        {
+          ++handled;
+          scheduler.Schedule(ids[i], cycle + period);
+        }));
+  }
+
+  Random random;
+  Timings timings{};
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < operationCount; ++i)
+  {
+    scheduler.Schedule(ids[i % eventCount], now + random.Next() % 4096);
+  }
+  timings.schedule = NanosecondsPer(std::chrono::steady_clock::now() - start, operationCount);
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < operationCount; ++i)
+  {
+    Scheduler::EventId id = ids[i % eventCount];
+    scheduler.Cancel(id);
+    scheduler.Schedule(id, now + random.Next() % 4096);
+  }
+  // Cancelling is only half of each iteration, take off what a schedule costs on its own.
+  timings.cancel = NanosecondsPer(std::chrono::steady_clock::now() - start, operationCount) - timings.schedule;
+
+  start = std::chrono::steady_clock::now();
+  while (handled < static_cast<std::uint64_t>(operationCount))
+  {
+    now = scheduler.NextCycle();
+    scheduler.RunDue(now);
+  }
+  timings.dispatch = NanosecondsPer(std::chrono::steady_clock::now() - start, operationCount);
+
+  return timings;
+}
+
+struct Dispatch
+{
+  Scheduler::EventId id;
+  std::uint64_t cycle;
+};
+
+/**
+ * @brief Schedules a fixed pattern with many ties, cancellations and handlers that reschedule, returns the order.
+ */
+std::vector<Dispatch> RecordDispatchOrder()
+{
+  constexpr int eventCount = 32;
+  constexpr std::uint64_t end = 100000;
+
+  Scheduler scheduler;
+  std::vector<Dispatch> order;
+  std::vector<Scheduler::EventId> ids;
+  Random random;
+
+  for (int i = 0; i < eventCount; ++i)
+  {
+    ids.push_back(scheduler.Register(
+        [&, i](std::uint64_t cycle)
+        {
+          order.push_back({ids[i], cycle});
+
+          // Coarse steps, so plenty of events land on the same cycle.
+          std::uint32_t value = random.Next();
+          scheduler.Schedule(ids[i], cycle + 8 * (value % 4));
+          if (value % 7 == 0)
+          {
+            scheduler.Cancel(ids[(i + 1) % eventCount]);
+          }
+          if (value % 5 == 0)
+          {
+            scheduler.Schedule(ids[(i + 3) % eventCount], cycle);
+          }
+        }));
+  }
+
+  for (Scheduler::EventId id : ids)
+  {
+    scheduler.Schedule(id, 8 * (random.Next() % 16));
+  }
+
+  std::uint64_t now = 0;
+  while (now < end && scheduler.NextCycle() != Scheduler::never)
+  {
+    // Step in uneven increments, so several cycles worth of events become due at once.
+    now += 1 + random.Next() % 40;
+    scheduler.RunDue(now);
+  }
+
+  return order;
+}
+
+/**
+ * @brief Checks that two identical runs dispatch identically and never go back in time.
+ */
+bool OrderIsDeterministic()
+{
+  std::vector<Dispatch> first = RecordDispatchOrder();
+  std::vector<Dispatch> second = RecordDispatchOrder();
+
+  if (first.size() != second.size())
+  {
+    std::cerr << "Runs dispatched " << first.size() << " and " << second.size() << " events." << std::endl;
+    return false;
+  }
+
+  for (std::size_t i = 0; i < first.size(); ++i)
+  {
+    if (first[i].id != second[i].id || first[i].cycle != second[i].cycle)
+    {
+      std::cerr << "Runs differ at dispatch " << i << "." << std::endl;
+      return false;
+    }
+    if (i > 0 && first[i].cycle < first[i - 1].cycle)
+    {
+      std::cerr << "Dispatch " << i << " runs before its predecessor." << std::endl;
+      return false;
+    }
+  }
+
+  return !first.empty();
+}
+
+/**
+ * @brief Checks that events due on the same cycle run in the order they were scheduled.
+ */
+bool TiesRunInScheduleOrder()
+{
+  Scheduler scheduler;
+  std::vector<Scheduler::EventId> order;
+
+  std::vector<Scheduler::EventId> ids;
+  for (int i = 0; i < 8; ++i)
+  {
+    ids.push_back(scheduler.Register([&order, i](std::uint64_t) { order.push_back(i); }));
+  }
+
+  // Scheduled backwards, and rescheduling 5 moves it to the end of its cycle.
+  std::vector<Scheduler::EventId> expected{7, 6, 4, 3, 2, 1, 0, 5};
+  for (int i = 7; i >= 0; --i)
+  {
+    scheduler.Schedule(ids[i], 100);
+  }
+  scheduler.Schedule(ids[5], 100);
+
+  scheduler.RunDue(100);
+  return order == expected;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc > 2)
+  {
+    std::cerr << "Usage: gbe-scheduler-bench [OperationCount]." << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  int operationCount = (argc == 2) ? std::stoi(argv[1]) : defaultOperationCount;
+
+  bool deterministic = OrderIsDeterministic();
+  bool ties = TiesRunInScheduleOrder();
+  std::cout << "Dispatch order deterministic: " << (deterministic ? "yes" : "NO") << "\n";
+  std::cout << "Ties run in schedule order:   " << (ties ? "yes" : "NO") << "\n\n";
+
+  std::cout << std::left << std::setw(8) << "events" << std::right << std::setw(16) << "schedule ns"
+            << std::setw(16) << "cancel ns" << std::setw(16) << "dispatch ns" << "\n";
+  std::cout << std::fixed << std::setprecision(1);
+
+  for (int eventCount : {4, 16, 64})
+  {
+    Timings timings = Measure(eventCount, operationCount);
+    std::cout << std::left << std::setw(8) << eventCount << std::right << std::setw(16) << timings.schedule
+              << std::setw(16) << timings.cancel << std::setw(16) << timings.dispatch << "\n";
+  }
+
+  return (deterministic && ties) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
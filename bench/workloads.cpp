@@ -0,0 +1,601 @@
+#include "workloads.hpp"
+
+#include <initializer_list>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+
+constexpr std::size_t romSize = 0x8000;
+constexpr std::size_t romBankSize = 0x4000;
+constexpr std::uint16_t entryPoint = 0x0100;
+constexpr std::uint16_t codeStart = 0x0150;
+
+// HRAM byte the workloads count their outer repetitions in.
+constexpr std::uint8_t repetitionCounter = 0x80;
+
+/**
+ * @brief Just enough of an assembler to write the workloads as commented bytes with labelled branches.
+ *
+ * Positions are offsets into the image, which only equal addresses in the first two banks. Code placed in a later
+ * bank can branch relative but not jump to a label.
+ */
+class Assembler
+{
+  struct Fixup
+  {
+    std::size_t position;
+    std::string label;
+    bool relative;
+  };
+
+  std::vector<std::uint8_t> image;
+  std::size_t position = 0;
+  std::map<std::string, std::size_t> labels;
+  std::vector<Fixup> fixups;
+
+public:
+  explicit Assembler(std::size_t size = romSize) : image(size, 0x00) {}
+
+  void Org(std::size_t offset) { position = offset; }
+
+  /**
+   * @brief Continues at the address as seen while the bank is switched in at $4000.
+   */
+  void Org(std::size_t bank, std::uint16_t address) { position = bank * romBankSize + (address - romBankSize); }
+
+  void Emit(std::initializer_list<std::uint8_t> bytes)
+  {
+    for (std::uint8_t byte : bytes)
+    {
+      image.at(position++) = byte;
+    }
+  }
+
+  void Label(const std::string& name) { labels[name] = position; }
+
+  /**
+   * @brief JR with the given opcode (0x18, or 0x20/0x28/0x30/0x38 for NZ/Z/NC/C) to a label.
+   */
+  void JR(std::uint8_t opcode, const std::string& label)
+  {
+    Emit({opcode, 0x00});
+    fixups.push_back({position - 1, label, true});
+  }
+
+  void JP(const std::string& label)
+  {
+    Emit({0xC3, 0x00, 0x00});
+    fixups.push_back({position - 2, label, false});
+  }
+
+  std::vector<std::uint8_t> Build()
+  {
+    for (const Fixup& fixup : fixups)
+    {
+      auto label = labels.find(fixup.label);
+      if (label == labels.end())
+      {
+        throw std::runtime_error{"Unknown label " + fixup.label + "."};
+      }
+
+      if (fixup.relative)
+      {
+        int offset = static_cast<int>(label->second) - static_cast<int>(fixup.position + 1);
+        if (offset < -128 || offset > 127)
+        {
+          throw std::runtime_error{"Branch to " + fixup.label + " out of range."};
+        }
+        image[fixup.position] = static_cast<std::uint8_t>(offset);
+      }
+      else
+      {
+        image[fixup.position] = static_cast<std::uint8_t>(label->second & 0xFF);
+        image[fixup.position + 1] = static_cast<std::uint8_t>(label->second >> 8);
+      }
+    }
+    return image;
+  }
+};
+
+/**
+ * @brief Jumps from the entry point to the code, moves the stack to HRAM and clears IE and IF.
+ */
+void Prologue(Assembler& rom)
+{
+  rom.Org(entryPoint);
+  rom.Emit({0x00});
+  rom.JP("start");
+
+  rom.Org(codeStart);
+  rom.Label("start");
+  rom.Emit({0x31, 0xFE, 0xFF}); // LD SP,$FFFE
+  rom.Emit({0xAF});             // XOR A
+  rom.Emit({0xE0, 0xFF});       // LDH ($FF),A
+  rom.Emit({0xE0, 0x0F});       // LDH ($0F),A
+}
+
+/**
+ * @brief Halts with IME and IE clear, which nothing can wake.
+ */
+void Finish(Assembler& rom)
+{
+  rom.Emit({0xF3}); // DI
+  rom.Emit({0x76}); // HALT
+}
+
+/**
+ * @brief B, D and E count 256 * 256 * repetitions iterations of the body, which may use A, C, H and L.
+ */
+template <typename Body> void NestedLoop(Assembler& rom, std::uint8_t repetitions, Body body)
+{
+  rom.Emit({0x06, repetitions}); // LD B,repetitions
+  rom.Label("repeat");
+  rom.Emit({0x16, 0x00}); // LD D,0
+  rom.Label("outer");
+  rom.Emit({0x1E, 0x00}); // LD E,0
+  rom.Label("inner");
+  body();
+  rom.Emit({0x1D}); // DEC E
+  rom.JR(0x20, "inner");
+  rom.Emit({0x15}); // DEC D
+  rom.JR(0x20, "outer");
+  rom.Emit({0x05}); // DEC B
+  rom.JR(0x20, "repeat");
+}
+
+/**
+ * @brief Counts the outer repetitions in HRAM, for bodies that need every register.
+ */
+void StartRepetitions(Assembler& rom, std::uint8_t repetitions)
+{
+  rom.Emit({0x3E, repetitions});       // LD A,repetitions
+  rom.Emit({0xE0, repetitionCounter}); // LDH (counter),A
+  rom.Label("repeat");
+}
+
+void EndRepetitions(Assembler& rom)
+{
+  rom.Emit({0xF0, repetitionCounter}); // LDH A,(counter)
+  rom.Emit({0x3D});                    // DEC A
+  rom.Emit({0xE0, repetitionCounter}); // LDH (counter),A
+  rom.JR(0x20, "repeat");
+}
+
+/**
+ * @brief 8-bit arithmetic and logic with every flag consumer, CP and DAA right after the ops that set them.
+ */
+std::vector<std::uint8_t> AluROM()
+{
+  Assembler rom;
+  Prologue(rom);
+
+  NestedLoop(rom, 16, [&] {
+    rom.Emit({0x81});       // ADD A,C
+    rom.Emit({0x8D});       // ADC A,L
+    rom.Emit({0xAC});       // XOR H
+    rom.Emit({0x95});       // SUB L
+    rom.Emit({0x0C});       // INC C
+    rom.Emit({0x99});       // SBC A,C
+    rom.Emit({0xE6, 0xF7}); // AND $F7
+    rom.Emit({0xB4});       // OR H
+    rom.Emit({0xFE, 0x55}); // CP $55
+    rom.Emit({0x27});       // DAA
+    rom.Emit({0xC6, 0x13}); // ADD A,$13
+    rom.Emit({0x2C});       // INC L
+    rom.Emit({0x25});       // DEC H
+    rom.Emit({0x8C});       // ADC A,H
+  });
+
+  Finish(rom);
+  return rom.Build();
+}
+
+/**
+ * @brief Prefixed rotates, shifts and bit ops on registers and on (HL), which walks through $C000-$C0FF.
+ */
+std::vector<std::uint8_t> BitOpsROM()
+{
+  Assembler rom;
+  Prologue(rom);
+  rom.Emit({0x21, 0x00, 0xC0}); // LD HL,$C000
+
+  NestedLoop(rom, 8, [&] {
+    rom.Emit({0xCB, 0x01}); // RLC C
+    rom.Emit({0xCB, 0x1D}); // RR L
+    rom.Emit({0xCB, 0x37}); // SWAP A
+    rom.Emit({0xCB, 0x5C}); // BIT 3,H
+    rom.Emit({0xCB, 0xE9}); // SET 5,C
+    rom.Emit({0xCB, 0x97}); // RES 2,A
+    rom.Emit({0xCB, 0x06}); // RLC (HL)
+    rom.Emit({0xCB, 0x2F}); // SRA A
+    rom.Emit({0xCB, 0x25}); // SLA L
+    rom.Emit({0xCB, 0x39}); // SRL C
+    rom.Emit({0xCB, 0x17}); // RL A
+    rom.Emit({0xCB, 0x36}); // SWAP (HL)
+    rom.Emit({0xCB, 0x46}); // BIT 0,(HL)
+    rom.Emit({0xCB, 0xFE}); // SET 7,(HL)
+    rom.Emit({0xCB, 0x8E}); // RES 1,(HL)
+    rom.Emit({0x2C});       // INC L
+    rom.Emit({0x81});       // ADD A,C
+  });
+
+  Finish(rom);
+  return rom.Build();
+}
+
+/**
+ * @brief Copies 4 KiB from ROM to $C000, then adds it onto $D000, 200 times.
+ */
+std::vector<std::uint8_t> MemoryCopyROM()
+{
+  Assembler rom;
+
+  rom.Org(0x1000);
+  for (int i = 0; i < 0x1000; ++i)
+  {
+    rom.Emit({static_cast<std::uint8_t>((i * 7 + 3) ^ (i >> 8))});
+  }
+
+  Prologue(rom);
+  StartRepetitions(rom, 200);
+
+  rom.Emit({0x21, 0x00, 0x10}); // LD HL,$1000
+  rom.Emit({0x11, 0x00, 0xC0}); // LD DE,$C000
+  rom.Emit({0x01, 0x00, 0x10}); // LD BC,$1000
+  rom.Label("copy");
+  rom.Emit({0x2A}); // LD A,(HL+)
+  rom.Emit({0x12}); // LD (DE),A
+  rom.Emit({0x13}); // INC DE
+  rom.Emit({0x0B}); // DEC BC
+  rom.Emit({0x78}); // LD A,B
+  rom.Emit({0xB1}); // OR C
+  rom.JR(0x20, "copy");
+
+  rom.Emit({0x21, 0x00, 0xC0}); // LD HL,$C000
+  rom.Emit({0x11, 0x00, 0xD0}); // LD DE,$D000
+  rom.Emit({0x01, 0x00, 0x10}); // LD BC,$1000
+  rom.Label("add");
+  rom.Emit({0x1A}); // LD A,(DE)
+  rom.Emit({0x86}); // ADD A,(HL)
+  rom.Emit({0x12}); // LD (DE),A
+  rom.Emit({0x23}); // INC HL
+  rom.Emit({0x13}); // INC DE
+  rom.Emit({0x0B}); // DEC BC
+  rom.Emit({0x78}); // LD A,B
+  rom.Emit({0xB1}); // OR C
+  rom.JR(0x20, "add");
+
+  EndRepetitions(rom);
+  Finish(rom);
+  return rom.Build();
+}
+
+/**
+ * @brief Requests the timer interrupt from software 320000 times, its handler counts them in BC.
+ */
+std::vector<std::uint8_t> InterruptROM()
+{
+  Assembler rom;
+
+  rom.Org(0x0050);
+  rom.Emit({0x03}); // INC BC
+  rom.Emit({0xD9}); // RETI
+
+  Prologue(rom);
+  rom.Emit({0x3E, 0x04});       // LD A,$04
+  rom.Emit({0xE0, 0xFF});       // LDH ($FF),A
+  rom.Emit({0x01, 0x00, 0x00}); // LD BC,0
+  rom.Emit({0xFB});             // EI
+  StartRepetitions(rom, 8);
+
+  rom.Emit({0x21, 0x40, 0x9C}); // LD HL,40000
+  rom.Label("request");
+  rom.Emit({0x3E, 0x04}); // LD A,$04
+  rom.Emit({0xE0, 0x0F}); // LDH ($0F),A
+  rom.Emit({0x2B});       // DEC HL
+  rom.Emit({0x7C});       // LD A,H
+  rom.Emit({0xB5});       // OR L
+  rom.JR(0x20, "request");
+
+  EndRepetitions(rom);
+  rom.Emit({0xF3});       // DI
+  rom.Emit({0xAF});       // XOR A
+  rom.Emit({0xE0, 0xFF}); // LDH ($FF),A
+  Finish(rom);
+  return rom.Build();
+}
+
+/**
+ * @brief Fills tile data, the first tile map and OAM with the LCD on, 256 times with a different seed.
+ *
+ * The headless core has no PPU, so these are plain writes. Once VRAM and OAM get locked during rendering, the
+ * expected state changes with it.
+ */
+std::vector<std::uint8_t> VideoMemoryROM()
+{
+  Assembler rom;
+  Prologue(rom);
+  rom.Emit({0x3E, 0x91}); // LD A,$91
+  rom.Emit({0xE0, 0x40}); // LDH ($40),A
+  StartRepetitions(rom, 0);
+
+  rom.Emit({0x4F});             // LD C,A
+  rom.Emit({0x5F});             // LD E,A
+  rom.Emit({0x21, 0x00, 0x80}); // LD HL,$8000
+  rom.Label("tiles");
+  rom.Emit({0x7B}); // LD A,E
+  for (int i = 0; i < 4; ++i)
+  {
+    rom.Emit({0x22}); // LD (HL+),A
+    rom.Emit({0x81}); // ADD A,C
+  }
+  rom.Emit({0x5F});       // LD E,A
+  rom.Emit({0x7C});       // LD A,H
+  rom.Emit({0xFE, 0x98}); // CP $98
+  rom.JR(0x20, "tiles");
+
+  rom.Label("map");
+  rom.Emit({0x7D});       // LD A,L
+  rom.Emit({0xA9});       // XOR C
+  rom.Emit({0x22});       // LD (HL+),A
+  rom.Emit({0x7C});       // LD A,H
+  rom.Emit({0xFE, 0x9C}); // CP $9C
+  rom.JR(0x20, "map");
+
+  rom.Emit({0x21, 0x00, 0xFE}); // LD HL,$FE00
+  rom.Label("oam");
+  rom.Emit({0x7D});       // LD A,L
+  rom.Emit({0x81});       // ADD A,C
+  rom.Emit({0x22});       // LD (HL+),A
+  rom.Emit({0x7D});       // LD A,L
+  rom.Emit({0xFE, 0xA0}); // CP $A0
+  rom.JR(0x20, "oam");
+
+  EndRepetitions(rom);
+  Finish(rom);
+  return rom.Build();
+}
+
+/**
+ * @brief Starts a serial transfer and halts until its interrupt, 16384 times, so nearly all time is spent asleep.
+ */
+std::vector<std::uint8_t> HaltROM()
+{
+  Assembler rom;
+
+  rom.Org(0x0058);
+  rom.Emit({0x03}); // INC BC
+  rom.Emit({0xD9}); // RETI
+
+  Prologue(rom);
+  rom.Emit({0x3E, 0x08});       // LD A,$08
+  rom.Emit({0xE0, 0xFF});       // LDH ($FF),A
+  rom.Emit({0x01, 0x00, 0x00}); // LD BC,0
+  rom.Emit({0x21, 0x00, 0x40}); // LD HL,$4000
+  rom.Emit({0xFB});             // EI
+
+  rom.Label("transfer");
+  rom.Emit({0x7D});       // LD A,L
+  rom.Emit({0xE0, 0x01}); // LDH ($01),A
+  rom.Emit({0x3E, 0x81}); // LD A,$81
+  rom.Emit({0xE0, 0x02}); // LDH ($02),A
+  rom.Emit({0x76});       // HALT
+  rom.Emit({0x2B});       // DEC HL
+  rom.Emit({0x7C});       // LD A,H
+  rom.Emit({0xB5});       // OR L
+  rom.JR(0x20, "transfer");
+
+  rom.Emit({0xF3});       // DI
+  rom.Emit({0xAF});       // XOR A
+  rom.Emit({0xE0, 0xFF}); // LDH ($FF),A
+  Finish(rom);
+  return rom.Build();
+}
+
+/**
+ * @brief Calls a routine in each of ROM banks 1-15 of an MBC5 cartridge 50000 times, switching the RAM bank along.
+ *
+ * Every routine adds the marker at the end of its bank to DE and counts its calls in the RAM bank it runs with, so a
+ * wrong mapping shows in the final state. 983040 ROM bank and as many RAM bank switches in all.
+ */
+std::vector<std::uint8_t> BankingROM()
+{
+  constexpr std::size_t banks = 16;
+  Assembler rom{banks * romBankSize};
+
+  for (std::size_t bank = 1; bank < banks; ++bank)
+  {
+    auto marker = static_cast<std::uint8_t>(bank);
+
+    rom.Org(bank, 0x4000);
+    rom.Emit({0xFA, 0xFF, 0x7F});   // LD A,($7FFF)
+    rom.Emit({0x83});               // ADD A,E
+    rom.Emit({0x5F});               // LD E,A
+    rom.Emit({0x30, 0x01});         // JR NC,+1
+    rom.Emit({0x14});               // INC D
+    rom.Emit({0x21, marker, 0xA0}); // LD HL,$A000+bank
+    rom.Emit({0x34});               // INC (HL)
+    rom.Emit({0xC9});               // RET
+
+    rom.Org(bank, 0x7FFF);
+    rom.Emit({marker});
+  }
+
+  // MBC5 with RAM, 256 KiB ROM and 32 KiB RAM.
+  rom.Org(0x0147);
+  rom.Emit({0x1A, 0x03, 0x03});
+
+  Prologue(rom);
+  rom.Emit({0x3E, 0x0A});       // LD A,$0A
+  rom.Emit({0xEA, 0x00, 0x00}); // LD ($0000),A
+  rom.Emit({0x11, 0x00, 0x00}); // LD DE,0
+  StartRepetitions(rom, 200);
+
+  rom.Emit({0x06, 0xFA}); // LD B,250
+  rom.Label("switch");
+  rom.Emit({0x0E, 0x01}); // LD C,1
+  rom.Label("bank");
+  rom.Emit({0x79});             // LD A,C
+  rom.Emit({0xEA, 0x00, 0x20}); // LD ($2000),A
+  rom.Emit({0xE6, 0x03});       // AND $03
+  rom.Emit({0xEA, 0x00, 0x40}); // LD ($4000),A
+  rom.Emit({0xCD, 0x00, 0x40}); // CALL $4000
+  rom.Emit({0x0C});             // INC C
+  rom.Emit({0x79});             // LD A,C
+  rom.Emit({0xFE, 0x10});       // CP $10
+  rom.JR(0x20, "bank");
+  rom.Emit({0x05}); // DEC B
+  rom.JR(0x20, "switch");
+
+  EndRepetitions(rom);
+  rom.Emit({0xAF});             // XOR A
+  rom.Emit({0xEA, 0x00, 0x40}); // LD ($4000),A
+  Finish(rom);
+  return rom.Build();
+}
+
+/**
+ * @brief Adds each byte's address to it across all of the 8 KiB RAM of a cartridge without a controller, 64 times.
+ *
+ * Such RAM has no enable register and the write to $0000 must not turn it off, else it reads back 0xFF.
+ */
+std::vector<std::uint8_t> ROMRAMROM()
+{
+  Assembler rom;
+
+  // ROM+RAM+BATTERY, 32 KiB ROM and 8 KiB RAM.
+  rom.Org(0x0147);
+  rom.Emit({0x09, 0x00, 0x02});
+
+  Prologue(rom);
+  rom.Emit({0xEA, 0x00, 0x00}); // LD ($0000),A
+  StartRepetitions(rom, 64);
+
+  rom.Emit({0x21, 0x00, 0xA0}); // LD HL,$A000
+  rom.Label("add");
+  rom.Emit({0x7E});       // LD A,(HL)
+  rom.Emit({0x85});       // ADD A,L
+  rom.Emit({0x84});       // ADD A,H
+  rom.Emit({0x22});       // LD (HL+),A
+  rom.Emit({0x7C});       // LD A,H
+  rom.Emit({0xFE, 0xC0}); // CP $C0
+  rom.JR(0x20, "add");
+
+  EndRepetitions(rom);
+  Finish(rom);
+  return rom.Build();
+}
+
+/**
+ * @brief Runs into an invalid opcode with a serial interrupt on its way, which must not wake the locked up CPU.
+ *
+ * Until the CPU modelled the lock up, PC stayed on the opcode without time passing and no batch ever ended.
+ */
+std::vector<std::uint8_t> LockUpROM()
+{
+  Assembler rom;
+
+  rom.Org(0x0058);
+  rom.Emit({0x03}); // INC BC
+  rom.Emit({0xD9}); // RETI
+
+  Prologue(rom);
+  rom.Emit({0x01, 0x00, 0x00}); // LD BC,0
+  rom.Emit({0x3E, 0x08});       // LD A,$08
+  rom.Emit({0xE0, 0xFF});       // LDH ($FF),A
+  rom.Emit({0x3E, 0x81});       // LD A,$81
+  rom.Emit({0xE0, 0x02});       // LDH ($02),A
+  rom.Emit({0xFB});             // EI
+  rom.Emit({0x00});             // NOP
+  rom.Emit({0xD3});             // invalid
+  rom.Emit({0x04});             // INC B
+  Finish(rom);
+  return rom.Build();
+}
+
+std::string Hex(unsigned value, int width)
+{
+  std::ostringstream text;
+  text << std::hex << std::uppercase << std::setfill('0') << std::setw(width) << value;
+  return text.str();
+}
+
+std::string Describe(const CPU::State& state)
+{
+  return "A=" + Hex(state.A, 2) + " F=" + Hex(state.F, 2) + " B=" + Hex(state.B, 2) + " C=" + Hex(state.C, 2) +
+         " D=" + Hex(state.D, 2) + " E=" + Hex(state.E, 2) + " H=" + Hex(state.H, 2) + " L=" + Hex(state.L, 2) +
+         " SP=" + Hex(state.SP, 4) + " PC=" + Hex(state.PC, 4) + " IME=" + (state.IME ? "1" : "0") +
+         " halted=" + (state.halted ? "1" : "0");
+}
+
+} // namespace
+
+std::uint64_t Checksum(const MMU& mmu, const std::vector<std::pair<Address, Address>>& ranges)
+{
+  // FNV-1a
+  std::uint64_t hash = 0xCBF29CE484222325;
+  for (const auto& [first, last] : ranges)
+  {
+    for (int address = first; address <= last; ++address)
+    {
+      hash = (hash ^ mmu.Peek(static_cast<Address>(address))) * 0x100000001B3;
+    }
+  }
+  return hash;
+}
+
+std::string SyntheticROM::Mismatch(const CPU& cpu, const MMU& mmu) const
+{
+  std::string mismatch;
+
+  CPU::State state = cpu.GetState();
+  if (state != expected)
+  {
+    mismatch += "expected " + Describe(expected) + ", got " + Describe(state) + ". ";
+  }
+
+  std::uint64_t checksum = Checksum(mmu, checksumRanges);
+  if (checksum != expectedChecksum)
+  {
+    mismatch += "expected checksum " + Hex(static_cast<unsigned>(expectedChecksum >> 32), 8) +
+                Hex(static_cast<unsigned>(expectedChecksum), 8) + ", got " +
+                Hex(static_cast<unsigned>(checksum >> 32), 8) + Hex(static_cast<unsigned>(checksum), 8) + ".";
+  }
+
+  return mismatch;
+}
+
+const std::vector<SyntheticROM>& SyntheticROMs()
+{
+  // State order: A, F, B, C, D, E, H, L, SP, PC, IME, halted.
+  static const std::vector<SyntheticROM> roms = {
+      {"alu", "8-bit ALU ops and DAA", AluROM(),
+       {0x00, 0xD0, 0x00, 0x13, 0x00, 0x00, 0x01, 0x4D, 0xFFFE, 0x017A, false, true}, {}, 0xCBF29CE484222325},
+      {"bitops", "CB prefixed ops on registers and (HL)", BitOpsROM(),
+       {0x43, 0xC0, 0x00, 0x13, 0x00, 0x00, 0xC0, 0x01, 0xFFFE, 0x018C, false, true}, {{0xC000, 0xC0FF}},
+       0x1A51329EE0349A4A},
+      {"memcopy", "4 KiB copy and add loops", MemoryCopyROM(),
+       {0x00, 0xC0, 0x00, 0x00, 0xE0, 0x00, 0xD0, 0x00, 0xFFFE, 0x0189, false, true}, {{0xC000, 0xDFFF}},
+       0x11372FBEBECAB125},
+      {"interrupts", "software requested interrupts", InterruptROM(),
+       {0x00, 0x80, 0xE2, 0x00, 0x00, 0xD8, 0x00, 0x00, 0xFFFE, 0x017D, false, true}, {}, 0xCBF29CE484222325},
+      {"video", "VRAM and OAM fills with the LCD on", VideoMemoryROM(),
+       {0x00, 0xC0, 0x00, 0x01, 0x00, 0x01, 0xFE, 0xA0, 0xFFFE, 0x0190, false, true},
+       {{0x8000, 0x9BFF}, {0xFE00, 0xFE9F}}, 0xE16AAB90329A8E45},
+      {"halt", "HALT until the serial interrupt", HaltROM(),
+       {0x00, 0x80, 0x40, 0x00, 0x00, 0xD8, 0x00, 0x00, 0xFFFE, 0x0176, false, true}, {}, 0xCBF29CE484222325},
+      {"banking", "MBC5 ROM and RAM bank switches", BankingROM(),
+       {0x00, 0x80, 0x00, 0x10, 0x8D, 0x80, 0xA0, 0x0F, 0xFFFE, 0x018A, false, true}, {{0xA000, 0xA0FF}},
+       0xC42945F628CA02D5},
+      {"romram", "RAM of a cartridge without a controller", ROMRAMROM(),
+       {0x00, 0xC0, 0x00, 0x13, 0x00, 0xD8, 0xC0, 0x00, 0xFFFE, 0x0174, false, true}, {{0xA000, 0xBFFF}},
+       0x2A56479BEFBDC325},
+      {"lockup", "invalid opcode with an interrupt pending", LockUpROM(),
+       {0x81, 0x80, 0x00, 0x00, 0x00, 0xD8, 0x01, 0x4D, 0xFFFE, 0x0165, true, true}, {{0xFF0F, 0xFF0F}}, 0xAF64654C8602D557},
+  };
+  return roms;
+}
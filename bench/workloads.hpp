@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cpu/cpu.hpp"
+#include "mmu.hpp"
+
+/**
+ * @brief A generated ROM that stresses one part of the emulator and ends in a known state.
+ *
+ * Every workload runs from power on until it halts for good with interrupts off. Its registers and a checksum over
+ * the memory it wrote must then match, so a benchmark run also checks that the fast path still computes the same.
+ */
+struct SyntheticROM
+{
+  std::string name;
+  std::string description;
+  std::vector<std::uint8_t> image;
+
+  CPU::State expected;
+  std::vector<std::pair<Address, Address>> checksumRanges;
+  std::uint64_t expectedChecksum;
+
+  /**
+   * @brief Empty if the final state matches, otherwise what differs.
+   */
+  [[nodiscard]] std::string Mismatch(const CPU& cpu, const MMU& mmu) const;
+};
+
+std::uint64_t Checksum(const MMU& mmu, const std::vector<std::pair<Address, Address>>& ranges);
+
+/**
+ * @brief All synthetic workloads, assembled on first use.
+ */
+const std::vector<SyntheticROM>& SyntheticROMs();
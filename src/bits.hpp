@@ -18,4 +18,21 @@ template <typename T> bool GetBit(T value, int n)
   return (value >> n) & 1;
 }
 
+/**
+ * @brief Position of the lowest set bit, value must not be 0.
+ */
+inline int CountTrailingZeros(unsigned int value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctz(value);
+#else
+  int n = 0;
+  while (!GetBit(value, n))
+  {
+    ++n;
+  }
+  return n;
+#endif
+}
+
 } // namespace bits
\ No newline at end of file
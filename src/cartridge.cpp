@@ -0,0 +1,389 @@
+#include "cartridge.hpp"
+
+#include <filesystem>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+namespace
+{
+
+constexpr std::size_t mbc2RAMSize = 512;
+
+std::size_t RAMSizeFromHeader(std::uint8_t code)
+{
+  switch (code)
+  {
+  case 0x01:
+    return 0x800;
+  case 0x02:
+    return 0x2000;
+  case 0x03:
+    return 0x8000;
+  case 0x04:
+    return 0x20000;
+  case 0x05:
+    return 0x10000;
+  default:
+    return 0;
+  }
+}
+
+} // namespace
+
+Cartridge::Cartridge()
+{
+  UseROMCopy();
+}
+
+Cartridge::Cartridge(std::vector<std::uint8_t> image) : romCopy(std::move(image))
+{
+  std::size_t size = romCopy.size();
+  UseROMCopy();
+  ReadHeader(size);
+}
+
+/**
+ * @brief Runs ROM straight from the mapping, unless the file is not a whole number of banks and has to be padded.
+ */
+Cartridge::Cartridge(MappedFile file) : romFile(std::move(file))
+{
+  std::size_t size = romFile.GetSize();
+  if (size >= 2 * romBankSize && size % romBankSize == 0)
+  {
+    rom = romFile.GetData();
+    romBanks = size / romBankSize;
+  }
+  else
+  {
+    romCopy.assign(romFile.GetData(), romFile.GetData() + size);
+    romFile = MappedFile{};
+    UseROMCopy();
+  }
+  ReadHeader(size);
+}
+
+/**
+ * @brief Pads the copy to whole banks, at least two, bank numbers past the end wrap like the missing address lines do.
+ */
+void Cartridge::UseROMCopy()
+{
+  romBanks = std::max<std::size_t>(2, (romCopy.size() + romBankSize - 1) / romBankSize);
+  romCopy.resize(romBanks * romBankSize, 0xFF);
+  rom = romCopy.data();
+}
+
+/**
+ * @brief Detects the controller from the cartridge type at $0147 and sizes RAM from $0149.
+ *
+ * An image too short for a header is plain ROM.
+ */
+void Cartridge::ReadHeader(std::size_t imageSize)
+{
+  std::uint8_t type = (imageSize > typeAddress) ? rom[typeAddress] : 0x00;
+  std::uint8_t ramSizeCode = (imageSize > ramSizeAddress) ? rom[ramSizeAddress] : 0x00;
+  bool hasRAM = false;
+
+  switch (type)
+  {
+  case 0x00:
+    break;
+  case 0x08:
+  case 0x09:
+    hasRAM = true;
+    battery = (type == 0x09);
+    break;
+  case 0x01:
+  case 0x02:
+  case 0x03:
+    controller = Controller::MBC1;
+    hasRAM = (type != 0x01);
+    battery = (type == 0x03);
+    break;
+  case 0x05:
+  case 0x06:
+    controller = Controller::MBC2;
+    battery = (type == 0x06);
+    break;
+  case 0x0F:
+  case 0x10:
+  case 0x11:
+  case 0x12:
+  case 0x13:
+    controller = Controller::MBC3;
+    hasRAM = (type == 0x10 || type == 0x12 || type == 0x13);
+    battery = (type == 0x0F || type == 0x10 || type == 0x13);
+    clock = (type == 0x0F || type == 0x10);
+    break;
+  case 0x19:
+  case 0x1A:
+  case 0x1B:
+  case 0x1C:
+  case 0x1D:
+  case 0x1E:
+    controller = Controller::MBC5;
+    hasRAM = (type == 0x1A || type == 0x1B || type == 0x1D || type == 0x1E);
+    battery = (type == 0x1B || type == 0x1E);
+    break;
+  default:
+    throw std::runtime_error{"Unsupported cartridge type."};
+  }
+
+  if (controller == Controller::MBC2)
+  {
+    ramCopy.assign(mbc2RAMSize, 0xFF);
+  }
+  else if (hasRAM)
+  {
+    ramCopy.assign(RAMSizeFromHeader(ramSizeCode), 0xFF);
+  }
+  ram = ramCopy.data();
+  ramSize = ramCopy.size();
+  // Without a controller there is no register to enable RAM with, it is always on.
+  ramEnabled = (controller == Controller::None && ramSize != 0);
+
+  UpdateBanks();
+}
+
+/**
+ * @brief Handles a write to $0000-$7FFF, returns whether the banks mapped into memory changed.
+ */
+bool Cartridge::Control(std::uint16_t address, std::uint8_t value)
+{
+  auto mapping = [this] {
+    return std::make_tuple(lowROMBank, highROMBank, ramBank, ramEnabled, IsClockSelected());
+  };
+  auto before = mapping();
+
+  switch (controller)
+  {
+  case Controller::None:
+    return false;
+
+  case Controller::MBC1:
+    if (address < 0x2000)
+    {
+      ramEnabled = (value & 0x0F) == 0x0A;
+    }
+    else if (address < 0x4000)
+    {
+      romBankRegister = value & 0x1F;
+    }
+    else if (address < 0x6000)
+    {
+      upperRegister = value & 0x03;
+    }
+    else
+    {
+      advancedBanking = value & 0x01;
+    }
+    break;
+
+  case Controller::MBC2:
+    // Address bit 8 tells the two registers apart, both live in $0000-$3FFF.
+    if (address < 0x4000)
+    {
+      if (address & 0x0100)
+      {
+        romBankRegister = value & 0x0F;
+      }
+      else
+      {
+        ramEnabled = (value & 0x0F) == 0x0A;
+      }
+    }
+    break;
+
+  case Controller::MBC3:
+    if (address < 0x2000)
+    {
+      ramEnabled = (value & 0x0F) == 0x0A;
+    }
+    else if (address < 0x4000)
+    {
+      romBankRegister = value & 0x7F;
+    }
+    else if (address < 0x6000)
+    {
+      upperRegister = value;
+    }
+    else
+    {
+      if (lastLatchWrite == 0x00 && value == 0x01)
+      {
+        latchedClock = clockRegisters;
+      }
+      lastLatchWrite = value;
+    }
+    break;
+
+  case Controller::MBC5:
+    if (address < 0x2000)
+    {
+      ramEnabled = (value & 0x0F) == 0x0A;
+    }
+    else if (address < 0x3000)
+    {
+      romBankRegister = static_cast<std::uint16_t>((romBankRegister & 0x100) | value);
+    }
+    else if (address < 0x4000)
+    {
+      romBankRegister = static_cast<std::uint16_t>((romBankRegister & 0xFF) | ((value & 0x01) << 8));
+    }
+    else if (address < 0x6000)
+    {
+      upperRegister = value & 0x0F;
+    }
+    break;
+  }
+
+  UpdateBanks();
+  return mapping() != before;
+}
+
+void Cartridge::UpdateBanks()
+{
+  std::size_t low = 0;
+  std::size_t high = 1;
+  std::size_t ramSelected = 0;
+
+  switch (controller)
+  {
+  case Controller::None:
+    break;
+
+  case Controller::MBC1:
+  {
+    // Bank 0 cannot be selected for $4000, which also turns $20, $40 and $60 into the bank after them.
+    std::size_t lowBits = (romBankRegister == 0) ? 1 : romBankRegister;
+    high = (static_cast<std::size_t>(upperRegister) << 5) | lowBits;
+    low = advancedBanking ? (static_cast<std::size_t>(upperRegister) << 5) : 0;
+    ramSelected = advancedBanking ? upperRegister : 0;
+    break;
+  }
+
+  case Controller::MBC2:
+    high = (romBankRegister == 0) ? 1 : romBankRegister;
+    break;
+
+  case Controller::MBC3:
+    high = (romBankRegister == 0) ? 1 : romBankRegister;
+    ramSelected = upperRegister & 0x03;
+    break;
+
+  case Controller::MBC5:
+    high = romBankRegister;
+    ramSelected = upperRegister;
+    break;
+  }
+
+  lowROMBank = static_cast<std::uint16_t>(low % romBanks);
+  highROMBank = static_cast<std::uint16_t>(high % romBanks);
+  ramBank = static_cast<std::uint16_t>(ramSelected);
+}
+
+/**
+ * @brief The .sav file next to the ROM, which may not exist yet.
+ */
+std::string Cartridge::SavePathForROM(const std::string& romPath)
+{
+  return std::filesystem::path{romPath}.replace_extension(".sav").string();
+}
+
+/**
+ * @brief Backs battery powered RAM with the save file from now on, returns false for cartridges without one.
+ *
+ * RAM then is the file mapped into memory, so writes cost no I/O until FlushSave. A missing or short save is
+ * created or extended with 0xFF, longer ones keep their extra bytes. Instances loading the same save share it.
+ */
+bool Cartridge::LoadSave(const std::string& savePath)
+{
+  if (!battery || ramSize == 0)
+  {
+    return false;
+  }
+
+  saveFile = MappedFile{savePath, MappedFile::Mode::ReadWrite, ramSize, 0xFF};
+  ram = saveFile.GetWritableData();
+  ramCopy.clear();
+  ramCopy.shrink_to_fit();
+  return true;
+}
+
+/**
+ * @brief Writes RAM changed since the last flush to the save file, if there is one.
+ */
+void Cartridge::FlushSave()
+{
+  saveFile.Flush();
+}
+
+bool Cartridge::IsClockSelected() const
+{
+  return controller == Controller::MBC3 && upperRegister >= firstClockRegister;
+}
+
+std::size_t Cartridge::RAMOffset(std::size_t offset) const
+{
+  return (ramBank * ramBankSize + offset) % ramSize;
+}
+
+std::uint8_t* Cartridge::GetRAMBank()
+{
+  if (!ramEnabled || ramSize == 0 || controller == Controller::MBC2 || IsClockSelected())
+  {
+    return nullptr;
+  }
+  return &ram[RAMOffset(0)];
+}
+
+std::uint8_t Cartridge::ReadRAM(std::uint16_t address) const
+{
+  std::size_t offset = address - 0xA000;
+
+  if (!ramEnabled)
+  {
+    return 0xFF;
+  }
+  if (controller == Controller::MBC2)
+  {
+    // 512 half bytes, repeated through the whole area. The upper half reads as set.
+    return 0xF0 | ram[offset % mbc2RAMSize];
+  }
+  if (IsClockSelected())
+  {
+    std::size_t index = upperRegister - firstClockRegister;
+    return (index < latchedClock.size()) ? latchedClock[index] : 0xFF;
+  }
+  if (ramSize == 0)
+  {
+    return 0xFF;
+  }
+  return ram[RAMOffset(offset)];
+}
+
+void Cartridge::WriteRAM(std::uint16_t address, std::uint8_t value)
+{
+  std::size_t offset = address - 0xA000;
+
+  if (!ramEnabled)
+  {
+    return;
+  }
+  if (controller == Controller::MBC2)
+  {
+    ram[offset % mbc2RAMSize] = value & 0x0F;
+  }
+  else if (IsClockSelected())
+  {
+    std::size_t index = upperRegister - firstClockRegister;
+    if (index < clockRegisters.size())
+    {
+      clockRegisters[index] = value;
+    }
+  }
+  else if (ramSize != 0)
+  {
+    ram[RAMOffset(offset)] = value;
+  }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mappedfile.hpp"
+
+/**
+ * @brief ROM, external RAM and memory bank controller of a cartridge, as its header describes them.
+ *
+ * The MMU maps the banks selected here into its page table. Writes to $0000-$7FFF go to Control, which says whether
+ * the mapping changed. MBC2 RAM and the MBC3 clock registers are not plain memory, while one of them or disabled RAM
+ * is selected GetRAMBank returns null and accesses go through ReadRAM and WriteRAM.
+ *
+ * ROM loaded from a file stays a read-only mapping of it, so instances running the same ROM share its memory.
+ */
+class Cartridge
+{
+public:
+  enum class Controller
+  {
+    None,
+    MBC1,
+    MBC2,
+    MBC3,
+    MBC5
+  };
+
+  static constexpr std::size_t romBankSize = 0x4000;
+  static constexpr std::size_t ramBankSize = 0x2000;
+
+  static constexpr std::uint16_t typeAddress = 0x0147;
+  static constexpr std::uint16_t ramSizeAddress = 0x0149;
+
+  /**
+   * @brief No cartridge inserted, 32 KiB of ROM reading 0xFF.
+   */
+  Cartridge();
+  explicit Cartridge(std::vector<std::uint8_t> image);
+  explicit Cartridge(MappedFile file);
+
+  [[nodiscard]] Controller GetController() const { return controller; }
+  [[nodiscard]] bool HasBattery() const { return battery; }
+  [[nodiscard]] bool HasClock() const { return clock; }
+  [[nodiscard]] std::size_t GetROMBankCount() const { return romBanks; }
+  [[nodiscard]] std::size_t GetRAMSize() const { return ramSize; }
+
+  static std::string SavePathForROM(const std::string& romPath);
+  bool LoadSave(const std::string& savePath);
+  void FlushSave();
+
+  bool Control(std::uint16_t address, std::uint8_t value);
+
+  [[nodiscard]] std::uint16_t GetLowROMBank() const { return lowROMBank; }
+  [[nodiscard]] std::uint16_t GetHighROMBank() const { return highROMBank; }
+  [[nodiscard]] std::uint16_t GetRAMBank() const { return ramBank; }
+
+  [[nodiscard]] const std::uint8_t* GetROMBank(std::uint16_t bank) const { return rom + bank * romBankSize; }
+
+  /**
+   * @brief Start of the selected RAM bank, null unless that is enabled plain memory.
+   *
+   * Banks smaller than $A000-$BFFF repeat through it, GetRAMBankSize says after how many bytes.
+   */
+  std::uint8_t* GetRAMBank();
+  [[nodiscard]] std::size_t GetRAMBankSize() const { return std::min(ramSize, ramBankSize); }
+
+  [[nodiscard]] std::uint8_t ReadRAM(std::uint16_t address) const;
+  void WriteRAM(std::uint16_t address, std::uint8_t value);
+
+private:
+  // ROM is either the mapped file or, for images built in memory or not a whole number of banks, a padded copy.
+  MappedFile romFile;
+  std::vector<std::uint8_t> romCopy;
+  const std::uint8_t* rom = nullptr;
+  std::size_t romBanks = 0;
+  // RAM lives in memory of its own or, with a battery and a save loaded, in the mapped save file.
+  std::vector<std::uint8_t> ramCopy;
+  MappedFile saveFile;
+  std::uint8_t* ram = nullptr;
+  std::size_t ramSize = 0;
+
+  Controller controller = Controller::None;
+  bool battery = false;
+  bool clock = false;
+
+  // Controller registers as last written.
+  bool ramEnabled = false;
+  std::uint16_t romBankRegister = 1;
+  // MBC1 upper bank bits, MBC3 RAM bank or clock register, MBC5 RAM bank.
+  std::uint8_t upperRegister = 0;
+  // MBC1 mode 1, the upper bits also select the bank at $0000 and the RAM bank.
+  bool advancedBanking = false;
+
+  // Banks the registers select, already wrapped to what the cartridge has.
+  std::uint16_t lowROMBank = 0;
+  std::uint16_t highROMBank = 1;
+  std::uint16_t ramBank = 0;
+
+  // MBC3 seconds, minutes, hours, day low and day high, and the copy latched for reading. The clock does not advance
+  // on its own yet.
+  static constexpr std::uint8_t firstClockRegister = 0x08;
+  std::array<std::uint8_t, 5> clockRegisters{};
+  std::array<std::uint8_t, 5> latchedClock{};
+  std::uint8_t lastLatchWrite = 0xFF;
+
+  void UseROMCopy();
+  void ReadHeader(std::size_t imageSize);
+  void UpdateBanks();
+  [[nodiscard]] bool IsClockSelected() const;
+  [[nodiscard]] std::size_t RAMOffset(std::size_t offset) const;
+};
@@ -0,0 +1,138 @@
+#include "blockcache.hpp"
+
+#include <algorithm>
+
+#include "../mmu.hpp"
+
+BlockCache::BlockCache(MMU& mmu) : mmu(mmu)
+{
+  mmu.SetCodeWriteHandler([this](Address address) { Invalidate(address); });
+}
+
+BlockCache::Block*& BlockCache::Slot(std::uint16_t bank, std::uint16_t address)
+{
+  if (bank >= banks.size())
+  {
+    banks.resize(bank + 1);
+  }
+  if (!banks[bank])
+  {
+    banks[bank] = std::make_unique<BankPages>();
+  }
+
+  std::unique_ptr<PageBlocks>& page = (*banks[bank])[address >> 8];
+  if (!page)
+  {
+    page = std::make_unique<PageBlocks>();
+  }
+  return (*page)[address & 0xFF];
+}
+
+BlockCache::Block& BlockCache::Insert(Block block)
+{
+  Block* stored = nullptr;
+  if (freeBlocks.empty())
+  {
+    stored = &storage.emplace_back(std::move(block));
+  }
+  else
+  {
+    stored = freeBlocks.back();
+    freeBlocks.pop_back();
+    *stored = std::move(block);
+  }
+
+  Slot(stored->bank, stored->startAddress) = stored;
+
+  int firstPage = stored->startAddress >> 8;
+  int lastPage = static_cast<std::uint16_t>(stored->endAddress - 1) >> 8;
+
+  if (!pageBlocks)
+  {
+    pageBlocks = std::make_unique<std::array<std::vector<Block*>, pageCount>>();
+  }
+
+  for (int page = firstPage; page <= lastPage; ++page)
+  {
+    (*pageBlocks)[page].push_back(stored);
+    mmu.WatchCodePage(page, true);
+  }
+
+  return *stored;
+}
+
+/**
+ * @brief Called on writes into a watched page, drops every block decoded from it.
+ *
+ * A dropped block is also taken off the lists of the other pages it covers, so those never reach it again once its
+ * storage is reused, and pages left without blocks stop being watched.
+ */
+void BlockCache::Invalidate(std::uint16_t address)
+{
+  int page = address >> 8;
+  if (!pageBlocks)
+  {
+    return;
+  }
+
+  for (Block* block : (*pageBlocks)[page])
+  {
+    block->valid = false;
+    Block*& slot = Slot(block->bank, block->startAddress);
+    if (slot == block)
+    {
+      slot = nullptr;
+    }
+    staleBlocks.push_back(block);
+
+    int firstPage = block->startAddress >> 8;
+    int lastPage = static_cast<std::uint16_t>(block->endAddress - 1) >> 8;
+    for (int other = firstPage; other <= lastPage; ++other)
+    {
+      if (other != page)
+      {
+        Unlist(other, block);
+      }
+    }
+  }
+
+  (*pageBlocks)[page].clear();
+  mmu.WatchCodePage(page, false);
+}
+
+void BlockCache::Unlist(int page, const Block* block)
+{
+  std::vector<Block*>& blocks = (*pageBlocks)[page];
+  blocks.erase(std::remove(blocks.begin(), blocks.end(), block), blocks.end());
+  if (blocks.empty())
+  {
+    mmu.WatchCodePage(page, false);
+  }
+}
+
+void BlockCache::Clear()
+{
+  pageBlocks.reset();
+  for (int page = 0; page < pageCount; ++page)
+  {
+    mmu.WatchCodePage(page, false);
+  }
+
+  banks.clear();
+  storage.clear();
+  freeBlocks.clear();
+  staleBlocks.clear();
+}
+
+void BlockCache::RecycleStaleBlocks()
+{
+  for (Block* block : staleBlocks)
+  {
+    block->instructions.clear();
+    block->successors = {};
+    block->native = nullptr;
+    freeBlocks.push_back(block);
+  }
+
+  staleBlocks.clear();
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+class CPU;
+class MMU;
+
+/**
+ * @brief Pre-decoded straight-line runs of opcodes, looked up directly by bank and start address.
+ *
+ * Every page holding cached code is watched by the MMU, a write into it drops all blocks decoded from that page.
+ */
+class BlockCache
+{
+public:
+  // Runs one decoded instruction, its operand already latched.
+  using Executor = void (*)(CPU& cpu);
+
+  struct Instruction
+  {
+    Executor execute;
+    std::uint16_t address;
+    // Immediate of the instruction, the second opcode byte of CB prefixed ones.
+    std::uint16_t operand;
+    std::uint8_t opcode;
+    std::uint8_t length;
+    bool extended;
+  };
+
+  // Native code emitted by the JIT for a block, returns the number of instructions it executed and their cycles.
+  using NativeCode = std::uint32_t (*)(void* registers, void* context);
+
+  struct Block
+  {
+    std::uint16_t bank = 0;
+    std::uint16_t startAddress = 0;
+    std::uint16_t endAddress = 0;
+    bool valid = true;
+    std::vector<Instruction> instructions;
+
+    // The blocks execution last continued with, only followed once their address and bank are checked against PC.
+    std::array<Block*, 2> successors{};
+
+    std::uint32_t executionCount = 0;
+    NativeCode native = nullptr;
+    std::size_t nativeLength = 0;
+    // Cycles of the longest path through the native code.
+    std::uint64_t nativeCycles = 0;
+    // Cycles of a pass through the native code that goes back to its start, 0 if it never does.
+    std::uint64_t loopCycles = 0;
+
+    [[nodiscard]] bool Starts(std::uint16_t address, std::uint16_t addressBank) const
+    {
+      return valid && startAddress == address && bank == addressBank;
+    }
+  };
+
+  static constexpr std::size_t maxBlockLength = 64;
+
+  explicit BlockCache(MMU& mmu);
+
+  BlockCache(const BlockCache&) = delete;
+  BlockCache& operator=(const BlockCache&) = delete;
+
+  Block* Find(std::uint16_t bank, std::uint16_t address)
+  {
+    if (!staleBlocks.empty())
+    {
+      RecycleStaleBlocks();
+    }
+
+    if (bank < banks.size() && banks[bank])
+    {
+      if (const std::unique_ptr<PageBlocks>& page = (*banks[bank])[address >> 8])
+      {
+        return (*page)[address & 0xFF];
+      }
+    }
+    return nullptr;
+  }
+
+  Block& Insert(Block block);
+  void Invalidate(std::uint16_t address);
+  void Clear();
+
+  [[nodiscard]] std::size_t Size() const { return storage.size() - freeBlocks.size() - staleBlocks.size(); }
+
+private:
+  static constexpr int pageCount = 256;
+
+  MMU& mmu;
+
+  // Block starting at each address of a page, tables of a bank and its pages are allocated with their first block.
+  using PageBlocks = std::array<Block*, 256>;
+  using BankPages = std::array<std::unique_ptr<PageBlocks>, pageCount>;
+  std::vector<std::unique_ptr<BankPages>> banks;
+
+  // Blocks never move, so lookups and successors can point at them. Dropped ones are reused by later inserts.
+  std::deque<Block> storage;
+  std::vector<Block*> freeBlocks;
+
+  // Blocks decoded from each page of the address space whatever bank it maps, allocated with the first block so
+  // table dispatch never pays for it.
+  std::unique_ptr<std::array<std::vector<Block*>, pageCount>> pageBlocks;
+
+  // Invalidated blocks may still be executing, so they are only reused after the next lookup.
+  std::vector<Block*> staleBlocks;
+
+  Block*& Slot(std::uint16_t bank, std::uint16_t address);
+  void Unlist(int page, const Block* block);
+  void RecycleStaleBlocks();
+};
@@ -1,10 +1,12 @@
 #include "cpu.hpp"
 
-#include <fstream>
+#include <algorithm>
+#include <limits>
 
 #include "../mmu.hpp"
 #include "../logger.hpp"
 #include "../bits.hpp"
+#include "opcodetimings.hpp"
 
 /**
  * @brief Clears first three bits as they are always 0.
@@ -21,12 +23,12 @@ bool CPU::IsInterruptEnabled(int interruptBitpos)
 
 void CPU::EnableInterrupt(int interruptBitpos)
 {
-  bits::SetBit(GetIE(), interruptBitpos);
+  SetIE(bits::SetBit(GetIE(), interruptBitpos));
 }
 
 void CPU::DisableInterrupt(int interruptBitpos)
 {
-  bits::ClearBit(GetIE(), interruptBitpos);
+  SetIE(bits::ClearBit(GetIE(), interruptBitpos));
 }
 
 bool CPU::IsInterruptPending(int interruptBitpos)
@@ -36,22 +38,22 @@ bool CPU::IsInterruptPending(int interruptBitpos)
 
 void CPU::RequestInterrupt(int interruptBitpos)
 {
-  bits::SetBit(GetIF(), interruptBitpos);
+  SetIF(bits::SetBit(GetIF(), interruptBitpos));
 }
 
 void CPU::ResetInterrupt(int interruptBitpos)
 {
-  bits::ClearBit(GetIF(), interruptBitpos);
+  SetIF(bits::ClearBit(GetIF(), interruptBitpos));
 }
 
 std::uint8_t CPU::GetIF()
 {
-  return mmu.Get(interrupts::IF_ADDRESS);
+  return interruptFlags;
 }
 
 std::uint8_t CPU::GetIE()
 {
-  return mmu.Get(interrupts::IE_ADDRESS);
+  return interruptEnable;
 }
 
 void CPU::SetIF(const std::uint8_t value)
@@ -65,127 +67,299 @@ void CPU::SetIE(const std::uint8_t value)
 }
 
 /**
- * @brief Sets IME after after trigger and one opcode was executed.
+ * @brief Mirrors IE and IF from the MMU and follows every write to them, whoever makes it.
  */
-void CPU::HandleIMESetting()
+void CPU::AttachInterruptRegisters()
 {
-  if (setIMEAfterNextInstruction)
-  {
-    registers.IME = true;
-  }
+  interruptEnable = mmu.Get(interrupts::IE_ADDRESS);
+  interruptFlags = mmu.Get(interrupts::IF_ADDRESS);
+  UpdateInterruptsDue();
+
+  mmu.SetIOWriteHandler<&CPU::WriteInterruptEnable>(interrupts::IE_ADDRESS, *this);
+  mmu.SetIOWriteHandler<&CPU::WriteInterruptFlags>(interrupts::IF_ADDRESS, *this);
+}
+
+void CPU::WriteInterruptEnable(std::uint8_t value)
+{
+  interruptEnable = value;
+  UpdateInterruptsDue();
+}
+
+void CPU::WriteInterruptFlags(std::uint8_t value)
+{
+  interruptFlags = value;
+  UpdateInterruptsDue();
+}
+
+/**
+ * @brief Forwards accesses to watched addresses to the debug handler.
+ */
+void CPU::AttachWatchpoints()
+{
+  mmu.SetWatchHandler([this](Address address, std::uint8_t value, bool write) {
+    Debug(write ? DebugHit::Kind::Write : DebugHit::Kind::Read, address, value);
+  });
 }
 
-void CPU::HandleInterrupts()
+/**
+ * @brief Recomputes interruptsDue, called whenever IE, IF, IME or a pending EI change.
+ */
+void CPU::UpdateInterruptsDue()
 {
-  HandleIMESetting();
+  interruptsDue = (registers.IME ? PendingInterrupts() : 0) | (imeEnableDelay ? imeEnableDue : 0);
+}
 
-  if (!registers.IME)
+/**
+ * @brief Runs at every instruction boundary, returns the cycles an interrupt dispatch took.
+ */
+int CPU::HandleInterrupts()
+{
+  if (!interruptsDue)
   {
-    return;
+    return 0;
   }
 
-  if (!(GetIE() & GetIF()))
+  return DispatchInterrupts();
+}
+
+/**
+ * @brief Lets a pending EI take effect and dispatches the highest priority interrupt that is enabled and requested.
+ */
+int CPU::DispatchInterrupts()
+{
+  if (imeEnableDelay && --imeEnableDelay == 0)
   {
-    return;
+    registers.IME = true;
   }
 
-  if (IsInterruptEnabled(interrupts::bitpos::VBLANK) && IsInterruptPending(interrupts::bitpos::VBLANK))
-  {
-    PUSH_N16(registers.PC);
-    registers.PC = interrupts::vectorAddress::VBLANK;
+  std::uint8_t pending = registers.IME ? PendingInterrupts() : 0;
 
-    ResetInterrupt(interrupts::bitpos::VBLANK);
-    registers.IME = false;
-  }
-  else if (IsInterruptEnabled(interrupts::bitpos::LCD) && IsInterruptPending(interrupts::bitpos::LCD))
+  if (!pending)
   {
-    PUSH_N16(registers.PC);
-    registers.PC = interrupts::vectorAddress::LCD;
-
-    ResetInterrupt(interrupts::bitpos::LCD);
-    registers.IME = false;
+    UpdateInterruptsDue();
+    return 0;
   }
-  else if (IsInterruptEnabled(interrupts::bitpos::TIMER) && IsInterruptPending(interrupts::bitpos::TIMER))
-  {
-    PUSH_N16(registers.PC);
-    registers.PC = interrupts::vectorAddress::TIMER;
 
-    ResetInterrupt(interrupts::bitpos::TIMER);
-    registers.IME = false;
-  }
-  else if (IsInterruptEnabled(interrupts::bitpos::SERIAL) && IsInterruptPending(interrupts::bitpos::SERIAL))
+  // Lower bits have priority, their vectors follow each other 8 bytes apart.
+  int interruptBitpos = bits::CountTrailingZeros(pending);
+
+  PUSH_N16(registers.PC);
+  registers.PC = interrupts::vectorAddress::VBLANK + 8 * interruptBitpos;
+  if (sampler)
   {
-    PUSH_N16(registers.PC);
-    registers.PC = interrupts::vectorAddress::SERIAL;
+    sampler->OnCall(mmu.GetBank(registers.PC), registers.PC, registers.SP);
+  }
 
-    ResetInterrupt(interrupts::bitpos::SERIAL);
-    registers.IME = false;
+  registers.IME = false;
+  ResetInterrupt(interruptBitpos);
+  halted = false;
+
+  cycleCount += interrupts::DISPATCH_CYCLES;
+  return interrupts::DISPATCH_CYCLES;
+}
+
+/**
+ * @brief Latches the operand bytes of the current instruction and moves PC past it.
+ *
+ * Handlers always run with PC already pointing at the next instruction, so jumps simply overwrite it.
+ */
+template <int Length> void CPU::FetchOperand()
+{
+  if constexpr (Length == 2)
+  {
+    operand = mmu.Get(registers.PC + 1);
   }
-  else if (IsInterruptEnabled(interrupts::bitpos::JOYPAD) && IsInterruptPending(interrupts::bitpos::JOYPAD))
+  else if constexpr (Length == 3)
   {
-    PUSH_N16(registers.PC);
-    registers.PC = interrupts::vectorAddress::JOYPAD;
+    operand = mmu.Get16(registers.PC + 1);
+  }
+
+  registers.PC += Length;
+}
 
-    ResetInterrupt(interrupts::bitpos::JOYPAD);
-    registers.IME = false;
+void CPU::FetchOperand(int length)
+{
+  switch (length)
+  {
+  case 1:
+    FetchOperand<1>();
+    break;
+  case 2:
+    FetchOperand<2>();
+    break;
+  case 3:
+    FetchOperand<3>();
+    break;
+  default:
+    // Invalid opcodes lock up the CPU, PC stays where it is.
+    break;
   }
 }
 
-void CPU::ExecuteOpcode(std::uint8_t opcode)
+/**
+ * @brief Cycles the instruction that just ran took, conditional ones report whether their branch was taken.
+ */
+int CPU::CyclesOf(const OpcodeDescription& description) const
 {
-  const OpcodeDescription& opcodeDescription = opcodeTable[opcode];
+  return (description.cyclesNotTaken != 0 && !branchTaken) ? description.cyclesNotTaken : description.cycles;
+}
 
-  (this->*opcodeTable[opcode].opcode)();
+/**
+ * @brief Starts profiling the instruction about to execute, the returned time is only set for sampled ones.
+ */
+std::uint64_t CPU::ProfileBegin()
+{
+  if constexpr (Profiler::compiledIn)
+  {
+    return profiler->Begin();
+  }
+  return 0;
+}
 
-  if (!jumped)
+void CPU::ProfileEnd(bool extended, std::uint8_t opcode, std::uint64_t start)
+{
+  if constexpr (Profiler::compiledIn)
   {
-    registers.PC += opcodeTable[opcode].length;
+    const OpcodeDescription& description = extended ? extendedOpcodeTable[opcode] : opcodeTable[opcode];
+    profiler->End(extended, opcode, CyclesOf(description), description.cyclesNotTaken != 0, branchTaken, start);
   }
+}
+
+int CPU::ExecuteOpcode(std::uint8_t opcode)
+{
+  const OpcodeDescription& opcodeDescription = opcodeTable[opcode];
+  std::uint64_t profileStart = ProfileBegin();
+
+  FetchOperand(opcodeDescription.length);
+  opcodeDescription.opcode(*this);
 
-  jumped = false;
+  ProfileEnd(false, opcode, profileStart);
+  return CyclesOf(opcodeDescription);
 }
 
-void CPU::ExecuteExtendedOpcode(std::uint8_t opcode)
+int CPU::ExecuteExtendedOpcode(std::uint8_t opcode)
 {
   const OpcodeDescription& opcodeDescription = extendedOpcodeTable[opcode];
+  std::uint64_t profileStart = ProfileBegin();
+
+  FetchOperand(opcodeDescription.length);
+  opcodeDescription.opcode(*this);
+
+  ProfileEnd(true, opcode, profileStart);
+  return CyclesOf(opcodeDescription);
+}
 
-  (this->*extendedOpcodeTable[opcode].opcode)();
+void CPU::Halt()
+{
+  halted = true;
+}
 
-  if (!jumped)
+/**
+ * @brief Leaves HALT once an enabled interrupt is requested, dispatching it when IME is set.
+ *
+ * Without a request the clock jumps straight to the next scheduled event, nothing before it can wake the CPU. A
+ * locked CPU never wakes, it just lets time pass that way.
+ */
+bool CPU::WakeFromHalt()
+{
+  if (locked || !PendingInterrupts())
   {
-    registers.PC += extendedOpcodeTable[opcode].length;
+    if (scheduler.NextCycle() != Scheduler::never && scheduler.NextCycle() > cycleCount)
+    {
+      cycleCount = scheduler.NextCycle();
+    }
+    return false;
   }
 
-  jumped = false;
+  halted = false;
+  cycleCount += 4;
+  HandleInterrupts();
+
+  return true;
 }
 
-void CPU::Halt()
+/**
+ * @brief Runs the instruction after a bugged HALT, its first byte is read twice because PC fails to increment.
+ */
+void CPU::ExecuteHaltBug()
 {
-  halted = true;
+  std::uint8_t opcode = mmu.Get(registers.PC);
+  registers.PC -= 1;
+
+  if (opcode == 0x76)
+  {
+    // A second HALT hits the bug again on every attempt, the CPU never gets past it.
+    return;
+  }
+
+  if (opcode == extendedOpcodePrefix)
+  {
+    cycleCount += ExecuteExtendedOpcode(mmu.Get(registers.PC + 1));
+  }
+  else
+  {
+    cycleCount += ExecuteOpcode(opcode);
+  }
 }
 
-void CPU::Tick()
+/**
+ * @brief Executes one instruction and a possible interrupt dispatch, returns the T-cycles both took.
+ *
+ * Due events run first. A halted CPU instead wakes up, including the interrupt dispatch, or sleeps until the next
+ * event and whatever time that took is returned. Waking is a step of its own, so the next Tick starts on the first
+ * instruction of the handler just like after any other instruction.
+ */
+int CPU::Tick()
 {
-  // PrintCPUState();
-  PrintBLARGGSerial();
+  std::uint64_t start = cycleCount;
+
+  if (cycleCount >= scheduler.NextCycle())
+  {
+    scheduler.RunDue(cycleCount);
+  }
+
+  if (halted)
+  {
+    WakeFromHalt();
+    return static_cast<int>(cycleCount - start);
+  }
+
+  TraceInstruction();
+  instructionAddress = registers.PC;
 
   std::uint8_t opcode = mmu.Get(registers.PC);
 
   if (opcode == extendedOpcodePrefix)
   {
     opcode = mmu.Get(registers.PC + 1);
-    ExecuteExtendedOpcode(opcode);
+    cycleCount += ExecuteExtendedOpcode(opcode);
   }
   else
   {
-    ExecuteOpcode(opcode);
+    cycleCount += ExecuteOpcode(opcode);
   }
 
   HandleInterrupts();
+  return static_cast<int>(cycleCount - start);
+}
+
+bool CPU::State::operator==(const State& other) const
+{
+  return A == other.A && F == other.F && B == other.B && C == other.C && D == other.D && E == other.E &&
+         H == other.H && L == other.L && SP == other.SP && PC == other.PC && IME == other.IME &&
+         halted == other.halted;
+}
+
+CPU::State CPU::GetState() const
+{
+  return {registers.A, registers.EvaluateFlags(), registers.B, registers.C, registers.D, registers.E, registers.H, registers.L,
+          registers.SP, registers.PC, registers.IME, halted};
 }
 
 void CPU::Registers::SetFlag(int bit, bool value)
 {
+  ResolveFlags();
+
   std::uint8_t bitMask = (1 << bit);
 
   if (value == true)
@@ -200,6 +374,8 @@ void CPU::Registers::SetFlag(int bit, bool value)
 
 bool CPU::Registers::GetFlag(int bit)
 {
+  ResolveFlags();
+
   return (F & (1 << bit));
 }
 
@@ -225,6 +401,11 @@ void CPU::Registers::SetCarryFlag(bool value)
 
 bool CPU::Registers::GetZeroFlag()
 {
+  if (flagOperation != FlagOperation::None)
+  {
+    return flagResult == 0;
+  }
+
   return GetFlag(BITPOS_ZERO_FLAG);
 }
 
@@ -240,14 +421,123 @@ bool CPU::Registers::GetHalfCarryFlag()
 
 bool CPU::Registers::GetCarryFlag()
 {
+  if (flagOperation != FlagOperation::None)
+  {
+    return EvaluateCarry();
+  }
+
   return GetFlag(BITPOS_CARRY_FLAG);
 }
 
+/**
+ * @brief Records an ALU operation so its flags can be computed once something actually reads them.
+ */
+void CPU::Registers::DeferFlags(FlagOperation operation, std::uint8_t a, std::uint8_t b, std::uint8_t result,
+                                bool carry)
+{
+  flagOperation = operation;
+  flagOperandA = a;
+  flagOperandB = b;
+  flagResult = result;
+  flagCarry = carry;
+}
+
+/**
+ * @brief Carry flag of the deferred operation, which is read far more often than the other flags.
+ */
+bool CPU::Registers::EvaluateCarry() const
+{
+  switch (flagOperation)
+  {
+  case FlagOperation::Add:
+  case FlagOperation::Adc:
+    return flagOperandA + flagOperandB + flagCarry > 0xFF;
+  case FlagOperation::Sub:
+  case FlagOperation::Sbc:
+    return flagOperandA < flagOperandB + flagCarry;
+  case FlagOperation::And:
+  case FlagOperation::Xor:
+  case FlagOperation::Or:
+    return false;
+  case FlagOperation::Inc:
+  case FlagOperation::Dec:
+    return flagCarry;
+  case FlagOperation::None:
+    break;
+  }
+
+  return F & (1 << BITPOS_CARRY_FLAG);
+}
+
+/**
+ * @brief Value of F including the flags of a deferred operation, without touching F.
+ */
+std::uint8_t CPU::Registers::EvaluateFlags() const
+{
+  if (flagOperation == FlagOperation::None)
+  {
+    return F;
+  }
+
+  const std::uint8_t a = flagOperandA;
+  const std::uint8_t b = flagOperandB;
+
+  bool subtraction = false;
+  bool halfCarry = false;
+
+  switch (flagOperation)
+  {
+  case FlagOperation::Add:
+  case FlagOperation::Adc:
+    halfCarry = (a & 0x0F) + (b & 0x0F) + flagCarry > 0x0F;
+    break;
+  case FlagOperation::Sub:
+  case FlagOperation::Sbc:
+    subtraction = true;
+    halfCarry = (a & 0x0F) < (b & 0x0F) + flagCarry;
+    break;
+  case FlagOperation::And:
+    halfCarry = true;
+    break;
+  case FlagOperation::Inc:
+    halfCarry = (a & 0x0F) == 0x0F;
+    break;
+  case FlagOperation::Dec:
+    subtraction = true;
+    halfCarry = (a & 0x0F) == 0x00;
+    break;
+  default:
+    break;
+  }
+
+  return ((flagResult == 0) << BITPOS_ZERO_FLAG) | (subtraction << BITPOS_SUBTRACTION_FLAG) |
+         (halfCarry << BITPOS_HALF_CARRY_FLAG) | (EvaluateCarry() << BITPOS_CARRY_FLAG);
+}
+
+/**
+ * @brief Writes the flags of a deferred operation to F.
+ */
+void CPU::Registers::ResolveFlags()
+{
+  if (flagOperation != FlagOperation::None)
+  {
+    F = EvaluateFlags();
+    flagOperation = FlagOperation::None;
+  }
+}
+
 /**********************************************************************************/
 /* Operations                                                                     */
 /**********************************************************************************/
 void CPU::INC_R8(std::uint8_t& reg)
 {
+  if (lazyFlags)
+  {
+    registers.DeferFlags(Registers::FlagOperation::Inc, reg, 1, reg + 1, registers.GetCarryFlag());
+    ++reg;
+    return;
+  }
+
   registers.SetSubtractionFlag(false);
   registers.SetHalfCarryFlag(IsHalfCarryOverflow8(reg, 1));
   ++reg;
@@ -256,6 +546,13 @@ void CPU::INC_R8(std::uint8_t& reg)
 
 void CPU::DEC_R8(std::uint8_t& reg)
 {
+  if (lazyFlags)
+  {
+    registers.DeferFlags(Registers::FlagOperation::Dec, reg, 1, reg - 1, registers.GetCarryFlag());
+    --reg;
+    return;
+  }
+
   registers.SetSubtractionFlag(true);
   registers.SetHalfCarryFlag(IsHalfCarryUnderflow8(reg, 1));
   --reg;
@@ -264,6 +561,13 @@ void CPU::DEC_R8(std::uint8_t& reg)
 
 void CPU::ADD_A_R8(const std::uint8_t& reg)
 {
+  if (lazyFlags)
+  {
+    registers.DeferFlags(Registers::FlagOperation::Add, registers.A, reg, registers.A + reg, false);
+    registers.A += reg;
+    return;
+  }
+
   registers.SetSubtractionFlag(false);
   registers.SetHalfCarryFlag(IsHalfCarryOverflow8(registers.A, reg));
   registers.SetCarryFlag(IsCarryOverflow8(registers.A, reg));
@@ -283,6 +587,14 @@ void CPU::ADD_HL_R16(const std::uint16_t& reg)
 
 void CPU::ADC_A_R8(const std::uint8_t& reg)
 {
+  if (lazyFlags)
+  {
+    bool carry = registers.GetCarryFlag();
+    registers.DeferFlags(Registers::FlagOperation::Adc, registers.A, reg, registers.A + reg + carry, carry);
+    registers.A += reg + carry;
+    return;
+  }
+
   registers.SetSubtractionFlag(false);
   bool oldCarryFlag = registers.GetCarryFlag();
 
@@ -295,6 +607,13 @@ void CPU::ADC_A_R8(const std::uint8_t& reg)
 
 void CPU::SUB_A_R8(const std::uint8_t& reg)
 {
+  if (lazyFlags)
+  {
+    registers.DeferFlags(Registers::FlagOperation::Sub, registers.A, reg, registers.A - reg, false);
+    registers.A -= reg;
+    return;
+  }
+
   registers.SetSubtractionFlag(true);
   registers.SetHalfCarryFlag(IsHalfCarryUnderflow8(registers.A, reg));
   registers.SetCarryFlag(IsCarryUnderflow8(registers.A, reg));
@@ -306,6 +625,14 @@ void CPU::SUB_A_R8(const std::uint8_t& reg)
 
 void CPU::SBC_A_R8(const std::uint8_t& reg)
 {
+  if (lazyFlags)
+  {
+    bool carry = registers.GetCarryFlag();
+    registers.DeferFlags(Registers::FlagOperation::Sbc, registers.A, reg, registers.A - reg - carry, carry);
+    registers.A -= reg + carry;
+    return;
+  }
+
   bool oldCarryFlag = registers.GetCarryFlag();
 
   registers.SetSubtractionFlag(true);
@@ -319,6 +646,13 @@ void CPU::SBC_A_R8(const std::uint8_t& reg)
 
 void CPU::AND_A_R8(const std::uint8_t& reg)
 {
+  if (lazyFlags)
+  {
+    registers.DeferFlags(Registers::FlagOperation::And, registers.A, reg, registers.A & reg, false);
+    registers.A &= reg;
+    return;
+  }
+
   registers.SetSubtractionFlag(false);
   registers.SetHalfCarryFlag(true);
   registers.SetCarryFlag(false);
@@ -330,6 +664,13 @@ void CPU::AND_A_R8(const std::uint8_t& reg)
 
 void CPU::XOR_A_R8(const std::uint8_t& reg)
 {
+  if (lazyFlags)
+  {
+    registers.DeferFlags(Registers::FlagOperation::Xor, registers.A, reg, registers.A ^ reg, false);
+    registers.A ^= reg;
+    return;
+  }
+
   registers.SetSubtractionFlag(false);
   registers.SetHalfCarryFlag(false);
   registers.SetCarryFlag(false);
@@ -341,6 +682,13 @@ void CPU::XOR_A_R8(const std::uint8_t& reg)
 
 void CPU::OR_A_R8(const std::uint8_t& reg)
 {
+  if (lazyFlags)
+  {
+    registers.DeferFlags(Registers::FlagOperation::Or, registers.A, reg, registers.A | reg, false);
+    registers.A |= reg;
+    return;
+  }
+
   registers.SetSubtractionFlag(false);
   registers.SetHalfCarryFlag(false);
   registers.SetCarryFlag(false);
@@ -352,6 +700,12 @@ void CPU::OR_A_R8(const std::uint8_t& reg)
 
 void CPU::CP_A_R8(const std::uint8_t& reg)
 {
+  if (lazyFlags)
+  {
+    registers.DeferFlags(Registers::FlagOperation::Sub, registers.A, reg, registers.A - reg, false);
+    return;
+  }
+
   registers.SetSubtractionFlag(true);
   registers.SetHalfCarryFlag(IsHalfCarryUnderflow8(registers.A, reg));
   registers.SetCarryFlag(IsCarryUnderflow8(registers.A, reg));
@@ -359,12 +713,6 @@ void CPU::CP_A_R8(const std::uint8_t& reg)
   registers.SetZeroFlag((registers.A - reg) == 0);
 }
 
-void CPU::RST_VEC(const std::uint16_t addr)
-{
-  PUSH_N16(registers.PC + 1);
-  registers.PC = addr;
-}
-
 void CPU::RL_R8(std::uint8_t& reg)
 {
   registers.SetSubtractionFlag(false);
@@ -502,30 +850,17 @@ std::uint16_t CPU::POP_N16()
 
 std::uint8_t CPU::GetN8()
 {
-  return mmu.Get(registers.PC + 1);
+  return operand & 0xFF;
 }
 
 std::uint16_t CPU::GetN16()
 {
-  std::uint8_t low = mmu.Get(registers.PC + 1);
-  std::uint8_t high = mmu.Get(registers.PC + 2);
-
-  return (high << 8) | low;
+  return operand;
 }
 
 std::int8_t CPU::GetE8()
 {
-  return mmu.Get(registers.PC + 1);
-}
-
-void CPU::JR_CC_E8(bool condition)
-{
-  std::int8_t addressOffset = GetE8();
-
-  if (condition)
-  {
-    registers.PC += addressOffset;
-  }
+  return static_cast<std::int8_t>(operand & 0xFF);
 }
 
 bool CPU::IsHalfCarryOverflow8(const std::uint8_t a, const std::uint8_t b)
@@ -566,34 +901,11 @@ void CPU::NOP()
 {
 }
 
-void CPU::LD_BC_N16()
-{
-  registers.BC = GetN16();
-}
-
-void CPU::LD_dBC_A()
-{
-  mmu.Set(registers.BC, registers.A);
-}
-
-void CPU::INC_BC()
-{
-  ++registers.BC;
-}
-
-void CPU::INC_B()
-{
-  INC_R8(registers.B);
-}
-
-void CPU::DEC_B()
-{
-  DEC_R8(registers.B);
-}
-
-void CPU::LD_B_N8()
+void CPU::LD_DN16_SP()
 {
-  registers.B = GetN8();
+  std::uint16_t baseAddr = GetN16();
+  mmu.Set(baseAddr, registers.SP & 0xFF);
+  mmu.Set(baseAddr + 1, (registers.SP >> 8));
 }
 
 void CPU::RLCA()
@@ -607,43 +919,6 @@ void CPU::RLCA()
   registers.A = registers.A ^ registers.GetCarryFlag();
 }
 
-void CPU::LD_DN16_SP()
-{
-  std::uint16_t baseAddr = GetN16();
-  mmu.Set(baseAddr, registers.SP & 0xFF);
-  mmu.Set(baseAddr + 1, (registers.SP >> 8));
-}
-
-void CPU::ADD_HL_BC()
-{
-  ADD_HL_R16(registers.BC);
-}
-
-void CPU::LD_A_DBC()
-{
-  registers.A = mmu.Get(registers.BC);
-}
-
-void CPU::DEC_BC()
-{
-  --registers.BC;
-}
-
-void CPU::INC_C()
-{
-  INC_R8(registers.C);
-}
-
-void CPU::DEC_C()
-{
-  DEC_R8(registers.C);
-}
-
-void CPU::LD_C_N8()
-{
-  registers.C = GetN8();
-}
-
 void CPU::RRCA()
 {
   registers.SetZeroFlag(false);
@@ -659,7 +934,7 @@ void CPU::RRCA()
 
 void CPU::STOP_N8()
 {
-  std::uint8_t nextByte = mmu.Get(++registers.PC);
+  std::uint8_t nextByte = GetN8();
   halted = true;
   if (nextByte)
   {
@@ -667,37 +942,7 @@ void CPU::STOP_N8()
   }
 }
 
-void CPU::LD_DE_N16()
-{
-  registers.DE = GetN16();
-}
-
-void CPU::LD_dDE_A()
-{
-  mmu.Set(registers.DE, registers.A);
-}
-
-void CPU::INC_DE()
-{
-  ++registers.DE;
-}
-
-void CPU::INC_D()
-{
-  INC_R8(registers.D);
-}
-
-void CPU::DEC_D()
-{
-  DEC_R8(registers.D);
-}
-
-void CPU::LD_D_N8()
-{
-  registers.D = GetN8();
-}
-
-void CPU::RLA()
+void CPU::RLA()
 {
   registers.SetZeroFlag(false);
   registers.SetSubtractionFlag(false);
@@ -709,42 +954,6 @@ void CPU::RLA()
   registers.A = registers.A | oldCarryFlag;
 }
 
-void CPU::JR_E8()
-{
-  std::int8_t addressOffset = GetE8();
-  registers.PC += addressOffset;
-}
-
-void CPU::ADD_HL_DE()
-{
-  ADD_HL_R16(registers.DE);
-}
-
-void CPU::LD_A_dDE()
-{
-  registers.A = mmu.Get(registers.DE);
-}
-
-void CPU::DEC_DE()
-{
-  --registers.DE;
-}
-
-void CPU::INC_E()
-{
-  INC_R8(registers.E);
-}
-
-void CPU::DEC_E()
-{
-  DEC_R8(registers.E);
-}
-
-void CPU::LD_E_N8()
-{
-  registers.E = GetN8();
-}
-
 void CPU::RRA()
 {
   registers.SetZeroFlag(false);
@@ -757,41 +966,6 @@ void CPU::RRA()
   registers.A = registers.A | (oldCarryFlag << 7);
 }
 
-void CPU::JR_NZ_E8()
-{
-  JR_CC_E8(!registers.GetZeroFlag());
-}
-
-void CPU::LD_HL_N16()
-{
-  registers.HL = GetN16();
-}
-
-void CPU::LD_dHLi_A()
-{
-  mmu.Set(registers.HL++, registers.A);
-}
-
-void CPU::INC_HL()
-{
-  ++registers.HL;
-}
-
-void CPU::INC_H()
-{
-  INC_R8(registers.H);
-}
-
-void CPU::DEC_H()
-{
-  DEC_R8(registers.H);
-}
-
-void CPU::LD_H_N8()
-{
-  registers.H = GetN8();
-}
-
 void CPU::DAA()
 {
   std::uint8_t adjustment = 0;
@@ -826,2497 +1000,2220 @@ void CPU::DAA()
   registers.SetZeroFlag(registers.A == 0);
 }
 
-void CPU::JR_Z_E8()
+void CPU::CPL()
 {
-  JR_CC_E8(registers.GetZeroFlag());
+  registers.SetSubtractionFlag(true);
+  registers.SetHalfCarryFlag(true);
+  registers.A = ~registers.A;
 }
 
-void CPU::ADD_HL_HL()
+void CPU::SCF()
 {
-  ADD_HL_R16(registers.HL);
+  registers.SetSubtractionFlag(false);
+  registers.SetHalfCarryFlag(false);
+  registers.SetCarryFlag(true);
 }
 
-void CPU::LD_A_dHLi()
+void CPU::CCF()
 {
-  registers.A = mmu.Get(registers.HL++);
-}
+  registers.SetSubtractionFlag(false);
+  registers.SetHalfCarryFlag(false);
 
-void CPU::DEC_HL()
-{
-  --registers.HL;
+  registers.SetCarryFlag(!registers.GetCarryFlag());
 }
 
-void CPU::INC_L()
+/**
+ * @brief Sleeps until IE & IF becomes non-zero.
+ *
+ * With IME off and an interrupt already pending the CPU does not sleep and runs into the HALT bug instead. Right
+ * after EI the pending interrupt is serviced at once and returns to the HALT, which then executes again.
+ */
+void CPU::HALT()
 {
-  INC_R8(registers.L);
+  if (registers.IME || !PendingInterrupts())
+  {
+    halted = true;
+  }
+  else if (imeEnableDelay)
+  {
+    registers.PC -= 1;
+  }
+  else
+  {
+    ExecuteHaltBug();
+  }
 }
 
-void CPU::DEC_L()
+/**
+ * @brief Invalid opcodes hang the CPU, it behaves like a HALT that nothing ends.
+ */
+void CPU::LOCKUP()
 {
-  DEC_R8(registers.L);
+  locked = true;
+  halted = true;
 }
 
-void CPU::LD_L_N8()
+void CPU::LDH_dA8_A()
 {
-  registers.L = GetN8();
+  std::uint16_t highAddress = 0xFF00 + GetN8();
+  mmu.Set(highAddress, registers.A);
 }
 
-void CPU::CPL()
+void CPU::LDH_dC_A()
 {
-  registers.SetSubtractionFlag(true);
-  registers.SetHalfCarryFlag(true);
-  registers.A = ~registers.A;
+  std::uint16_t highAddress = 0xFF00 + registers.C;
+  mmu.Set(highAddress, registers.A);
 }
 
-void CPU::JR_NC_E8()
+void CPU::ADD_SP_E8()
 {
-  JR_CC_E8(!registers.GetCarryFlag());
-}
+  std::int8_t offset = GetE8();
 
-void CPU::LD_SP_N16()
-{
-  registers.SP = GetN16();
+  registers.SetZeroFlag(false);
+  registers.SetSubtractionFlag(false);
+  registers.SetHalfCarryFlag(IsHalfCarryOverflow8(registers.SP, offset));
+  registers.SetCarryFlag(IsCarryOverflow8(registers.SP, offset));
+
+  registers.SP += offset;
 }
 
-void CPU::LD_dHLd_A()
+void CPU::JP_HL()
 {
-  mmu.Set(registers.HL--, registers.A);
+  registers.PC = registers.HL;
 }
 
-void CPU::INC_SP()
+void CPU::LD_dA16_A()
 {
-  ++registers.SP;
+  mmu.Set(GetN16(), registers.A);
 }
 
-void CPU::INC_dHL()
+void CPU::LDH_A_dA8()
 {
-  std::uint8_t oldValue = mmu.Get(registers.HL);
-  std::uint8_t newValue = mmu.Get(registers.HL) + 1;
-
-  registers.SetSubtractionFlag(false);
-  registers.SetHalfCarryFlag(IsHalfCarryOverflow8(oldValue, 1));
-  mmu.Set(registers.HL, newValue);
-  registers.SetZeroFlag(newValue == 0);
+  std::uint16_t highAddress = 0xFF00 + GetN8();
+  registers.A = mmu.Get(highAddress);
 }
 
-void CPU::DEC_dHL()
+void CPU::LDH_A_dC()
 {
-  std::uint8_t oldValue = mmu.Get(registers.HL);
-  std::uint8_t newValue = mmu.Get(registers.HL) - 1;
-
-  registers.SetSubtractionFlag(true);
-  registers.SetHalfCarryFlag(IsHalfCarryUnderflow8(oldValue, 1));
-  mmu.Set(registers.HL, newValue);
-  registers.SetZeroFlag(newValue == 0);
+  std::uint16_t highAddress = 0xFF00 + registers.C;
+  registers.A = mmu.Get(highAddress);
 }
 
-void CPU::LD_dHL_N8()
+void CPU::DI()
 {
-  mmu.Set(registers.HL, GetN8());
+  registers.IME = false;
+  imeEnableDelay = 0;
+  UpdateInterruptsDue();
 }
 
-void CPU::SCF()
+void CPU::LD_HL_SP_p_E8()
 {
+  std::int8_t e8 = GetE8();
+  registers.SetZeroFlag(false);
   registers.SetSubtractionFlag(false);
-  registers.SetHalfCarryFlag(false);
-  registers.SetCarryFlag(true);
+  registers.SetHalfCarryFlag(IsHalfCarryOverflow8(registers.SP, e8));
+  registers.SetCarryFlag(IsCarryOverflow8(registers.SP, e8));
+  registers.HL = registers.SP + e8;
 }
 
-void CPU::JR_C_E8()
+void CPU::LD_SP_HL()
 {
-  JR_CC_E8(registers.GetCarryFlag());
+  registers.SP = registers.HL;
 }
 
-void CPU::ADD_HL_SP()
+void CPU::LD_A_dA16()
 {
-  ADD_HL_R16(registers.SP);
+  registers.A = mmu.Get(GetN16());
 }
 
-void CPU::LD_A_dHLd()
+void CPU::EI()
 {
-  registers.A = mmu.Get(registers.HL--);
+  imeEnableDelay = 2;
+  UpdateInterruptsDue();
 }
 
-void CPU::DEC_SP()
+/**
+ * @brief Unlike EI, RETI enables IME right away.
+ */
+void CPU::RETI()
 {
-  --registers.SP;
+  RET_CC<Condition::Always>();
+  registers.IME = true;
+  UpdateInterruptsDue();
 }
 
-void CPU::INC_A()
+template <CPU::R8 Operand> std::uint8_t& CPU::Register8()
 {
-  INC_R8(registers.A);
+  if constexpr (Operand == R8::B)
+  {
+    return registers.B;
+  }
+  else if constexpr (Operand == R8::C)
+  {
+    return registers.C;
+  }
+  else if constexpr (Operand == R8::D)
+  {
+    return registers.D;
+  }
+  else if constexpr (Operand == R8::E)
+  {
+    return registers.E;
+  }
+  else if constexpr (Operand == R8::H)
+  {
+    return registers.H;
+  }
+  else if constexpr (Operand == R8::L)
+  {
+    return registers.L;
+  }
+  else
+  {
+    static_assert(Operand == R8::A, "(HL) and n8 are not registers.");
+    return registers.A;
+  }
 }
 
-void CPU::DEC_A()
+template <CPU::R8 Operand> std::uint8_t CPU::Read8()
 {
-  DEC_R8(registers.A);
+  if constexpr (Operand == R8::dHL)
+  {
+    return mmu.Get(registers.HL);
+  }
+  else if constexpr (Operand == R8::N8)
+  {
+    return GetN8();
+  }
+  else
+  {
+    return Register8<Operand>();
+  }
 }
 
-void CPU::LD_A_N8()
+template <CPU::R8 Operand> void CPU::Write8(std::uint8_t value)
 {
-  registers.A = GetN8();
+  if constexpr (Operand == R8::dHL)
+  {
+    mmu.Set(registers.HL, value);
+  }
+  else
+  {
+    Register8<Operand>() = value;
+  }
 }
 
-void CPU::CCF()
+/**
+ * @brief Applies operation to a register in place, or to the byte at (HL) with a read and a write.
+ */
+template <CPU::R8 Target, typename Operation> void CPU::Modify8(Operation operation)
 {
-  registers.SetSubtractionFlag(false);
-  registers.SetHalfCarryFlag(false);
-
-  registers.SetCarryFlag(!registers.GetCarryFlag());
+  if constexpr (Target == R8::dHL)
+  {
+    std::uint8_t byte = mmu.Get(registers.HL);
+    operation(byte);
+    mmu.Set(registers.HL, byte);
+  }
+  else
+  {
+    operation(Register8<Target>());
+  }
 }
 
-void CPU::LD_B_B()
+template <CPU::R16 Pair> std::uint16_t& CPU::Register16()
 {
-  NOP();
+  if constexpr (Pair == R16::BC)
+  {
+    return registers.BC;
+  }
+  else if constexpr (Pair == R16::DE)
+  {
+    return registers.DE;
+  }
+  else if constexpr (Pair == R16::HL)
+  {
+    return registers.HL;
+  }
+  else if constexpr (Pair == R16::SP)
+  {
+    return registers.SP;
+  }
+  else
+  {
+    return registers.AF;
+  }
 }
 
-void CPU::LD_B_C()
+template <CPU::Indirect Operand> std::uint16_t CPU::IndirectAddress()
 {
-  registers.B = registers.C;
+  if constexpr (Operand == Indirect::BC)
+  {
+    return registers.BC;
+  }
+  else if constexpr (Operand == Indirect::DE)
+  {
+    return registers.DE;
+  }
+  else if constexpr (Operand == Indirect::HLi)
+  {
+    return registers.HL++;
+  }
+  else
+  {
+    return registers.HL--;
+  }
 }
 
-void CPU::LD_B_D()
+template <CPU::Condition Cond> bool CPU::IsConditionMet()
 {
-  registers.B = registers.D;
+  if constexpr (Cond == Condition::NZ)
+  {
+    return !registers.GetZeroFlag();
+  }
+  else if constexpr (Cond == Condition::Z)
+  {
+    return registers.GetZeroFlag();
+  }
+  else if constexpr (Cond == Condition::NC)
+  {
+    return !registers.GetCarryFlag();
+  }
+  else if constexpr (Cond == Condition::C)
+  {
+    return registers.GetCarryFlag();
+  }
+  else
+  {
+    return true;
+  }
 }
 
-void CPU::LD_B_E()
+template <CPU::R8 Target, CPU::R8 Source> void CPU::LD_R_R()
 {
-  registers.B = registers.E;
+  Write8<Target>(Read8<Source>());
 }
 
-void CPU::LD_B_H()
+template <CPU::R8 Target> void CPU::INC_R()
 {
-  registers.B = registers.H;
+  Modify8<Target>([this](std::uint8_t& value) { INC_R8(value); });
 }
 
-void CPU::LD_B_L()
+template <CPU::R8 Target> void CPU::DEC_R()
 {
-  registers.B = registers.L;
+  Modify8<Target>([this](std::uint8_t& value) { DEC_R8(value); });
 }
 
-void CPU::LD_B_dHL()
+template <CPU::AluOperation Operation, CPU::R8 Source> void CPU::ALU_A_R()
 {
-  registers.B = mmu.Get(registers.HL);
-}
+  // Indexed like AluOperation.
+  constexpr std::array<void (CPU::*)(const std::uint8_t&), 8> operations = {
+      &CPU::ADD_A_R8, &CPU::ADC_A_R8, &CPU::SUB_A_R8, &CPU::SBC_A_R8,
+      &CPU::AND_A_R8, &CPU::XOR_A_R8, &CPU::OR_A_R8,  &CPU::CP_A_R8};
 
-void CPU::LD_B_A()
-{
-  registers.B = registers.A;
+  (this->*operations[static_cast<int>(Operation)])(Read8<Source>());
 }
 
-void CPU::LD_C_B()
+template <CPU::R16 Pair> void CPU::LD_RR_N16()
 {
-  registers.C = registers.B;
+  Register16<Pair>() = GetN16();
 }
 
-void CPU::LD_C_C()
+template <CPU::R16 Pair> void CPU::INC_RR()
 {
-  NOP();
+  ++Register16<Pair>();
 }
 
-void CPU::LD_C_D()
+template <CPU::R16 Pair> void CPU::DEC_RR()
 {
-  registers.C = registers.D;
+  --Register16<Pair>();
 }
 
-void CPU::LD_C_E()
+template <CPU::R16 Pair> void CPU::ADD_HL_RR()
 {
-  registers.C = registers.E;
+  ADD_HL_R16(Register16<Pair>());
 }
 
-void CPU::LD_C_H()
+template <CPU::R16 Pair> void CPU::PUSH_RR()
 {
-  registers.C = registers.H;
-}
+  if constexpr (Pair == R16::AF)
+  {
+    registers.ResolveFlags();
+    SanitizeFlags();
+  }
 
-void CPU::LD_C_L()
-{
-  registers.C = registers.L;
+  PUSH_N16(Register16<Pair>());
 }
 
-void CPU::LD_C_dHL()
+template <CPU::R16 Pair> void CPU::POP_RR()
 {
-  registers.C = mmu.Get(registers.HL);
-}
+  Register16<Pair>() = POP_N16();
 
-void CPU::LD_C_A()
-{
-  registers.C = registers.A;
+  if constexpr (Pair == R16::AF)
+  {
+    registers.flagOperation = Registers::FlagOperation::None;
+    SanitizeFlags();
+  }
 }
 
-void CPU::LD_D_B()
+template <CPU::Indirect Operand> void CPU::LD_dRR_A()
 {
-  registers.D = registers.B;
+  mmu.Set(IndirectAddress<Operand>(), registers.A);
 }
 
-void CPU::LD_D_C()
+template <CPU::Indirect Operand> void CPU::LD_A_dRR()
 {
-  registers.D = registers.C;
+  registers.A = mmu.Get(IndirectAddress<Operand>());
 }
 
-void CPU::LD_D_D()
+template <CPU::Condition Cond> void CPU::JR_CC_E8()
 {
-  NOP();
-}
+  std::int8_t addressOffset = GetE8();
 
-void CPU::LD_D_E()
-{
-  registers.D = registers.E;
-}
+  branchTaken = IsConditionMet<Cond>();
 
-void CPU::LD_D_H()
-{
-  registers.D = registers.H;
+  if (branchTaken)
+  {
+    std::uint16_t branch = registers.PC - 2;
+    registers.PC += addressOffset;
+
+    if (addressOffset < 0 && idleLoopSkipping)
+    {
+      SkipIdleLoop(branch, false);
+    }
+  }
 }
 
-void CPU::LD_D_L()
+template <CPU::Condition Cond> void CPU::JP_CC_A16()
 {
-  registers.D = registers.L;
+  branchTaken = IsConditionMet<Cond>();
+
+  if (branchTaken)
+  {
+    std::uint16_t branch = registers.PC - 3;
+    registers.PC = GetN16();
+
+    if (registers.PC <= branch && idleLoopSkipping)
+    {
+      SkipIdleLoop(branch, false);
+    }
+  }
 }
 
-void CPU::LD_D_dHL()
+template <CPU::Condition Cond> void CPU::CALL_CC_A16()
 {
-  registers.D = mmu.Get(registers.HL);
+  branchTaken = IsConditionMet<Cond>();
+
+  if (branchTaken)
+  {
+    PUSH_N16(registers.PC);
+    registers.PC = GetN16();
+    if (sampler)
+    {
+      sampler->OnCall(mmu.GetBank(registers.PC), registers.PC, registers.SP);
+    }
+  }
 }
 
-void CPU::LD_D_A()
+template <CPU::Condition Cond> void CPU::RET_CC()
 {
-  registers.D = registers.A;
+  branchTaken = IsConditionMet<Cond>();
+
+  if (branchTaken)
+  {
+    registers.PC = POP_N16();
+    if (sampler)
+    {
+      sampler->OnReturn(registers.SP);
+    }
+  }
 }
 
-void CPU::LD_E_B()
+template <std::uint16_t Vector> void CPU::RST_N()
 {
-  registers.E = registers.B;
+  PUSH_N16(registers.PC);
+  registers.PC = Vector;
+  if (sampler)
+  {
+    sampler->OnCall(mmu.GetBank(registers.PC), registers.PC, registers.SP);
+  }
 }
 
-void CPU::LD_E_C()
+/**********************************************************************************/
+/* Prefixed Opcodes                                                               */
+/**********************************************************************************/
+template <CPU::ShiftOperation Operation, CPU::R8 Target> void CPU::SHIFT_R()
 {
-  registers.E = registers.C;
+  // Indexed like ShiftOperation.
+  constexpr std::array<void (CPU::*)(std::uint8_t&), 8> operations = {
+      &CPU::RLC_R8, &CPU::RRC_R8, &CPU::RL_R8, &CPU::RR_R8, &CPU::SLA_R8, &CPU::SRA_R8, &CPU::SWAP_R8, &CPU::SRL_R8};
+
+  constexpr auto operation = operations[static_cast<int>(Operation)];
+
+  Modify8<Target>([this](std::uint8_t& value) { (this->*operation)(value); });
 }
 
-void CPU::LD_E_D()
+template <int Bit, CPU::R8 Target> void CPU::BIT_R()
 {
-  registers.E = registers.D;
+  std::uint8_t value = Read8<Target>();
+  BIT_R8(value, Bit);
 }
 
-void CPU::LD_E_E()
+template <int Bit, CPU::R8 Target> void CPU::RES_R()
 {
-  NOP();
+  Modify8<Target>([this](std::uint8_t& value) { RES_R8(value, Bit); });
 }
 
-void CPU::LD_E_H()
+template <int Bit, CPU::R8 Target> void CPU::SET_R()
 {
-  registers.E = registers.H;
+  Modify8<Target>([this](std::uint8_t& value) { SET_R8(value, Bit); });
 }
 
-void CPU::LD_E_L()
-{
-  registers.E = registers.L;
-}
-
-void CPU::LD_E_dHL()
-{
-  registers.E = mmu.Get(registers.HL);
-}
-
-void CPU::LD_E_A()
-{
-  registers.E = registers.A;
-}
-
-void CPU::LD_H_B()
-{
-  registers.H = registers.B;
-}
-
-void CPU::LD_H_C()
-{
-  registers.H = registers.C;
-}
-
-void CPU::LD_H_D()
-{
-  registers.H = registers.D;
-}
-
-void CPU::LD_H_E()
-{
-  registers.H = registers.E;
-}
-
-void CPU::LD_H_H()
-{
-  NOP();
-}
-
-void CPU::LD_H_L()
-{
-  registers.H = registers.L;
-}
-
-void CPU::LD_H_dHL()
-{
-  registers.H = mmu.Get(registers.HL);
-}
-
-void CPU::LD_H_A()
-{
-  registers.H = registers.A;
-}
-
-void CPU::LD_L_B()
-{
-  registers.L = registers.B;
-}
-
-void CPU::LD_L_C()
-{
-  registers.L = registers.C;
-}
-
-void CPU::LD_L_D()
-{
-  registers.L = registers.D;
-}
-
-void CPU::LD_L_E()
-{
-  registers.L = registers.E;
-}
-
-void CPU::LD_L_H()
-{
-  registers.L = registers.H;
-}
-
-void CPU::LD_L_L()
-{
-  NOP();
-}
-
-void CPU::LD_L_dHL()
-{
-  registers.L = mmu.Get(registers.HL);
-}
-
-void CPU::LD_L_A()
-{
-  registers.L = registers.A;
-}
-
-void CPU::LD_dHL_B()
-{
-  mmu.Set(registers.HL, registers.B);
-}
-
-void CPU::LD_dHL_C()
-{
-  mmu.Set(registers.HL, registers.C);
-}
-
-void CPU::LD_dHL_D()
-{
-  mmu.Set(registers.HL, registers.D);
-}
-
-void CPU::LD_dHL_E()
-{
-  mmu.Set(registers.HL, registers.E);
-}
-
-void CPU::LD_dHL_H()
-{
-  mmu.Set(registers.HL, registers.H);
-}
-
-void CPU::LD_dHL_L()
-{
-  mmu.Set(registers.HL, registers.L);
-}
-
-void CPU::HALT()
-{
-  halted = true;
-  // TODO IMPLEMENT INTERRUPT HANDLING
-}
-
-void CPU::LD_dHL_A()
-{
-  mmu.Set(registers.HL, registers.A);
-}
-
-void CPU::LD_A_B()
-{
-  registers.A = registers.B;
-}
-
-void CPU::LD_A_C()
-{
-  registers.A = registers.C;
-}
-
-void CPU::LD_A_D()
-{
-  registers.A = registers.D;
-}
-
-void CPU::LD_A_E()
-{
-  registers.A = registers.E;
-}
-
-void CPU::LD_A_H()
-{
-  registers.A = registers.H;
-}
-
-void CPU::LD_A_L()
-{
-  registers.A = registers.L;
-}
-
-void CPU::LD_A_dHL()
-{
-  registers.A = mmu.Get(registers.HL);
-}
-
-void CPU::LD_A_A()
-{
-  NOP();
-}
-
-void CPU::ADD_A_B()
-{
-  ADD_A_R8(registers.B);
-}
-
-void CPU::ADD_A_C()
-{
-  ADD_A_R8(registers.C);
-}
-
-void CPU::ADD_A_D()
-{
-  ADD_A_R8(registers.D);
-}
-
-void CPU::ADD_A_E()
-{
-  ADD_A_R8(registers.E);
-}
-
-void CPU::ADD_A_H()
-{
-  ADD_A_R8(registers.H);
-}
-
-void CPU::ADD_A_L()
-{
-  ADD_A_R8(registers.L);
-}
-
-void CPU::ADD_A_dHL()
-{
-  ADD_A_R8(mmu.Get(registers.HL));
-}
-
-void CPU::ADD_A_A()
-{
-  ADD_A_R8(registers.A);
-}
-
-void CPU::ADC_A_B()
-{
-  ADC_A_R8(registers.B);
-}
-
-void CPU::ADC_A_C()
-{
-  ADC_A_R8(registers.C);
-}
-
-void CPU::ADC_A_D()
-{
-  ADC_A_R8(registers.D);
-}
-
-void CPU::ADC_A_E()
-{
-  ADC_A_R8(registers.E);
-}
-
-void CPU::ADC_A_H()
-{
-  ADC_A_R8(registers.H);
-}
-
-void CPU::ADC_A_L()
-{
-  ADC_A_R8(registers.L);
-}
-
-void CPU::ADC_A_dHL()
-{
-  ADC_A_R8(mmu.Get(registers.HL));
-}
-
-void CPU::ADC_A_A()
-{
-  ADC_A_R8(registers.A);
-}
-
-void CPU::SUB_A_B()
-{
-  SUB_A_R8(registers.B);
-}
-
-void CPU::SUB_A_C()
-{
-  SUB_A_R8(registers.C);
-}
-
-void CPU::SUB_A_D()
-{
-  SUB_A_R8(registers.D);
-}
-
-void CPU::SUB_A_E()
-{
-  SUB_A_R8(registers.E);
-}
-
-void CPU::SUB_A_H()
-{
-  SUB_A_R8(registers.H);
-}
-
-void CPU::SUB_A_L()
-{
-  SUB_A_R8(registers.L);
-}
-
-void CPU::SUB_A_dHL()
-{
-  SUB_A_R8(mmu.Get(registers.HL));
-}
-
-void CPU::SUB_A_A()
-{
-  SUB_A_R8(registers.A);
-}
-
-void CPU::SBC_A_B()
-{
-  SBC_A_R8(registers.B);
-}
-
-void CPU::SBC_A_C()
-{
-  SBC_A_R8(registers.C);
-}
-
-void CPU::SBC_A_D()
-{
-  SBC_A_R8(registers.D);
-}
-
-void CPU::SBC_A_E()
-{
-  SBC_A_R8(registers.E);
-}
-
-void CPU::SBC_A_H()
-{
-  SBC_A_R8(registers.H);
-}
-
-void CPU::SBC_A_L()
-{
-  SBC_A_R8(registers.L);
-}
-
-void CPU::SBC_A_dHL()
-{
-  SBC_A_R8(mmu.Get(registers.HL));
-}
-
-void CPU::SBC_A_A()
-{
-  SBC_A_R8(registers.A);
-}
-
-void CPU::AND_A_B()
-{
-  AND_A_R8(registers.B);
-}
-
-void CPU::AND_A_C()
-{
-  AND_A_R8(registers.C);
-}
-
-void CPU::AND_A_D()
-{
-  AND_A_R8(registers.D);
-}
-
-void CPU::AND_A_E()
-{
-  AND_A_R8(registers.E);
-}
-
-void CPU::AND_A_H()
-{
-  AND_A_R8(registers.H);
-}
-
-void CPU::AND_A_L()
-{
-  AND_A_R8(registers.L);
-}
-
-void CPU::AND_A_dHL()
-{
-  AND_A_R8(mmu.Get(registers.HL));
-}
-
-void CPU::AND_A_A()
-{
-  AND_A_R8(registers.A);
-}
-
-void CPU::XOR_A_B()
-{
-  XOR_A_R8(registers.B);
-}
-
-void CPU::XOR_A_C()
-{
-  XOR_A_R8(registers.C);
-}
-
-void CPU::XOR_A_D()
-{
-  XOR_A_R8(registers.D);
-}
-
-void CPU::XOR_A_E()
-{
-  XOR_A_R8(registers.E);
-}
-
-void CPU::XOR_A_H()
-{
-  XOR_A_R8(registers.H);
-}
-
-void CPU::XOR_A_L()
-{
-  XOR_A_R8(registers.L);
-}
-
-void CPU::XOR_A_dHL()
-{
-  XOR_A_R8(mmu.Get(registers.HL));
-}
-
-void CPU::XOR_A_A()
-{
-  XOR_A_R8(registers.A);
-}
-
-void CPU::OR_A_B()
-{
-  OR_A_R8(registers.B);
-}
-
-void CPU::OR_A_C()
-{
-  OR_A_R8(registers.C);
-}
-
-void CPU::OR_A_D()
-{
-  OR_A_R8(registers.D);
-}
-
-void CPU::OR_A_E()
-{
-  OR_A_R8(registers.E);
-}
-
-void CPU::OR_A_H()
-{
-  OR_A_R8(registers.H);
-}
-
-void CPU::OR_A_L()
-{
-  OR_A_R8(registers.L);
-}
-
-void CPU::OR_A_dHL()
-{
-  OR_A_R8(mmu.Get(registers.HL));
-}
-
-void CPU::OR_A_A()
-{
-  OR_A_R8(registers.A);
-}
-
-void CPU::CP_A_B()
-{
-  CP_A_R8(registers.B);
-}
-
-void CPU::CP_A_C()
-{
-  CP_A_R8(registers.C);
-}
-
-void CPU::CP_A_D()
-{
-  CP_A_R8(registers.D);
-}
-
-void CPU::CP_A_E()
-{
-  CP_A_R8(registers.E);
-}
-
-void CPU::CP_A_H()
-{
-  CP_A_R8(registers.H);
-}
-
-void CPU::CP_A_L()
-{
-  CP_A_R8(registers.L);
-}
-
-void CPU::CP_A_dHL()
-{
-  CP_A_R8(mmu.Get(registers.HL));
-}
-
-void CPU::CP_A_A()
-{
-  CP_A_R8(registers.A);
-}
-
-void CPU::RET_NZ()
-{
-  if (!registers.GetZeroFlag())
-  {
-    RET();
-  }
-}
-
-void CPU::POP_BC()
-{
-  registers.BC = POP_N16();
-}
-
-void CPU::JP_NZ_A16()
-{
-  if (!registers.GetZeroFlag())
-  {
-    JP_A16();
-  }
-}
-
-void CPU::JP_A16()
-{
-  registers.PC = GetN16();
-  jumped = true;
-}
-
-void CPU::CALL_NZ_A16()
-{
-  if (!registers.GetZeroFlag())
-  {
-    CALL_A16();
-  }
-}
-
-void CPU::PUSH_BC()
-{
-  PUSH_N16(registers.BC);
-}
-
-void CPU::ADD_A_N8()
-{
-  ADD_A_R8(GetN8());
-}
-
-void CPU::RST_00()
-{
-  RST_VEC(0x00);
-}
-
-void CPU::RET_Z()
-{
-  if (registers.GetZeroFlag())
-  {
-    RET();
-  }
-}
-
-void CPU::RET()
-{
-  std::uint16_t returnAddress = POP_N16();
-  registers.PC = returnAddress;
-  jumped = true;
-}
-
-void CPU::JP_Z_A16()
-{
-  if (registers.GetZeroFlag())
-  {
-    JP_A16();
-  }
-}
-
-void CPU::CALL_Z_A16()
-{
-  if (registers.GetZeroFlag())
-  {
-    CALL_A16();
-  }
-}
-
-void CPU::CALL_A16()
-{
-  PUSH_N16(registers.PC + 3);
-  JP_A16();
-}
-
-void CPU::ADC_A_N8()
-{
-  ADC_A_R8(GetN8());
-}
-
-void CPU::RST_08()
-{
-  RST_VEC(0x08);
-}
-
-void CPU::RET_NC()
-{
-  if (!registers.GetCarryFlag())
-  {
-    RET();
-  }
-}
-
-void CPU::POP_DE()
-{
-  registers.DE = POP_N16();
-}
-
-void CPU::JP_NC_A16()
-{
-  if (!registers.GetCarryFlag())
-  {
-    JP_A16();
-  }
-}
-
-void CPU::CALL_NC_A16()
-{
-  if (!registers.GetCarryFlag())
-  {
-    CALL_A16();
-  }
-}
-
-void CPU::PUSH_DE()
-{
-  PUSH_N16(registers.DE);
-}
-
-void CPU::SUB_A_N8()
-{
-  SUB_A_R8(GetN8());
-}
-
-void CPU::RST_10()
-{
-  RST_VEC(0x10);
-}
-
-void CPU::RET_C()
-{
-  if (registers.GetCarryFlag())
-  {
-    RET();
-  }
-}
-
-void CPU::RETI()
-{
-  EI();
-  RET();
-}
-
-void CPU::JP_C_A16()
-{
-  if (registers.GetCarryFlag())
-  {
-    JP_A16();
-  }
-}
-
-void CPU::CALL_C_A16()
-{
-  if (registers.GetCarryFlag())
-  {
-    CALL_A16();
-  }
-}
-
-void CPU::SBC_A_N8()
-{
-  SBC_A_R8(GetN8());
-}
-
-void CPU::RST_18()
-{
-  RST_VEC(0x18);
-}
-
-void CPU::LDH_dA8_A()
-{
-  std::uint16_t highAddress = 0xFF00 + GetN8();
-  mmu.Set(highAddress, registers.A);
-}
-
-void CPU::POP_HL()
-{
-  registers.HL = POP_N16();
-}
-
-void CPU::LDH_dC_A()
-{
-  std::uint16_t highAddress = 0xFF00 + registers.C;
-  mmu.Set(highAddress, registers.A);
-}
-
-void CPU::PUSH_HL()
-{
-  PUSH_N16(registers.HL);
-}
-
-void CPU::AND_A_N8()
-{
-  AND_A_R8(GetN8());
-}
-
-void CPU::RST_20()
-{
-  RST_VEC(0x20);
-}
-
-void CPU::ADD_SP_E8()
-{
-  std::int8_t offset = GetE8();
-
-  registers.SetZeroFlag(false);
-  registers.SetSubtractionFlag(false);
-  registers.SetHalfCarryFlag(IsHalfCarryOverflow8(registers.SP, offset));
-  registers.SetCarryFlag(IsCarryOverflow8(registers.SP, offset));
-
-  registers.SP += offset;
-}
-
-void CPU::JP_HL()
-{
-  registers.PC = registers.HL;
-  jumped = true;
-}
-
-void CPU::LD_dA16_A()
-{
-  mmu.Set(GetN16(), registers.A);
-}
-
-void CPU::XOR_A_N8()
-{
-  XOR_A_R8(GetN8());
-}
-
-void CPU::RST_28()
-{
-  RST_VEC(0x28);
-}
-
-void CPU::LDH_A_dA8()
-{
-  std::uint16_t highAddress = 0xFF00 + GetN8();
-  registers.A = mmu.Get(highAddress);
-}
-
-void CPU::POP_AF()
-{
-  registers.AF = POP_N16();
-  SanitizeFlags();
-}
-
-void CPU::LDH_A_dC()
-{
-  std::uint16_t highAddress = 0xFF00 + registers.C;
-  registers.A = mmu.Get(highAddress);
-}
-
-void CPU::DI()
-{
-  registers.IME = false;
-  setIMEAfterNextInstruction = false;
-}
-
-void CPU::PUSH_AF()
-{
-  SanitizeFlags();
-  PUSH_N16(registers.AF);
-}
-
-void CPU::OR_A_N8()
-{
-  OR_A_R8(GetN8());
-}
-
-void CPU::RST_30()
-{
-  RST_VEC(0x30);
-}
-
-void CPU::LD_HL_SP_p_E8()
-{
-  std::int8_t e8 = GetE8();
-  registers.SetZeroFlag(false);
-  registers.SetSubtractionFlag(false);
-  registers.SetHalfCarryFlag(IsHalfCarryOverflow8(registers.SP, e8));
-  registers.SetCarryFlag(IsCarryOverflow8(registers.SP, e8));
-  registers.HL = registers.SP + e8;
-}
-
-void CPU::LD_SP_HL()
-{
-  registers.SP = registers.HL;
-}
-
-void CPU::LD_A_dA16()
-{
-  registers.A = mmu.Get(GetN16());
-}
-
-void CPU::EI()
-{
-  setIMEAfterNextInstruction = true;
-}
-
-void CPU::CP_A_N8()
-{
-  CP_A_R8(GetN8());
-}
-
-void CPU::RST_38()
-{
-  RST_VEC(0x38);
-}
-
-/**********************************************************************************/
-/* Prefixed Opcodes                                                               */
-/**********************************************************************************/
-void CPU::RLC_B()
-{
-  RLC_R8(registers.B);
-}
-
-void CPU::RLC_C()
-{
-  RLC_R8(registers.C);
-}
-
-void CPU::RLC_D()
-{
-  RLC_R8(registers.D);
-}
-
-void CPU::RLC_E()
-{
-  RLC_R8(registers.E);
-}
-
-void CPU::RLC_H()
-{
-  RLC_R8(registers.H);
-}
-
-void CPU::RLC_L()
-{
-  RLC_R8(registers.L);
-}
-
-void CPU::RLC_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  RLC_R8(byte);
-  mmu.Set(registers.HL, byte);
-}
-
-void CPU::RLC_A()
-{
-  RLC_R8(registers.A);
-}
-
-void CPU::RRC_B()
-{
-  RRC_R8(registers.B);
-}
-
-void CPU::RRC_C()
-{
-  RRC_R8(registers.C);
-}
-
-void CPU::RRC_D()
-{
-  RRC_R8(registers.D);
-}
-
-void CPU::RRC_E()
-{
-  RRC_R8(registers.E);
-}
-
-void CPU::RRC_H()
-{
-  RRC_R8(registers.H);
-}
-
-void CPU::RRC_L()
-{
-  RRC_R8(registers.L);
-}
-
-void CPU::RRC_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  RRC_R8(byte);
-  mmu.Set(registers.HL, byte);
-}
-
-void CPU::RRC_A()
-{
-  RRC_R8(registers.A);
-}
-
-void CPU::RL_B()
-{
-  RL_R8(registers.B);
-}
-
-void CPU::RL_C()
-{
-  RL_R8(registers.C);
-}
-
-void CPU::RL_D()
-{
-  RL_R8(registers.D);
-}
-
-void CPU::RL_E()
-{
-  RL_R8(registers.E);
-}
-
-void CPU::RL_H()
-{
-  RL_R8(registers.H);
-}
-
-void CPU::RL_L()
-{
-  RL_R8(registers.L);
-}
-
-void CPU::RL_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  RL_R8(byte);
-  mmu.Set(registers.HL, byte);
-}
-
-void CPU::RL_A()
-{
-  RL_R8(registers.A);
-}
-
-void CPU::RR_B()
-{
-  RR_R8(registers.B);
-}
-
-void CPU::RR_C()
-{
-  RR_R8(registers.C);
-}
-
-void CPU::RR_D()
-{
-  RR_R8(registers.D);
-}
-
-void CPU::RR_E()
-{
-  RR_R8(registers.E);
-}
-
-void CPU::RR_H()
-{
-  RR_R8(registers.H);
-}
-
-void CPU::RR_L()
-{
-  RR_R8(registers.L);
-}
-
-void CPU::RR_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  RR_R8(byte);
-  mmu.Set(registers.HL, byte);
-}
-
-void CPU::RR_A()
-{
-  RR_R8(registers.A);
-}
-
-void CPU::SLA_B()
-{
-  SLA_R8(registers.B);
-}
-
-void CPU::SLA_C()
-{
-  SLA_R8(registers.C);
-}
-
-void CPU::SLA_D()
-{
-  SLA_R8(registers.D);
-}
-
-void CPU::SLA_E()
-{
-  SLA_R8(registers.E);
-}
-
-void CPU::SLA_H()
-{
-  SLA_R8(registers.H);
-}
-
-void CPU::SLA_L()
-{
-  SLA_R8(registers.L);
-}
-
-void CPU::SLA_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  SLA_R8(byte);
-  mmu.Set(registers.HL, byte);
-}
-
-void CPU::SLA_A()
-{
-  SLA_R8(registers.A);
-}
-
-void CPU::SRA_B()
-{
-  SRA_R8(registers.B);
-}
-
-void CPU::SRA_C()
-{
-  SRA_R8(registers.C);
-}
-
-void CPU::SRA_D()
-{
-  SRA_R8(registers.D);
-}
-
-void CPU::SRA_E()
-{
-  SRA_R8(registers.E);
-}
-
-void CPU::SRA_H()
-{
-  SRA_R8(registers.H);
-}
-
-void CPU::SRA_L()
-{
-  SRA_R8(registers.L);
-}
-
-void CPU::SRA_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  SRA_R8(byte);
-  mmu.Set(registers.HL, byte);
-}
-
-void CPU::SRA_A()
-{
-  SRA_R8(registers.A);
-}
-
-void CPU::SWAP_B()
-{
-  SWAP_R8(registers.B);
-}
-
-void CPU::SWAP_C()
-{
-  SWAP_R8(registers.C);
-}
-
-void CPU::SWAP_D()
-{
-  SWAP_R8(registers.D);
-}
-
-void CPU::SWAP_E()
-{
-  SWAP_R8(registers.E);
-}
-
-void CPU::SWAP_H()
-{
-  SWAP_R8(registers.H);
-}
-
-void CPU::SWAP_L()
-{
-  SWAP_R8(registers.L);
-}
-
-void CPU::SWAP_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  SWAP_R8(byte);
-  mmu.Set(registers.HL, byte);
-}
-
-void CPU::SWAP_A()
-{
-  SWAP_R8(registers.A);
-}
-
-void CPU::SRL_B()
-{
-  SRL_R8(registers.B);
-}
-
-void CPU::SRL_C()
-{
-  SRL_R8(registers.C);
-}
-
-void CPU::SRL_D()
-{
-  SRL_R8(registers.D);
-}
-
-void CPU::SRL_E()
-{
-  SRL_R8(registers.E);
-}
-
-void CPU::SRL_H()
-{
-  SRL_R8(registers.H);
-}
-
-void CPU::SRL_L()
-{
-  SRL_R8(registers.L);
-}
-
-void CPU::SRL_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  SRL_R8(byte);
-  mmu.Set(registers.HL, byte);
-}
-
-void CPU::SRL_A()
-{
-  SRL_R8(registers.A);
-}
-
-void CPU::BIT_0_B()
-{
-  BIT_R8(registers.B, 0);
-}
-
-void CPU::BIT_0_C()
-{
-  BIT_R8(registers.C, 0);
-}
-
-void CPU::BIT_0_D()
-{
-  BIT_R8(registers.D, 0);
-}
-
-void CPU::BIT_0_E()
-{
-  BIT_R8(registers.E, 0);
-}
-
-void CPU::BIT_0_H()
-{
-  BIT_R8(registers.H, 0);
-}
-
-void CPU::BIT_0_L()
-{
-  BIT_R8(registers.L, 0);
-}
-
-void CPU::BIT_0_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  BIT_R8(byte, 0);
-  mmu.Set(registers.HL, byte);
-}
-
-void CPU::BIT_0_A()
-{
-  BIT_R8(registers.A, 0);
-}
-
-void CPU::BIT_1_B()
-{
-  BIT_R8(registers.B, 1);
-}
-
-void CPU::BIT_1_C()
-{
-  BIT_R8(registers.C, 1);
-}
-
-void CPU::BIT_1_D()
-{
-  BIT_R8(registers.D, 1);
-}
-
-void CPU::BIT_1_E()
-{
-  BIT_R8(registers.E, 1);
-}
-
-void CPU::BIT_1_H()
-{
-  BIT_R8(registers.H, 1);
-}
-
-void CPU::BIT_1_L()
-{
-  BIT_R8(registers.L, 1);
-}
-
-void CPU::BIT_1_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  BIT_R8(byte, 1);
-  mmu.Set(registers.HL, byte);
-}
-
-void CPU::BIT_1_A()
-{
-  BIT_R8(registers.A, 1);
-}
-
-void CPU::BIT_2_B()
-{
-  BIT_R8(registers.B, 2);
-}
-
-void CPU::BIT_2_C()
-{
-  BIT_R8(registers.C, 2);
-}
-
-void CPU::BIT_2_D()
-{
-  BIT_R8(registers.D, 2);
-}
-
-void CPU::BIT_2_E()
-{
-  BIT_R8(registers.E, 2);
-}
-
-void CPU::BIT_2_H()
-{
-  BIT_R8(registers.H, 2);
-}
-
-void CPU::BIT_2_L()
-{
-  BIT_R8(registers.L, 2);
-}
-
-void CPU::BIT_2_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  BIT_R8(byte, 2);
-  mmu.Set(registers.HL, byte);
-}
-
-void CPU::BIT_2_A()
-{
-  BIT_R8(registers.A, 2);
-}
-
-void CPU::BIT_3_B()
-{
-  BIT_R8(registers.B, 3);
-}
-
-void CPU::BIT_3_C()
-{
-  BIT_R8(registers.C, 3);
-}
-
-void CPU::BIT_3_D()
-{
-  BIT_R8(registers.D, 3);
-}
-
-void CPU::BIT_3_E()
-{
-  BIT_R8(registers.E, 3);
-}
-
-void CPU::BIT_3_H()
-{
-  BIT_R8(registers.H, 3);
-}
-
-void CPU::BIT_3_L()
-{
-  BIT_R8(registers.L, 3);
-}
-
-void CPU::BIT_3_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  BIT_R8(byte, 3);
-  mmu.Set(registers.HL, byte);
-}
-
-void CPU::BIT_3_A()
-{
-  BIT_R8(registers.A, 3);
-}
-
-void CPU::BIT_4_B()
-{
-  BIT_R8(registers.B, 4);
-}
-
-void CPU::BIT_4_C()
-{
-  BIT_R8(registers.C, 4);
-}
-
-void CPU::BIT_4_D()
-{
-  BIT_R8(registers.D, 4);
-}
-
-void CPU::BIT_4_E()
-{
-  BIT_R8(registers.E, 4);
-}
-
-void CPU::BIT_4_H()
-{
-  BIT_R8(registers.H, 4);
-}
-
-void CPU::BIT_4_L()
-{
-  BIT_R8(registers.L, 4);
-}
-
-void CPU::BIT_4_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  BIT_R8(byte, 4);
-  mmu.Set(registers.HL, byte);
-}
-
-void CPU::BIT_4_A()
-{
-  BIT_R8(registers.A, 4);
-}
-
-void CPU::BIT_5_B()
-{
-  BIT_R8(registers.B, 5);
-}
-
-void CPU::BIT_5_C()
-{
-  BIT_R8(registers.C, 5);
-}
-
-void CPU::BIT_5_D()
-{
-  BIT_R8(registers.D, 5);
-}
-
-void CPU::BIT_5_E()
-{
-  BIT_R8(registers.E, 5);
-}
-
-void CPU::BIT_5_H()
-{
-  BIT_R8(registers.H, 5);
-}
-
-void CPU::BIT_5_L()
-{
-  BIT_R8(registers.L, 5);
-}
-
-void CPU::BIT_5_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  BIT_R8(byte, 5);
-  mmu.Set(registers.HL, byte);
-}
-
-void CPU::BIT_5_A()
-{
-  BIT_R8(registers.A, 5);
-}
-
-void CPU::BIT_6_B()
-{
-  BIT_R8(registers.B, 6);
-}
-
-void CPU::BIT_6_C()
-{
-  BIT_R8(registers.C, 6);
-}
-
-void CPU::BIT_6_D()
-{
-  BIT_R8(registers.D, 6);
-}
-
-void CPU::BIT_6_E()
-{
-  BIT_R8(registers.E, 6);
-}
-
-void CPU::BIT_6_H()
-{
-  BIT_R8(registers.H, 6);
-}
-
-void CPU::BIT_6_L()
-{
-  BIT_R8(registers.L, 6);
-}
-
-void CPU::BIT_6_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  BIT_R8(byte, 6);
-  mmu.Set(registers.HL, byte);
-}
-
-void CPU::BIT_6_A()
-{
-  BIT_R8(registers.A, 6);
-}
-
-void CPU::BIT_7_B()
-{
-  BIT_R8(registers.B, 7);
-}
-
-void CPU::BIT_7_C()
-{
-  BIT_R8(registers.C, 7);
-}
-
-void CPU::BIT_7_D()
-{
-  BIT_R8(registers.D, 7);
-}
-
-void CPU::BIT_7_E()
-{
-  BIT_R8(registers.E, 7);
-}
-
-void CPU::BIT_7_H()
-{
-  BIT_R8(registers.H, 7);
-}
-
-void CPU::BIT_7_L()
-{
-  BIT_R8(registers.L, 7);
-}
-
-void CPU::BIT_7_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  BIT_R8(byte, 7);
-  mmu.Set(registers.HL, byte);
-}
-
-void CPU::BIT_7_A()
+/**********************************************************************************/
+/* Opcode Tables                                                                  */
+/**********************************************************************************/
+namespace
 {
-  BIT_R8(registers.A, 7);
-}
 
-void CPU::RES_0_B()
+// Bytes and cycles an 8-bit operand adds on top of an instruction working on registers only.
+constexpr opcodes::Timing OperandCost(int operand)
 {
-  RES_R8(registers.B, 0);
-}
+  constexpr int dHL = 6;
+  constexpr int n8 = 8;
 
-void CPU::RES_0_C()
-{
-  RES_R8(registers.C, 0);
+  if (operand == dHL)
+  {
+    return {0, 4, 0};
+  }
+  if (operand == n8)
+  {
+    return {1, 4, 0};
+  }
+  return {0, 0, 0};
 }
 
-void CPU::RES_0_D()
+constexpr opcodes::Timing operator+(const opcodes::Timing& a, const opcodes::Timing& b)
 {
-  RES_R8(registers.D, 0);
+  return {a.length + b.length, a.cycles + b.cycles, a.cyclesNotTaken + b.cyclesNotTaken};
 }
 
-void CPU::RES_0_E()
-{
-  RES_R8(registers.E, 0);
-}
+constexpr opcodes::Timing invalidTiming = {0, 0, 0};
 
-void CPU::RES_0_H()
+/**
+ * @brief Length and cycles of an unprefixed opcode, derived from the same decoding the handlers are generated from.
+ */
+constexpr opcodes::Timing DecodeTiming(std::uint8_t opcode)
 {
-  RES_R8(registers.H, 0);
-}
+  const int x = opcode >> 6;
+  const int y = (opcode >> 3) & 7;
+  const int z = opcode & 7;
+  const int p = y >> 1;
+  const bool q = y & 1;
 
-void CPU::RES_0_L()
-{
-  RES_R8(registers.L, 0);
-}
+  constexpr int n8 = 8;
 
-void CPU::RES_0_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  RES_R8(byte, 0);
-  mmu.Set(registers.HL, byte);
-}
+  if (x == 1)
+  {
+    if (opcode == 0x76)
+    {
+      return {1, 4, 0}; // HALT
+    }
+    return opcodes::Timing{1, 4, 0} + OperandCost(y) + OperandCost(z); // LD r,r
+  }
+  if (x == 2)
+  {
+    return opcodes::Timing{1, 4, 0} + OperandCost(z); // ALU A,r
+  }
 
-void CPU::RES_0_A()
-{
-  RES_R8(registers.A, 0);
-}
+  if (x == 0)
+  {
+    switch (z)
+    {
+    case 0:
+      if (y == 0)
+      {
+        return {1, 4, 0}; // NOP
+      }
+      if (y == 1)
+      {
+        return {3, 20, 0}; // LD (a16),SP
+      }
+      if (y == 2)
+      {
+        return {2, 4, 0}; // STOP n8
+      }
+      return (y == 3) ? opcodes::Timing{2, 12, 0} : opcodes::Timing{2, 12, 8}; // JR (cc),e8
+    case 1:
+      return q ? opcodes::Timing{1, 8, 0} : opcodes::Timing{3, 12, 0}; // ADD HL,rr / LD rr,n16
+    case 2:
+    case 3:
+      return {1, 8, 0}; // LD (rr),A / LD A,(rr) / INC rr / DEC rr
+    case 4:
+    case 5:
+      return opcodes::Timing{1, 4, 0} + OperandCost(y) + OperandCost(y); // INC r / DEC r, (HL) is read and written
+    case 6:
+      return opcodes::Timing{1, 4, 0} + OperandCost(y) + OperandCost(n8); // LD r,n8
+    default:
+      return {1, 4, 0}; // Rotates on A, DAA, CPL, SCF, CCF
+    }
+  }
 
-void CPU::RES_1_B()
-{
-  RES_R8(registers.B, 1);
+  switch (z)
+  {
+  case 0:
+    if (y < 4)
+    {
+      return {1, 20, 8}; // RET cc
+    }
+    return (y == 5) ? opcodes::Timing{2, 16, 0} : opcodes::Timing{2, 12, 0}; // LDH (a8), ADD SP,e8, LD HL,SP+e8
+  case 1:
+    if (!q)
+    {
+      return {1, 12, 0}; // POP rr
+    }
+    if (p < 2)
+    {
+      return {1, 16, 0}; // RET / RETI
+    }
+    return (p == 2) ? opcodes::Timing{1, 4, 0} : opcodes::Timing{1, 8, 0}; // JP HL / LD SP,HL
+  case 2:
+    if (y < 4)
+    {
+      return {3, 16, 12}; // JP cc,a16
+    }
+    return (y & 1) ? opcodes::Timing{3, 16, 0} : opcodes::Timing{1, 8, 0}; // LD (a16) / LDH (C)
+  case 3:
+    if (y == 0)
+    {
+      return {3, 16, 0}; // JP a16
+    }
+    if (y == 1 || y >= 6)
+    {
+      return {1, 4, 0}; // CB prefix, DI, EI
+    }
+    return invalidTiming;
+  case 4:
+    return (y < 4) ? opcodes::Timing{3, 24, 12} : invalidTiming; // CALL cc,a16
+  case 5:
+    if (!q)
+    {
+      return {1, 16, 0}; // PUSH rr
+    }
+    return (p == 0) ? opcodes::Timing{3, 24, 0} : invalidTiming; // CALL a16
+  case 6:
+    return opcodes::Timing{1, 4, 0} + OperandCost(n8); // ALU A,n8
+  default:
+    return {1, 16, 0}; // RST
+  }
 }
 
-void CPU::RES_1_C()
+/**
+ * @brief Length and cycles of a CB prefixed opcode. BIT only reads (HL), everything else also writes it back.
+ */
+constexpr opcodes::Timing DecodeExtendedTiming(std::uint8_t opcode)
 {
-  RES_R8(registers.C, 1);
-}
+  const int x = opcode >> 6;
+  const int z = opcode & 7;
 
-void CPU::RES_1_D()
-{
-  RES_R8(registers.D, 1);
+  opcodes::Timing timing = opcodes::Timing{2, 8, 0} + OperandCost(z);
+  return (x == 1) ? timing : timing + OperandCost(z);
 }
 
-void CPU::RES_1_E()
+/**
+ * @brief First opcode whose derived timing differs from the documented one, -1 if they all agree.
+ */
+constexpr int FindTimingMismatch(const std::array<opcodes::Timing, 256>& documented,
+                                 opcodes::Timing (*decode)(std::uint8_t))
 {
-  RES_R8(registers.E, 1);
-}
+  for (int opcode = 0; opcode < 256; ++opcode)
+  {
+    if (decode(static_cast<std::uint8_t>(opcode)) != documented[opcode])
+    {
+      return opcode;
+    }
+  }
 
-void CPU::RES_1_H()
-{
-  RES_R8(registers.H, 1);
+  return -1;
 }
 
-void CPU::RES_1_L()
-{
-  RES_R8(registers.L, 1);
-}
+static_assert(FindTimingMismatch(opcodes::documentedTimings, DecodeTiming) == -1,
+              "Generated opcode length or cycles differ from opcodes::documentedTimings.");
+static_assert(FindTimingMismatch(opcodes::documentedExtendedTimings, DecodeExtendedTiming) == -1,
+              "Generated CB opcode length or cycles differ from opcodes::documentedExtendedTimings.");
 
-void CPU::RES_1_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  RES_R8(byte, 1);
-  mmu.Set(registers.HL, byte);
-}
+} // namespace
 
-void CPU::RES_1_A()
-{
-  RES_R8(registers.A, 1);
+/**
+ * @brief Handler of an unprefixed opcode, picked by decoding its x/y/z/p/q bit fields.
+ */
+template <std::uint8_t Opcode> constexpr CPU::OpcodeFunction CPU::GetHandler()
+{
+  constexpr int x = Opcode >> 6;
+  constexpr int y = (Opcode >> 3) & 7;
+  constexpr int z = Opcode & 7;
+  constexpr int p = y >> 1;
+  constexpr bool q = y & 1;
+
+  constexpr R8 target = static_cast<R8>(y);
+  constexpr R8 source = static_cast<R8>(z);
+  constexpr R16 pair = static_cast<R16>(p);
+  constexpr R16 stackPair = (p == 3) ? R16::AF : static_cast<R16>(p);
+  constexpr Condition condition = static_cast<Condition>(y & 3);
+  constexpr AluOperation aluOperation = static_cast<AluOperation>(y);
+
+  if constexpr (Opcode == 0x76)
+  {
+    return &CPU::HALT;
+  }
+  else if constexpr (x == 1)
+  {
+    return &CPU::LD_R_R<target, source>;
+  }
+  else if constexpr (x == 2)
+  {
+    return &CPU::ALU_A_R<aluOperation, source>;
+  }
+  else if constexpr (x == 0)
+  {
+    if constexpr (z == 0)
+    {
+      constexpr std::array<OpcodeFunction, 3> misc = {&CPU::NOP, &CPU::LD_DN16_SP, &CPU::STOP_N8};
+      if constexpr (y < 3)
+      {
+        return misc[y];
+      }
+      else if constexpr (y == 3)
+      {
+        return &CPU::JR_CC_E8<Condition::Always>;
+      }
+      else
+      {
+        return &CPU::JR_CC_E8<condition>;
+      }
+    }
+    else if constexpr (z == 1)
+    {
+      return q ? &CPU::ADD_HL_RR<pair> : &CPU::LD_RR_N16<pair>;
+    }
+    else if constexpr (z == 2)
+    {
+      return q ? &CPU::LD_A_dRR<static_cast<Indirect>(p)> : &CPU::LD_dRR_A<static_cast<Indirect>(p)>;
+    }
+    else if constexpr (z == 3)
+    {
+      return q ? &CPU::DEC_RR<pair> : &CPU::INC_RR<pair>;
+    }
+    else if constexpr (z == 4)
+    {
+      return &CPU::INC_R<target>;
+    }
+    else if constexpr (z == 5)
+    {
+      return &CPU::DEC_R<target>;
+    }
+    else if constexpr (z == 6)
+    {
+      return &CPU::LD_R_R<target, R8::N8>;
+    }
+    else
+    {
+      constexpr std::array<OpcodeFunction, 8> accumulator = {&CPU::RLCA, &CPU::RRCA, &CPU::RLA, &CPU::RRA,
+                                                             &CPU::DAA,  &CPU::CPL,  &CPU::SCF, &CPU::CCF};
+      return accumulator[y];
+    }
+  }
+  else
+  {
+    if constexpr (z == 0)
+    {
+      constexpr std::array<OpcodeFunction, 4> high = {&CPU::LDH_dA8_A, &CPU::ADD_SP_E8, &CPU::LDH_A_dA8,
+                                                      &CPU::LD_HL_SP_p_E8};
+      if constexpr (y < 4)
+      {
+        return &CPU::RET_CC<condition>;
+      }
+      else
+      {
+        return high[y - 4];
+      }
+    }
+    else if constexpr (z == 1)
+    {
+      constexpr std::array<OpcodeFunction, 3> misc = {&CPU::RETI, &CPU::JP_HL, &CPU::LD_SP_HL};
+      if constexpr (!q)
+      {
+        return &CPU::POP_RR<stackPair>;
+      }
+      else if constexpr (p == 0)
+      {
+        return &CPU::RET_CC<Condition::Always>;
+      }
+      else
+      {
+        return misc[p - 1];
+      }
+    }
+    else if constexpr (z == 2)
+    {
+      constexpr std::array<OpcodeFunction, 4> loads = {&CPU::LDH_dC_A, &CPU::LD_dA16_A, &CPU::LDH_A_dC,
+                                                       &CPU::LD_A_dA16};
+      if constexpr (y < 4)
+      {
+        return &CPU::JP_CC_A16<condition>;
+      }
+      else
+      {
+        return loads[y - 4];
+      }
+    }
+    else if constexpr (z == 3)
+    {
+      // 0xCB is the prefix and never dispatched through here, the other invalid opcodes lock up the CPU.
+      constexpr std::array<OpcodeFunction, 8> misc = {&CPU::NOP,    &CPU::NOP,    &CPU::LOCKUP, &CPU::LOCKUP,
+                                                      &CPU::LOCKUP, &CPU::LOCKUP, &CPU::DI,     &CPU::EI};
+      if constexpr (y == 0)
+      {
+        return &CPU::JP_CC_A16<Condition::Always>;
+      }
+      else
+      {
+        return misc[y];
+      }
+    }
+    else if constexpr (z == 4)
+    {
+      if constexpr (y < 4)
+      {
+        return &CPU::CALL_CC_A16<condition>;
+      }
+      else
+      {
+        return &CPU::LOCKUP;
+      }
+    }
+    else if constexpr (z == 5)
+    {
+      if constexpr (!q)
+      {
+        return &CPU::PUSH_RR<stackPair>;
+      }
+      else
+      {
+        return (p == 0) ? &CPU::CALL_CC_A16<Condition::Always> : &CPU::LOCKUP;
+      }
+    }
+    else if constexpr (z == 6)
+    {
+      return &CPU::ALU_A_R<aluOperation, R8::N8>;
+    }
+    else
+    {
+      return &CPU::RST_N<y * 8>;
+    }
+  }
 }
 
-void CPU::RES_2_B()
+template <std::uint8_t Opcode> constexpr CPU::OpcodeFunction CPU::GetExtendedHandler()
 {
-  RES_R8(registers.B, 2);
-}
+  constexpr int x = Opcode >> 6;
+  constexpr int y = (Opcode >> 3) & 7;
+  constexpr R8 target = static_cast<R8>(Opcode & 7);
 
-void CPU::RES_2_C()
-{
-  RES_R8(registers.C, 2);
+  if constexpr (x == 0)
+  {
+    return &CPU::SHIFT_R<static_cast<ShiftOperation>(y), target>;
+  }
+  else if constexpr (x == 1)
+  {
+    return &CPU::BIT_R<y, target>;
+  }
+  else if constexpr (x == 2)
+  {
+    return &CPU::RES_R<y, target>;
+  }
+  else
+  {
+    return &CPU::SET_R<y, target>;
+  }
 }
 
-void CPU::RES_2_D()
+/**
+ * @brief Fetches the operand and runs the handler of a compile time opcode, both fold into the caller.
+ *
+ * Instructions the block cache decoded already have their operand latched and only move PC past themselves.
+ */
+template <std::uint8_t Opcode, bool Decoded> void CPU::Execute()
 {
-  RES_R8(registers.D, 2);
-}
+  constexpr opcodes::Timing timing = DecodeTiming(Opcode);
+  std::uint64_t profileStart = ProfileBegin();
 
-void CPU::RES_2_E()
-{
-  RES_R8(registers.E, 2);
-}
+  if constexpr (Decoded)
+  {
+    registers.PC += timing.length;
+  }
+  else
+  {
+    FetchOperand<timing.length>();
+  }
+  (this->*GetHandler<Opcode>())();
 
-void CPU::RES_2_H()
-{
-  RES_R8(registers.H, 2);
-}
+  if constexpr (timing.cyclesNotTaken != 0)
+  {
+    cycleCount += branchTaken ? timing.cycles : timing.cyclesNotTaken;
+  }
+  else
+  {
+    cycleCount += timing.cycles;
+  }
 
-void CPU::RES_2_L()
-{
-  RES_R8(registers.L, 2);
+  ProfileEnd(false, Opcode, profileStart);
 }
 
-void CPU::RES_2_dHL()
+template <std::uint8_t Opcode, bool Decoded> void CPU::ExecuteExtended()
 {
-  std::uint8_t byte = mmu.Get(registers.HL);
-  RES_R8(byte, 2);
-  mmu.Set(registers.HL, byte);
-}
+  constexpr opcodes::Timing timing = DecodeExtendedTiming(Opcode);
+  std::uint64_t profileStart = ProfileBegin();
 
-void CPU::RES_2_A()
-{
-  RES_R8(registers.A, 2);
-}
+  if constexpr (Decoded)
+  {
+    registers.PC += timing.length;
+  }
+  else
+  {
+    FetchOperand<timing.length>();
+  }
+  (this->*GetExtendedHandler<Opcode>())();
+  cycleCount += timing.cycles;
 
-void CPU::RES_3_B()
-{
-  RES_R8(registers.B, 3);
+  ProfileEnd(true, Opcode, profileStart);
 }
 
-void CPU::RES_3_C()
+template <std::uint8_t Opcode> void CPU::ExecuteDecoded(CPU& cpu)
 {
-  RES_R8(registers.C, 3);
+  cpu.Execute<Opcode, true>();
 }
 
-void CPU::RES_3_D()
+template <std::uint8_t Opcode> void CPU::ExecuteDecodedExtended(CPU& cpu)
 {
-  RES_R8(registers.D, 3);
+  cpu.ExecuteExtended<Opcode, true>();
 }
 
-void CPU::RES_3_E()
+template <std::uint8_t Opcode> void CPU::Invoke(CPU& cpu)
 {
-  RES_R8(registers.E, 3);
+  (cpu.*GetHandler<Opcode>())();
 }
 
-void CPU::RES_3_H()
+template <std::uint8_t Opcode> void CPU::InvokeExtended(CPU& cpu)
 {
-  RES_R8(registers.H, 3);
+  (cpu.*GetExtendedHandler<Opcode>())();
 }
 
-void CPU::RES_3_L()
+template <std::size_t... Opcodes>
+constexpr std::array<CPU::OpcodeDescription, 256> CPU::MakeOpcodeTable(std::index_sequence<Opcodes...>)
 {
-  RES_R8(registers.L, 3);
+  return {{{&CPU::Invoke<Opcodes>, static_cast<std::uint8_t>(DecodeTiming(Opcodes).length),
+            static_cast<std::uint8_t>(DecodeTiming(Opcodes).cycles),
+            static_cast<std::uint8_t>(DecodeTiming(Opcodes).cyclesNotTaken)}...}};
 }
 
-void CPU::RES_3_dHL()
+template <std::size_t... Opcodes>
+constexpr std::array<CPU::OpcodeDescription, 256> CPU::MakeExtendedOpcodeTable(std::index_sequence<Opcodes...>)
 {
-  std::uint8_t byte = mmu.Get(registers.HL);
-  RES_R8(byte, 3);
-  mmu.Set(registers.HL, byte);
+  return {{{&CPU::InvokeExtended<Opcodes>, static_cast<std::uint8_t>(DecodeExtendedTiming(Opcodes).length),
+            static_cast<std::uint8_t>(DecodeExtendedTiming(Opcodes).cycles),
+            static_cast<std::uint8_t>(DecodeExtendedTiming(Opcodes).cyclesNotTaken)}...}};
 }
 
-void CPU::RES_3_A()
+template <std::size_t... Opcodes>
+constexpr std::array<BlockCache::Executor, 256> CPU::MakeDecodedExecutors(std::index_sequence<Opcodes...>)
 {
-  RES_R8(registers.A, 3);
+  return {{&CPU::ExecuteDecoded<Opcodes>...}};
 }
 
-void CPU::RES_4_B()
+template <std::size_t... Opcodes>
+constexpr std::array<BlockCache::Executor, 256> CPU::MakeDecodedExtendedExecutors(std::index_sequence<Opcodes...>)
 {
-  RES_R8(registers.B, 4);
+  return {{&CPU::ExecuteDecodedExtended<Opcodes>...}};
 }
 
-void CPU::RES_4_C()
-{
-  RES_R8(registers.C, 4);
-}
+static_assert(sizeof(CPU::OpcodeDescription) <= 16, "Opcode descriptions no longer pack four to a cache line.");
 
-void CPU::RES_4_D()
-{
-  RES_R8(registers.D, 4);
-}
+alignas(64) constexpr std::array<CPU::OpcodeDescription, 256> CPU::opcodeTable =
+    MakeOpcodeTable(std::make_index_sequence<256>{});
+alignas(64) constexpr std::array<CPU::OpcodeDescription, 256> CPU::extendedOpcodeTable =
+    MakeExtendedOpcodeTable(std::make_index_sequence<256>{});
+constexpr std::array<BlockCache::Executor, 256> CPU::decodedExecutors =
+    MakeDecodedExecutors(std::make_index_sequence<256>{});
+constexpr std::array<BlockCache::Executor, 256> CPU::decodedExtendedExecutors =
+    MakeDecodedExtendedExecutors(std::make_index_sequence<256>{});
 
-void CPU::RES_4_E()
+/**********************************************************************************/
+/* Idle Loops                                                                     */
+/**********************************************************************************/
+namespace
 {
-  RES_R8(registers.E, 4);
-}
 
-void CPU::RES_4_H()
+/**
+ * @brief Whether an opcode only reads memory and changes nothing but registers.
+ *
+ * Memory writes, the stack, control flow, HALT, STOP, EI and DI are all excluded.
+ */
+constexpr bool OnlyReadsMemory(std::uint8_t opcode)
 {
-  RES_R8(registers.H, 4);
-}
+  const int x = opcode >> 6;
+  const int y = (opcode >> 3) & 7;
+  const int z = opcode & 7;
 
-void CPU::RES_4_L()
-{
-  RES_R8(registers.L, 4);
+  switch (x)
+  {
+  case 0:
+    switch (z)
+    {
+    case 0:
+      return y == 0; // NOP
+    case 2:
+      return y & 1; // LD A,(rr)
+    case 4:
+    case 5:
+    case 6:
+      return y != 6; // INC r, DEC r, LD r,n8
+    default:
+      return true; // LD rr,n16, ADD HL,rr, INC rr, DEC rr, rotates on A, DAA, CPL, SCF, CCF
+    }
+  case 1:
+    return y != 6; // LD r,r
+  case 2:
+    return true; // ALU A,r
+  default:
+    return z == 6 || opcode == 0xE8 || opcode == 0xF0 || opcode == 0xF2 || opcode == 0xF8 || opcode == 0xF9 ||
+           opcode == 0xFA;
+  }
 }
 
-void CPU::RES_4_dHL()
+/**
+ * @brief Whether a CB prefixed opcode leaves memory alone, only BIT may touch (HL).
+ */
+constexpr bool OnlyReadsMemoryExtended(std::uint8_t opcode)
 {
-  std::uint8_t byte = mmu.Get(registers.HL);
-  RES_R8(byte, 4);
-  mmu.Set(registers.HL, byte);
+  return (opcode & 7) != 6 || (opcode >> 6) == 1;
 }
 
-void CPU::RES_4_A()
-{
-  RES_R8(registers.A, 4);
-}
+} // namespace
 
-void CPU::RES_5_B()
+/**
+ * @brief Checks whether start..branch is a short loop whose body only reads memory and registers.
+ */
+void CPU::AnalyzeIdleLoop(std::uint16_t start, std::uint16_t branch)
 {
-  RES_R8(registers.B, 5);
-}
+  idleLoop.start = start;
+  idleLoop.branch = branch;
+  idleLoop.pollsOnly = false;
 
-void CPU::RES_5_C()
-{
-  RES_R8(registers.C, 5);
-}
+  if (branch - start > IdleLoop::maxSize)
+  {
+    return;
+  }
 
-void CPU::RES_5_D()
-{
-  RES_R8(registers.D, 5);
-}
+  int cycles = 0;
+  std::uint16_t address = start;
 
-void CPU::RES_5_E()
-{
-  RES_R8(registers.E, 5);
-}
+  while (address < branch)
+  {
+    std::uint8_t opcode = mmu.Get(address);
+    const OpcodeDescription* description = &opcodeTable[opcode];
 
-void CPU::RES_5_H()
-{
-  RES_R8(registers.H, 5);
-}
+    if (opcode == extendedOpcodePrefix)
+    {
+      opcode = mmu.Get(address + 1);
+      description = &extendedOpcodeTable[opcode];
 
-void CPU::RES_5_L()
-{
-  RES_R8(registers.L, 5);
-}
+      if (!OnlyReadsMemoryExtended(opcode))
+      {
+        return;
+      }
+    }
+    else if (!OnlyReadsMemory(opcode))
+    {
+      return;
+    }
 
-void CPU::RES_5_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  RES_R8(byte, 5);
-  mmu.Set(registers.HL, byte);
-}
+    cycles += description->cycles;
+    address += description->length;
+  }
 
-void CPU::RES_5_A()
-{
-  RES_R8(registers.A, 5);
-}
+  if (address != branch)
+  {
+    return;
+  }
 
-void CPU::RES_6_B()
-{
-  RES_R8(registers.B, 6);
+  idleLoop.branchCycles = opcodeTable[mmu.Get(branch)].cycles;
+  idleLoop.cycles = cycles + idleLoop.branchCycles;
+  idleLoop.pollsOnly = true;
 }
 
-void CPU::RES_6_C()
+/**
+ * @brief Called right after a taken backward branch, fast forwards a loop that keeps ending up in the same state.
+ *
+ * Nothing in the loop writes memory, so once an iteration left every register as it was, all following iterations
+ * do the same until an event changes what the loop reads. Whole iterations up to the next event are skipped, after
+ * which the loop runs normally again, so the outcome is identical to running it. Handlers call this before the
+ * cycles of the branch itself are counted, native code after.
+ */
+void CPU::SkipIdleLoop(std::uint16_t branch, bool branchCounted)
 {
-  RES_R8(registers.C, 6);
-}
+  // Skipped iterations would have hit their breakpoints and watchpoints.
+  if (HasDebugHooks())
+  {
+    return;
+  }
 
-void CPU::RES_6_D()
-{
-  RES_R8(registers.D, 6);
-}
+  bool known = idleLoop.start == registers.PC && idleLoop.branch == branch;
+  if (!known)
+  {
+    AnalyzeIdleLoop(registers.PC, branch);
+  }
 
-void CPU::RES_6_E()
-{
-  RES_R8(registers.E, 6);
-}
+  if (!idleLoop.pollsOnly)
+  {
+    return;
+  }
 
-void CPU::RES_6_H()
-{
-  RES_R8(registers.H, 6);
-}
+  std::uint64_t head = branchCounted ? cycleCount : cycleCount + idleLoop.branchCycles;
+  State state = GetState();
 
-void CPU::RES_6_L()
-{
-  RES_R8(registers.L, 6);
-}
+  // Only the same state exactly one iteration ago, with no event handled since, proves nothing but the loop body ran
+  // in between.
+  bool fixedPoint = known && state == idleLoop.state && head == idleLoop.head + idleLoop.cycles &&
+                    scheduler.DispatchCount() == idleLoop.eventsDispatched;
+  idleLoop.state = state;
+  idleLoop.head = head;
+  idleLoop.eventsDispatched = scheduler.DispatchCount();
 
-void CPU::RES_6_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  RES_R8(byte, 6);
-  mmu.Set(registers.HL, byte);
-}
+  std::uint64_t nextEvent = scheduler.NextCycle();
+  if (!fixedPoint || nextEvent == Scheduler::never || nextEvent <= head || IsInterruptDue())
+  {
+    return;
+  }
 
-void CPU::RES_6_A()
-{
-  RES_R8(registers.A, 6);
+  std::uint64_t skipped = (nextEvent - head) / idleLoop.cycles * idleLoop.cycles;
+  cycleCount += skipped;
+  idleCyclesSkipped += skipped;
+  idleLoop.head += skipped;
 }
 
-void CPU::RES_7_B()
+/**********************************************************************************/
+/* Threaded Interpreter                                                           */
+/**********************************************************************************/
+/**
+ * @brief Executes up to instructionCount instructions, running every event as it becomes due.
+ *
+ * Between events the selected dispatch runs uninterrupted. A CPU that is still halted after the due events ran
+ * sleeps until the next event and returns, that event runs on the next call. A debugger pause returns early too.
+ */
+std::uint64_t CPU::Run(std::uint64_t instructionCount)
 {
-  RES_R8(registers.B, 7);
-}
+  std::uint64_t executed = 0;
 
-void CPU::RES_7_C()
-{
-  RES_R8(registers.C, 7);
-}
+  while (executed < instructionCount && !paused)
+  {
+    if (cycleCount >= scheduler.NextCycle())
+    {
+      scheduler.RunDue(cycleCount);
+    }
 
-void CPU::RES_7_D()
-{
-  RES_R8(registers.D, 7);
-}
+    if (halted && !WakeFromHalt())
+    {
+      break;
+    }
 
-void CPU::RES_7_E()
-{
-  RES_R8(registers.E, 7);
-}
+    executed += RunUntilEvent(instructionCount - executed);
+  }
 
-void CPU::RES_7_H()
-{
-  RES_R8(registers.H, 7);
+  return executed;
 }
 
-void CPU::RES_7_L()
+/**
+ * @brief Executes whole instructions until at least cycles T-cycles have passed and returns how many did.
+ *
+ * The end of the batch is an event like any other, so the dispatch runs uninterrupted up to it and a halted CPU
+ * sleeps right up to it. The result exceeds cycles by whatever the last instruction or interrupt dispatch overran,
+ * or falls short of it if the debugger paused.
+ */
+std::uint64_t CPU::RunCycles(std::uint64_t cycles)
 {
-  RES_R8(registers.L, 7);
-}
+  const std::uint64_t start = cycleCount;
+  const std::uint64_t end = start + cycles;
 
-void CPU::RES_7_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  RES_R8(byte, 7);
-  mmu.Set(registers.HL, byte);
-}
+  scheduler.Schedule(runLimitEvent, end);
 
-void CPU::RES_7_A()
-{
-  RES_R8(registers.A, 7);
-}
+  while (cycleCount < end && !paused)
+  {
+    if (cycleCount >= scheduler.NextCycle())
+    {
+      scheduler.RunDue(cycleCount);
+    }
 
-void CPU::SET_0_B()
-{
-  SET_R8(registers.B, 0);
-}
+    // Sleeping moves cycleCount to the next event at the latest, which the loop then runs.
+    if (halted && !WakeFromHalt())
+    {
+      continue;
+    }
 
-void CPU::SET_0_C()
-{
-  SET_R8(registers.C, 0);
-}
+    RunUntilEvent(std::numeric_limits<std::uint64_t>::max());
+  }
 
-void CPU::SET_0_D()
-{
-  SET_R8(registers.D, 0);
+  scheduler.Cancel(runLimitEvent);
+  return cycleCount - start;
 }
 
-void CPU::SET_0_E()
+/**
+ * @brief Executes up to instructionCount instructions, stops early on HALT and once the next event is due.
+ */
+std::uint64_t CPU::RunUntilEvent(std::uint64_t instructionCount)
 {
-  SET_R8(registers.E, 0);
-}
+  if (HasDebugHooks())
+  {
+    return RunDebug(instructionCount);
+  }
+  if (dispatch == Dispatch::Threaded)
+  {
+    return RunThreaded(instructionCount);
+  }
+  if (dispatch == Dispatch::BlockCache)
+  {
+    return RunBlockCache(instructionCount);
+  }
+  if (dispatch == Dispatch::Jit)
+  {
+    return RunJit(instructionCount);
+  }
 
-void CPU::SET_0_H()
-{
-  SET_R8(registers.H, 0);
-}
+  std::uint64_t executed = 0;
+  while (executed < instructionCount && !halted && cycleCount < scheduler.NextCycle())
+  {
+    Tick();
+    ++executed;
+  }
 
-void CPU::SET_0_L()
-{
-  SET_R8(registers.L, 0);
+  return executed;
 }
 
-void CPU::SET_0_dHL()
+/**
+ * @brief Executes up to instructionCount instructions in one loop without going through the opcode tables.
+ *
+ * Every case is a direct call into the handler with the instruction length known at compile time, so operand
+ * fetch and PC advance fold into the case and there is no indirect call per instruction.
+ */
+std::uint64_t CPU::RunThreaded(std::uint64_t instructionCount)
 {
-  std::uint8_t byte = mmu.Get(registers.HL);
-  SET_R8(byte, 0);
-  mmu.Set(registers.HL, byte);
-}
+  std::uint64_t executed = 0;
 
-void CPU::SET_0_A()
-{
-  SET_R8(registers.A, 0);
-}
+  while (executed < instructionCount && !halted && cycleCount < scheduler.NextCycle())
+  {
+    TraceInstruction();
 
-void CPU::SET_1_B()
-{
-  SET_R8(registers.B, 1);
-}
+    // clang-format off
+    switch (mmu.Get(registers.PC))
+    {
+    case 0x00: Execute<0x00>(); break;
+    case 0x01: Execute<0x01>(); break;
+    case 0x02: Execute<0x02>(); break;
+    case 0x03: Execute<0x03>(); break;
+    case 0x04: Execute<0x04>(); break;
+    case 0x05: Execute<0x05>(); break;
+    case 0x06: Execute<0x06>(); break;
+    case 0x07: Execute<0x07>(); break;
+    case 0x08: Execute<0x08>(); break;
+    case 0x09: Execute<0x09>(); break;
+    case 0x0A: Execute<0x0A>(); break;
+    case 0x0B: Execute<0x0B>(); break;
+    case 0x0C: Execute<0x0C>(); break;
+    case 0x0D: Execute<0x0D>(); break;
+    case 0x0E: Execute<0x0E>(); break;
+    case 0x0F: Execute<0x0F>(); break;
+    case 0x10: Execute<0x10>(); break;
+    case 0x11: Execute<0x11>(); break;
+    case 0x12: Execute<0x12>(); break;
+    case 0x13: Execute<0x13>(); break;
+    case 0x14: Execute<0x14>(); break;
+    case 0x15: Execute<0x15>(); break;
+    case 0x16: Execute<0x16>(); break;
+    case 0x17: Execute<0x17>(); break;
+    case 0x18: Execute<0x18>(); break;
+    case 0x19: Execute<0x19>(); break;
+    case 0x1A: Execute<0x1A>(); break;
+    case 0x1B: Execute<0x1B>(); break;
+    case 0x1C: Execute<0x1C>(); break;
+    case 0x1D: Execute<0x1D>(); break;
+    case 0x1E: Execute<0x1E>(); break;
+    case 0x1F: Execute<0x1F>(); break;
+    case 0x20: Execute<0x20>(); break;
+    case 0x21: Execute<0x21>(); break;
+    case 0x22: Execute<0x22>(); break;
+    case 0x23: Execute<0x23>(); break;
+    case 0x24: Execute<0x24>(); break;
+    case 0x25: Execute<0x25>(); break;
+    case 0x26: Execute<0x26>(); break;
+    case 0x27: Execute<0x27>(); break;
+    case 0x28: Execute<0x28>(); break;
+    case 0x29: Execute<0x29>(); break;
+    case 0x2A: Execute<0x2A>(); break;
+    case 0x2B: Execute<0x2B>(); break;
+    case 0x2C: Execute<0x2C>(); break;
+    case 0x2D: Execute<0x2D>(); break;
+    case 0x2E: Execute<0x2E>(); break;
+    case 0x2F: Execute<0x2F>(); break;
+    case 0x30: Execute<0x30>(); break;
+    case 0x31: Execute<0x31>(); break;
+    case 0x32: Execute<0x32>(); break;
+    case 0x33: Execute<0x33>(); break;
+    case 0x34: Execute<0x34>(); break;
+    case 0x35: Execute<0x35>(); break;
+    case 0x36: Execute<0x36>(); break;
+    case 0x37: Execute<0x37>(); break;
+    case 0x38: Execute<0x38>(); break;
+    case 0x39: Execute<0x39>(); break;
+    case 0x3A: Execute<0x3A>(); break;
+    case 0x3B: Execute<0x3B>(); break;
+    case 0x3C: Execute<0x3C>(); break;
+    case 0x3D: Execute<0x3D>(); break;
+    case 0x3E: Execute<0x3E>(); break;
+    case 0x3F: Execute<0x3F>(); break;
+    case 0x40: Execute<0x40>(); break;
+    case 0x41: Execute<0x41>(); break;
+    case 0x42: Execute<0x42>(); break;
+    case 0x43: Execute<0x43>(); break;
+    case 0x44: Execute<0x44>(); break;
+    case 0x45: Execute<0x45>(); break;
+    case 0x46: Execute<0x46>(); break;
+    case 0x47: Execute<0x47>(); break;
+    case 0x48: Execute<0x48>(); break;
+    case 0x49: Execute<0x49>(); break;
+    case 0x4A: Execute<0x4A>(); break;
+    case 0x4B: Execute<0x4B>(); break;
+    case 0x4C: Execute<0x4C>(); break;
+    case 0x4D: Execute<0x4D>(); break;
+    case 0x4E: Execute<0x4E>(); break;
+    case 0x4F: Execute<0x4F>(); break;
+    case 0x50: Execute<0x50>(); break;
+    case 0x51: Execute<0x51>(); break;
+    case 0x52: Execute<0x52>(); break;
+    case 0x53: Execute<0x53>(); break;
+    case 0x54: Execute<0x54>(); break;
+    case 0x55: Execute<0x55>(); break;
+    case 0x56: Execute<0x56>(); break;
+    case 0x57: Execute<0x57>(); break;
+    case 0x58: Execute<0x58>(); break;
+    case 0x59: Execute<0x59>(); break;
+    case 0x5A: Execute<0x5A>(); break;
+    case 0x5B: Execute<0x5B>(); break;
+    case 0x5C: Execute<0x5C>(); break;
+    case 0x5D: Execute<0x5D>(); break;
+    case 0x5E: Execute<0x5E>(); break;
+    case 0x5F: Execute<0x5F>(); break;
+    case 0x60: Execute<0x60>(); break;
+    case 0x61: Execute<0x61>(); break;
+    case 0x62: Execute<0x62>(); break;
+    case 0x63: Execute<0x63>(); break;
+    case 0x64: Execute<0x64>(); break;
+    case 0x65: Execute<0x65>(); break;
+    case 0x66: Execute<0x66>(); break;
+    case 0x67: Execute<0x67>(); break;
+    case 0x68: Execute<0x68>(); break;
+    case 0x69: Execute<0x69>(); break;
+    case 0x6A: Execute<0x6A>(); break;
+    case 0x6B: Execute<0x6B>(); break;
+    case 0x6C: Execute<0x6C>(); break;
+    case 0x6D: Execute<0x6D>(); break;
+    case 0x6E: Execute<0x6E>(); break;
+    case 0x6F: Execute<0x6F>(); break;
+    case 0x70: Execute<0x70>(); break;
+    case 0x71: Execute<0x71>(); break;
+    case 0x72: Execute<0x72>(); break;
+    case 0x73: Execute<0x73>(); break;
+    case 0x74: Execute<0x74>(); break;
+    case 0x75: Execute<0x75>(); break;
+    case 0x76: Execute<0x76>(); break;
+    case 0x77: Execute<0x77>(); break;
+    case 0x78: Execute<0x78>(); break;
+    case 0x79: Execute<0x79>(); break;
+    case 0x7A: Execute<0x7A>(); break;
+    case 0x7B: Execute<0x7B>(); break;
+    case 0x7C: Execute<0x7C>(); break;
+    case 0x7D: Execute<0x7D>(); break;
+    case 0x7E: Execute<0x7E>(); break;
+    case 0x7F: Execute<0x7F>(); break;
+    case 0x80: Execute<0x80>(); break;
+    case 0x81: Execute<0x81>(); break;
+    case 0x82: Execute<0x82>(); break;
+    case 0x83: Execute<0x83>(); break;
+    case 0x84: Execute<0x84>(); break;
+    case 0x85: Execute<0x85>(); break;
+    case 0x86: Execute<0x86>(); break;
+    case 0x87: Execute<0x87>(); break;
+    case 0x88: Execute<0x88>(); break;
+    case 0x89: Execute<0x89>(); break;
+    case 0x8A: Execute<0x8A>(); break;
+    case 0x8B: Execute<0x8B>(); break;
+    case 0x8C: Execute<0x8C>(); break;
+    case 0x8D: Execute<0x8D>(); break;
+    case 0x8E: Execute<0x8E>(); break;
+    case 0x8F: Execute<0x8F>(); break;
+    case 0x90: Execute<0x90>(); break;
+    case 0x91: Execute<0x91>(); break;
+    case 0x92: Execute<0x92>(); break;
+    case 0x93: Execute<0x93>(); break;
+    case 0x94: Execute<0x94>(); break;
+    case 0x95: Execute<0x95>(); break;
+    case 0x96: Execute<0x96>(); break;
+    case 0x97: Execute<0x97>(); break;
+    case 0x98: Execute<0x98>(); break;
+    case 0x99: Execute<0x99>(); break;
+    case 0x9A: Execute<0x9A>(); break;
+    case 0x9B: Execute<0x9B>(); break;
+    case 0x9C: Execute<0x9C>(); break;
+    case 0x9D: Execute<0x9D>(); break;
+    case 0x9E: Execute<0x9E>(); break;
+    case 0x9F: Execute<0x9F>(); break;
+    case 0xA0: Execute<0xA0>(); break;
+    case 0xA1: Execute<0xA1>(); break;
+    case 0xA2: Execute<0xA2>(); break;
+    case 0xA3: Execute<0xA3>(); break;
+    case 0xA4: Execute<0xA4>(); break;
+    case 0xA5: Execute<0xA5>(); break;
+    case 0xA6: Execute<0xA6>(); break;
+    case 0xA7: Execute<0xA7>(); break;
+    case 0xA8: Execute<0xA8>(); break;
+    case 0xA9: Execute<0xA9>(); break;
+    case 0xAA: Execute<0xAA>(); break;
+    case 0xAB: Execute<0xAB>(); break;
+    case 0xAC: Execute<0xAC>(); break;
+    case 0xAD: Execute<0xAD>(); break;
+    case 0xAE: Execute<0xAE>(); break;
+    case 0xAF: Execute<0xAF>(); break;
+    case 0xB0: Execute<0xB0>(); break;
+    case 0xB1: Execute<0xB1>(); break;
+    case 0xB2: Execute<0xB2>(); break;
+    case 0xB3: Execute<0xB3>(); break;
+    case 0xB4: Execute<0xB4>(); break;
+    case 0xB5: Execute<0xB5>(); break;
+    case 0xB6: Execute<0xB6>(); break;
+    case 0xB7: Execute<0xB7>(); break;
+    case 0xB8: Execute<0xB8>(); break;
+    case 0xB9: Execute<0xB9>(); break;
+    case 0xBA: Execute<0xBA>(); break;
+    case 0xBB: Execute<0xBB>(); break;
+    case 0xBC: Execute<0xBC>(); break;
+    case 0xBD: Execute<0xBD>(); break;
+    case 0xBE: Execute<0xBE>(); break;
+    case 0xBF: Execute<0xBF>(); break;
+    case 0xC0: Execute<0xC0>(); break;
+    case 0xC1: Execute<0xC1>(); break;
+    case 0xC2: Execute<0xC2>(); break;
+    case 0xC3: Execute<0xC3>(); break;
+    case 0xC4: Execute<0xC4>(); break;
+    case 0xC5: Execute<0xC5>(); break;
+    case 0xC6: Execute<0xC6>(); break;
+    case 0xC7: Execute<0xC7>(); break;
+    case 0xC8: Execute<0xC8>(); break;
+    case 0xC9: Execute<0xC9>(); break;
+    case 0xCA: Execute<0xCA>(); break;
+    case 0xCB: ExecuteThreadedExtended(); break;
+    case 0xCC: Execute<0xCC>(); break;
+    case 0xCD: Execute<0xCD>(); break;
+    case 0xCE: Execute<0xCE>(); break;
+    case 0xCF: Execute<0xCF>(); break;
+    case 0xD0: Execute<0xD0>(); break;
+    case 0xD1: Execute<0xD1>(); break;
+    case 0xD2: Execute<0xD2>(); break;
+    case 0xD3: Execute<0xD3>(); break;
+    case 0xD4: Execute<0xD4>(); break;
+    case 0xD5: Execute<0xD5>(); break;
+    case 0xD6: Execute<0xD6>(); break;
+    case 0xD7: Execute<0xD7>(); break;
+    case 0xD8: Execute<0xD8>(); break;
+    case 0xD9: Execute<0xD9>(); break;
+    case 0xDA: Execute<0xDA>(); break;
+    case 0xDB: Execute<0xDB>(); break;
+    case 0xDC: Execute<0xDC>(); break;
+    case 0xDD: Execute<0xDD>(); break;
+    case 0xDE: Execute<0xDE>(); break;
+    case 0xDF: Execute<0xDF>(); break;
+    case 0xE0: Execute<0xE0>(); break;
+    case 0xE1: Execute<0xE1>(); break;
+    case 0xE2: Execute<0xE2>(); break;
+    case 0xE3: Execute<0xE3>(); break;
+    case 0xE4: Execute<0xE4>(); break;
+    case 0xE5: Execute<0xE5>(); break;
+    case 0xE6: Execute<0xE6>(); break;
+    case 0xE7: Execute<0xE7>(); break;
+    case 0xE8: Execute<0xE8>(); break;
+    case 0xE9: Execute<0xE9>(); break;
+    case 0xEA: Execute<0xEA>(); break;
+    case 0xEB: Execute<0xEB>(); break;
+    case 0xEC: Execute<0xEC>(); break;
+    case 0xED: Execute<0xED>(); break;
+    case 0xEE: Execute<0xEE>(); break;
+    case 0xEF: Execute<0xEF>(); break;
+    case 0xF0: Execute<0xF0>(); break;
+    case 0xF1: Execute<0xF1>(); break;
+    case 0xF2: Execute<0xF2>(); break;
+    case 0xF3: Execute<0xF3>(); break;
+    case 0xF4: Execute<0xF4>(); break;
+    case 0xF5: Execute<0xF5>(); break;
+    case 0xF6: Execute<0xF6>(); break;
+    case 0xF7: Execute<0xF7>(); break;
+    case 0xF8: Execute<0xF8>(); break;
+    case 0xF9: Execute<0xF9>(); break;
+    case 0xFA: Execute<0xFA>(); break;
+    case 0xFB: Execute<0xFB>(); break;
+    case 0xFC: Execute<0xFC>(); break;
+    case 0xFD: Execute<0xFD>(); break;
+    case 0xFE: Execute<0xFE>(); break;
+    case 0xFF: Execute<0xFF>(); break;
+    }
+    // clang-format on
 
-void CPU::SET_1_C()
-{
-  SET_R8(registers.C, 1);
-}
+    ++executed;
+    HandleInterrupts();
+  }
 
-void CPU::SET_1_D()
-{
-  SET_R8(registers.D, 1);
+  return executed;
 }
 
-void CPU::SET_1_E()
+void CPU::ExecuteThreadedExtended()
 {
-  SET_R8(registers.E, 1);
+  // clang-format off
+  switch (mmu.Get(registers.PC + 1))
+  {
+  case 0x00: ExecuteExtended<0x00>(); break;
+  case 0x01: ExecuteExtended<0x01>(); break;
+  case 0x02: ExecuteExtended<0x02>(); break;
+  case 0x03: ExecuteExtended<0x03>(); break;
+  case 0x04: ExecuteExtended<0x04>(); break;
+  case 0x05: ExecuteExtended<0x05>(); break;
+  case 0x06: ExecuteExtended<0x06>(); break;
+  case 0x07: ExecuteExtended<0x07>(); break;
+  case 0x08: ExecuteExtended<0x08>(); break;
+  case 0x09: ExecuteExtended<0x09>(); break;
+  case 0x0A: ExecuteExtended<0x0A>(); break;
+  case 0x0B: ExecuteExtended<0x0B>(); break;
+  case 0x0C: ExecuteExtended<0x0C>(); break;
+  case 0x0D: ExecuteExtended<0x0D>(); break;
+  case 0x0E: ExecuteExtended<0x0E>(); break;
+  case 0x0F: ExecuteExtended<0x0F>(); break;
+  case 0x10: ExecuteExtended<0x10>(); break;
+  case 0x11: ExecuteExtended<0x11>(); break;
+  case 0x12: ExecuteExtended<0x12>(); break;
+  case 0x13: ExecuteExtended<0x13>(); break;
+  case 0x14: ExecuteExtended<0x14>(); break;
+  case 0x15: ExecuteExtended<0x15>(); break;
+  case 0x16: ExecuteExtended<0x16>(); break;
+  case 0x17: ExecuteExtended<0x17>(); break;
+  case 0x18: ExecuteExtended<0x18>(); break;
+  case 0x19: ExecuteExtended<0x19>(); break;
+  case 0x1A: ExecuteExtended<0x1A>(); break;
+  case 0x1B: ExecuteExtended<0x1B>(); break;
+  case 0x1C: ExecuteExtended<0x1C>(); break;
+  case 0x1D: ExecuteExtended<0x1D>(); break;
+  case 0x1E: ExecuteExtended<0x1E>(); break;
+  case 0x1F: ExecuteExtended<0x1F>(); break;
+  case 0x20: ExecuteExtended<0x20>(); break;
+  case 0x21: ExecuteExtended<0x21>(); break;
+  case 0x22: ExecuteExtended<0x22>(); break;
+  case 0x23: ExecuteExtended<0x23>(); break;
+  case 0x24: ExecuteExtended<0x24>(); break;
+  case 0x25: ExecuteExtended<0x25>(); break;
+  case 0x26: ExecuteExtended<0x26>(); break;
+  case 0x27: ExecuteExtended<0x27>(); break;
+  case 0x28: ExecuteExtended<0x28>(); break;
+  case 0x29: ExecuteExtended<0x29>(); break;
+  case 0x2A: ExecuteExtended<0x2A>(); break;
+  case 0x2B: ExecuteExtended<0x2B>(); break;
+  case 0x2C: ExecuteExtended<0x2C>(); break;
+  case 0x2D: ExecuteExtended<0x2D>(); break;
+  case 0x2E: ExecuteExtended<0x2E>(); break;
+  case 0x2F: ExecuteExtended<0x2F>(); break;
+  case 0x30: ExecuteExtended<0x30>(); break;
+  case 0x31: ExecuteExtended<0x31>(); break;
+  case 0x32: ExecuteExtended<0x32>(); break;
+  case 0x33: ExecuteExtended<0x33>(); break;
+  case 0x34: ExecuteExtended<0x34>(); break;
+  case 0x35: ExecuteExtended<0x35>(); break;
+  case 0x36: ExecuteExtended<0x36>(); break;
+  case 0x37: ExecuteExtended<0x37>(); break;
+  case 0x38: ExecuteExtended<0x38>(); break;
+  case 0x39: ExecuteExtended<0x39>(); break;
+  case 0x3A: ExecuteExtended<0x3A>(); break;
+  case 0x3B: ExecuteExtended<0x3B>(); break;
+  case 0x3C: ExecuteExtended<0x3C>(); break;
+  case 0x3D: ExecuteExtended<0x3D>(); break;
+  case 0x3E: ExecuteExtended<0x3E>(); break;
+  case 0x3F: ExecuteExtended<0x3F>(); break;
+  case 0x40: ExecuteExtended<0x40>(); break;
+  case 0x41: ExecuteExtended<0x41>(); break;
+  case 0x42: ExecuteExtended<0x42>(); break;
+  case 0x43: ExecuteExtended<0x43>(); break;
+  case 0x44: ExecuteExtended<0x44>(); break;
+  case 0x45: ExecuteExtended<0x45>(); break;
+  case 0x46: ExecuteExtended<0x46>(); break;
+  case 0x47: ExecuteExtended<0x47>(); break;
+  case 0x48: ExecuteExtended<0x48>(); break;
+  case 0x49: ExecuteExtended<0x49>(); break;
+  case 0x4A: ExecuteExtended<0x4A>(); break;
+  case 0x4B: ExecuteExtended<0x4B>(); break;
+  case 0x4C: ExecuteExtended<0x4C>(); break;
+  case 0x4D: ExecuteExtended<0x4D>(); break;
+  case 0x4E: ExecuteExtended<0x4E>(); break;
+  case 0x4F: ExecuteExtended<0x4F>(); break;
+  case 0x50: ExecuteExtended<0x50>(); break;
+  case 0x51: ExecuteExtended<0x51>(); break;
+  case 0x52: ExecuteExtended<0x52>(); break;
+  case 0x53: ExecuteExtended<0x53>(); break;
+  case 0x54: ExecuteExtended<0x54>(); break;
+  case 0x55: ExecuteExtended<0x55>(); break;
+  case 0x56: ExecuteExtended<0x56>(); break;
+  case 0x57: ExecuteExtended<0x57>(); break;
+  case 0x58: ExecuteExtended<0x58>(); break;
+  case 0x59: ExecuteExtended<0x59>(); break;
+  case 0x5A: ExecuteExtended<0x5A>(); break;
+  case 0x5B: ExecuteExtended<0x5B>(); break;
+  case 0x5C: ExecuteExtended<0x5C>(); break;
+  case 0x5D: ExecuteExtended<0x5D>(); break;
+  case 0x5E: ExecuteExtended<0x5E>(); break;
+  case 0x5F: ExecuteExtended<0x5F>(); break;
+  case 0x60: ExecuteExtended<0x60>(); break;
+  case 0x61: ExecuteExtended<0x61>(); break;
+  case 0x62: ExecuteExtended<0x62>(); break;
+  case 0x63: ExecuteExtended<0x63>(); break;
+  case 0x64: ExecuteExtended<0x64>(); break;
+  case 0x65: ExecuteExtended<0x65>(); break;
+  case 0x66: ExecuteExtended<0x66>(); break;
+  case 0x67: ExecuteExtended<0x67>(); break;
+  case 0x68: ExecuteExtended<0x68>(); break;
+  case 0x69: ExecuteExtended<0x69>(); break;
+  case 0x6A: ExecuteExtended<0x6A>(); break;
+  case 0x6B: ExecuteExtended<0x6B>(); break;
+  case 0x6C: ExecuteExtended<0x6C>(); break;
+  case 0x6D: ExecuteExtended<0x6D>(); break;
+  case 0x6E: ExecuteExtended<0x6E>(); break;
+  case 0x6F: ExecuteExtended<0x6F>(); break;
+  case 0x70: ExecuteExtended<0x70>(); break;
+  case 0x71: ExecuteExtended<0x71>(); break;
+  case 0x72: ExecuteExtended<0x72>(); break;
+  case 0x73: ExecuteExtended<0x73>(); break;
+  case 0x74: ExecuteExtended<0x74>(); break;
+  case 0x75: ExecuteExtended<0x75>(); break;
+  case 0x76: ExecuteExtended<0x76>(); break;
+  case 0x77: ExecuteExtended<0x77>(); break;
+  case 0x78: ExecuteExtended<0x78>(); break;
+  case 0x79: ExecuteExtended<0x79>(); break;
+  case 0x7A: ExecuteExtended<0x7A>(); break;
+  case 0x7B: ExecuteExtended<0x7B>(); break;
+  case 0x7C: ExecuteExtended<0x7C>(); break;
+  case 0x7D: ExecuteExtended<0x7D>(); break;
+  case 0x7E: ExecuteExtended<0x7E>(); break;
+  case 0x7F: ExecuteExtended<0x7F>(); break;
+  case 0x80: ExecuteExtended<0x80>(); break;
+  case 0x81: ExecuteExtended<0x81>(); break;
+  case 0x82: ExecuteExtended<0x82>(); break;
+  case 0x83: ExecuteExtended<0x83>(); break;
+  case 0x84: ExecuteExtended<0x84>(); break;
+  case 0x85: ExecuteExtended<0x85>(); break;
+  case 0x86: ExecuteExtended<0x86>(); break;
+  case 0x87: ExecuteExtended<0x87>(); break;
+  case 0x88: ExecuteExtended<0x88>(); break;
+  case 0x89: ExecuteExtended<0x89>(); break;
+  case 0x8A: ExecuteExtended<0x8A>(); break;
+  case 0x8B: ExecuteExtended<0x8B>(); break;
+  case 0x8C: ExecuteExtended<0x8C>(); break;
+  case 0x8D: ExecuteExtended<0x8D>(); break;
+  case 0x8E: ExecuteExtended<0x8E>(); break;
+  case 0x8F: ExecuteExtended<0x8F>(); break;
+  case 0x90: ExecuteExtended<0x90>(); break;
+  case 0x91: ExecuteExtended<0x91>(); break;
+  case 0x92: ExecuteExtended<0x92>(); break;
+  case 0x93: ExecuteExtended<0x93>(); break;
+  case 0x94: ExecuteExtended<0x94>(); break;
+  case 0x95: ExecuteExtended<0x95>(); break;
+  case 0x96: ExecuteExtended<0x96>(); break;
+  case 0x97: ExecuteExtended<0x97>(); break;
+  case 0x98: ExecuteExtended<0x98>(); break;
+  case 0x99: ExecuteExtended<0x99>(); break;
+  case 0x9A: ExecuteExtended<0x9A>(); break;
+  case 0x9B: ExecuteExtended<0x9B>(); break;
+  case 0x9C: ExecuteExtended<0x9C>(); break;
+  case 0x9D: ExecuteExtended<0x9D>(); break;
+  case 0x9E: ExecuteExtended<0x9E>(); break;
+  case 0x9F: ExecuteExtended<0x9F>(); break;
+  case 0xA0: ExecuteExtended<0xA0>(); break;
+  case 0xA1: ExecuteExtended<0xA1>(); break;
+  case 0xA2: ExecuteExtended<0xA2>(); break;
+  case 0xA3: ExecuteExtended<0xA3>(); break;
+  case 0xA4: ExecuteExtended<0xA4>(); break;
+  case 0xA5: ExecuteExtended<0xA5>(); break;
+  case 0xA6: ExecuteExtended<0xA6>(); break;
+  case 0xA7: ExecuteExtended<0xA7>(); break;
+  case 0xA8: ExecuteExtended<0xA8>(); break;
+  case 0xA9: ExecuteExtended<0xA9>(); break;
+  case 0xAA: ExecuteExtended<0xAA>(); break;
+  case 0xAB: ExecuteExtended<0xAB>(); break;
+  case 0xAC: ExecuteExtended<0xAC>(); break;
+  case 0xAD: ExecuteExtended<0xAD>(); break;
+  case 0xAE: ExecuteExtended<0xAE>(); break;
+  case 0xAF: ExecuteExtended<0xAF>(); break;
+  case 0xB0: ExecuteExtended<0xB0>(); break;
+  case 0xB1: ExecuteExtended<0xB1>(); break;
+  case 0xB2: ExecuteExtended<0xB2>(); break;
+  case 0xB3: ExecuteExtended<0xB3>(); break;
+  case 0xB4: ExecuteExtended<0xB4>(); break;
+  case 0xB5: ExecuteExtended<0xB5>(); break;
+  case 0xB6: ExecuteExtended<0xB6>(); break;
+  case 0xB7: ExecuteExtended<0xB7>(); break;
+  case 0xB8: ExecuteExtended<0xB8>(); break;
+  case 0xB9: ExecuteExtended<0xB9>(); break;
+  case 0xBA: ExecuteExtended<0xBA>(); break;
+  case 0xBB: ExecuteExtended<0xBB>(); break;
+  case 0xBC: ExecuteExtended<0xBC>(); break;
+  case 0xBD: ExecuteExtended<0xBD>(); break;
+  case 0xBE: ExecuteExtended<0xBE>(); break;
+  case 0xBF: ExecuteExtended<0xBF>(); break;
+  case 0xC0: ExecuteExtended<0xC0>(); break;
+  case 0xC1: ExecuteExtended<0xC1>(); break;
+  case 0xC2: ExecuteExtended<0xC2>(); break;
+  case 0xC3: ExecuteExtended<0xC3>(); break;
+  case 0xC4: ExecuteExtended<0xC4>(); break;
+  case 0xC5: ExecuteExtended<0xC5>(); break;
+  case 0xC6: ExecuteExtended<0xC6>(); break;
+  case 0xC7: ExecuteExtended<0xC7>(); break;
+  case 0xC8: ExecuteExtended<0xC8>(); break;
+  case 0xC9: ExecuteExtended<0xC9>(); break;
+  case 0xCA: ExecuteExtended<0xCA>(); break;
+  case 0xCB: ExecuteExtended<0xCB>(); break;
+  case 0xCC: ExecuteExtended<0xCC>(); break;
+  case 0xCD: ExecuteExtended<0xCD>(); break;
+  case 0xCE: ExecuteExtended<0xCE>(); break;
+  case 0xCF: ExecuteExtended<0xCF>(); break;
+  case 0xD0: ExecuteExtended<0xD0>(); break;
+  case 0xD1: ExecuteExtended<0xD1>(); break;
+  case 0xD2: ExecuteExtended<0xD2>(); break;
+  case 0xD3: ExecuteExtended<0xD3>(); break;
+  case 0xD4: ExecuteExtended<0xD4>(); break;
+  case 0xD5: ExecuteExtended<0xD5>(); break;
+  case 0xD6: ExecuteExtended<0xD6>(); break;
+  case 0xD7: ExecuteExtended<0xD7>(); break;
+  case 0xD8: ExecuteExtended<0xD8>(); break;
+  case 0xD9: ExecuteExtended<0xD9>(); break;
+  case 0xDA: ExecuteExtended<0xDA>(); break;
+  case 0xDB: ExecuteExtended<0xDB>(); break;
+  case 0xDC: ExecuteExtended<0xDC>(); break;
+  case 0xDD: ExecuteExtended<0xDD>(); break;
+  case 0xDE: ExecuteExtended<0xDE>(); break;
+  case 0xDF: ExecuteExtended<0xDF>(); break;
+  case 0xE0: ExecuteExtended<0xE0>(); break;
+  case 0xE1: ExecuteExtended<0xE1>(); break;
+  case 0xE2: ExecuteExtended<0xE2>(); break;
+  case 0xE3: ExecuteExtended<0xE3>(); break;
+  case 0xE4: ExecuteExtended<0xE4>(); break;
+  case 0xE5: ExecuteExtended<0xE5>(); break;
+  case 0xE6: ExecuteExtended<0xE6>(); break;
+  case 0xE7: ExecuteExtended<0xE7>(); break;
+  case 0xE8: ExecuteExtended<0xE8>(); break;
+  case 0xE9: ExecuteExtended<0xE9>(); break;
+  case 0xEA: ExecuteExtended<0xEA>(); break;
+  case 0xEB: ExecuteExtended<0xEB>(); break;
+  case 0xEC: ExecuteExtended<0xEC>(); break;
+  case 0xED: ExecuteExtended<0xED>(); break;
+  case 0xEE: ExecuteExtended<0xEE>(); break;
+  case 0xEF: ExecuteExtended<0xEF>(); break;
+  case 0xF0: ExecuteExtended<0xF0>(); break;
+  case 0xF1: ExecuteExtended<0xF1>(); break;
+  case 0xF2: ExecuteExtended<0xF2>(); break;
+  case 0xF3: ExecuteExtended<0xF3>(); break;
+  case 0xF4: ExecuteExtended<0xF4>(); break;
+  case 0xF5: ExecuteExtended<0xF5>(); break;
+  case 0xF6: ExecuteExtended<0xF6>(); break;
+  case 0xF7: ExecuteExtended<0xF7>(); break;
+  case 0xF8: ExecuteExtended<0xF8>(); break;
+  case 0xF9: ExecuteExtended<0xF9>(); break;
+  case 0xFA: ExecuteExtended<0xFA>(); break;
+  case 0xFB: ExecuteExtended<0xFB>(); break;
+  case 0xFC: ExecuteExtended<0xFC>(); break;
+  case 0xFD: ExecuteExtended<0xFD>(); break;
+  case 0xFE: ExecuteExtended<0xFE>(); break;
+  case 0xFF: ExecuteExtended<0xFF>(); break;
+  }
+  // clang-format on
 }
 
-void CPU::SET_1_H()
+/**********************************************************************************/
+/* Block Cache                                                                    */
+/**********************************************************************************/
+/**
+ * @brief Opcodes after which execution does not simply fall through to the next instruction.
+ */
+bool CPU::EndsBlock(std::uint8_t opcode)
 {
-  SET_R8(registers.H, 1);
+  switch (opcode)
+  {
+  case 0x10: // STOP
+  case 0x18: // JR
+  case 0x20:
+  case 0x28:
+  case 0x30:
+  case 0x38:
+  case 0x76: // HALT
+  case 0xC0: // RET cc
+  case 0xC8:
+  case 0xD0:
+  case 0xD8:
+  case 0xC2: // JP cc
+  case 0xCA:
+  case 0xD2:
+  case 0xDA:
+  case 0xC3: // JP
+  case 0xE9:
+  case 0xC4: // CALL cc
+  case 0xCC:
+  case 0xD4:
+  case 0xDC:
+  case 0xCD: // CALL
+  case 0xC9: // RET
+  case 0xD9:
+  case 0xC7: // RST
+  case 0xCF:
+  case 0xD7:
+  case 0xDF:
+  case 0xE7:
+  case 0xEF:
+  case 0xF7:
+  case 0xFF:
+    return true;
+  default:
+    return false;
+  }
 }
 
-void CPU::SET_1_L()
+/**
+ * @brief Decodes a straight-line run of opcodes starting at address, operands are extracted up front.
+ *
+ * Blocks stop at control flow, invalid opcodes and before crossing into another 16 KiB bank region.
+ */
+BlockCache::Block CPU::DecodeBlock(std::uint16_t bank, std::uint16_t address)
 {
-  SET_R8(registers.L, 1);
-}
+  BlockCache::Block block;
+  block.bank = bank;
+  block.startAddress = address;
 
-void CPU::SET_1_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  SET_R8(byte, 1);
-  mmu.Set(registers.HL, byte);
-}
+  std::uint16_t pc = address;
+  bool endOfBlock = false;
 
-void CPU::SET_1_A()
-{
-  SET_R8(registers.A, 1);
-}
+  while (!endOfBlock)
+  {
+    BlockCache::Instruction instruction{};
+    instruction.address = pc;
+    instruction.opcode = mmu.Get(pc);
+    instruction.extended = (instruction.opcode == extendedOpcodePrefix);
 
-void CPU::SET_2_B()
-{
-  SET_R8(registers.B, 2);
-}
+    if (instruction.extended)
+    {
+      instruction.opcode = mmu.Get(pc + 1);
+      instruction.operand = instruction.opcode;
+      instruction.length = extendedOpcodeTable[instruction.opcode].length;
+      instruction.execute = decodedExtendedExecutors[instruction.opcode];
+    }
+    else
+    {
+      instruction.length = opcodeTable[instruction.opcode].length;
+      instruction.execute = decodedExecutors[instruction.opcode];
+
+      if (instruction.length == 2)
+      {
+        instruction.operand = mmu.Get(pc + 1);
+      }
+      else if (instruction.length == 3)
+      {
+        instruction.operand = mmu.Get16(pc + 1);
+      }
+    }
 
-void CPU::SET_2_C()
-{
-  SET_R8(registers.C, 2);
-}
+    block.instructions.push_back(instruction);
 
-void CPU::SET_2_D()
-{
-  SET_R8(registers.D, 2);
-}
+    // Invalid opcodes have length 0 but still occupy their opcode byte.
+    std::uint16_t next = pc + std::max<int>(instruction.length, 1);
 
-void CPU::SET_2_E()
-{
-  SET_R8(registers.E, 2);
-}
+    endOfBlock = instruction.length == 0 || (!instruction.extended && EndsBlock(instruction.opcode)) ||
+                 (next >> 14) != (address >> 14) || block.instructions.size() == BlockCache::maxBlockLength;
+    pc = next;
+  }
 
-void CPU::SET_2_H()
-{
-  SET_R8(registers.H, 2);
+  block.endAddress = pc;
+  return block;
 }
 
-void CPU::SET_2_L()
+BlockCache::Block& CPU::GetBlock(std::uint16_t bank, std::uint16_t address)
 {
-  SET_R8(registers.L, 2);
-}
+  if (BlockCache::Block* block = blockCache.Find(bank, address))
+  {
+    return *block;
+  }
 
-void CPU::SET_2_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  SET_R8(byte, 2);
-  mmu.Set(registers.HL, byte);
+  return blockCache.Insert(DecodeBlock(bank, address));
 }
 
-void CPU::SET_2_A()
+/**
+ * @brief Block at PC, taken from the successors of the block that ran before it when one of them still matches.
+ */
+BlockCache::Block& CPU::NextBlock(BlockCache::Block* previous)
 {
-  SET_R8(registers.A, 2);
-}
+  std::uint16_t address = registers.PC;
+  std::uint16_t bank = mmu.GetBank(address);
 
-void CPU::SET_3_B()
-{
-  SET_R8(registers.B, 3);
-}
+  if (!previous || !previous->valid)
+  {
+    return GetBlock(bank, address);
+  }
 
-void CPU::SET_3_C()
-{
-  SET_R8(registers.C, 3);
-}
+  for (BlockCache::Block* successor : previous->successors)
+  {
+    if (successor && successor->Starts(address, bank))
+    {
+      return *successor;
+    }
+  }
 
-void CPU::SET_3_D()
-{
-  SET_R8(registers.D, 3);
+  BlockCache::Block& block = GetBlock(bank, address);
+  previous->successors[1] = previous->successors[0];
+  previous->successors[0] = &block;
+  return block;
 }
 
-void CPU::SET_3_E()
+std::uint64_t CPU::RunBlockCache(std::uint64_t instructionCount)
 {
-  SET_R8(registers.E, 3);
-}
+  std::uint64_t executed = 0;
+  BlockCache::Block* block = nullptr;
 
-void CPU::SET_3_H()
-{
-  SET_R8(registers.H, 3);
-}
+  while (executed < instructionCount && !halted && cycleCount < scheduler.NextCycle())
+  {
+    block = &NextBlock(block);
+    executed += ExecuteBlock(*block, 0, instructionCount - executed);
+  }
 
-void CPU::SET_3_L()
-{
-  SET_R8(registers.L, 3);
+  return executed;
 }
 
-void CPU::SET_3_dHL()
+/**
+ * @brief Interprets a cached block from its first-th instruction on, returns the number of instructions executed.
+ *
+ * Records call the Execute instantiation of their opcode that threaded dispatch inlines, resolved when the block
+ * was decoded and with the operand already latched. The block is left early when an interrupt redirects PC, the CPU
+ * halts or the block itself gets overwritten.
+ */
+std::uint64_t CPU::ExecuteBlock(const BlockCache::Block& block, std::size_t first, std::uint64_t instructionCount)
 {
-  std::uint8_t byte = mmu.Get(registers.HL);
-  SET_R8(byte, 3);
-  mmu.Set(registers.HL, byte);
-}
+  if (first >= block.instructions.size() || registers.PC != block.instructions[first].address)
+  {
+    return 0;
+  }
 
-void CPU::SET_3_A()
-{
-  SET_R8(registers.A, 3);
-}
+  std::size_t last = first + static_cast<std::size_t>(std::min<std::uint64_t>(block.instructions.size() - first,
+                                                                               instructionCount));
+  std::size_t i = first;
+  std::uint64_t bankSwitches = mmu.GetBankSwitches();
 
-void CPU::SET_4_B()
-{
-  SET_R8(registers.B, 4);
-}
+  while (i < last)
+  {
+    const BlockCache::Instruction& instruction = block.instructions[i++];
 
-void CPU::SET_4_C()
-{
-  SET_R8(registers.C, 4);
-}
+    TraceInstruction();
 
-void CPU::SET_4_D()
-{
-  SET_R8(registers.D, 4);
-}
+    operand = instruction.operand;
+    instruction.execute(*this);
 
-void CPU::SET_4_E()
-{
-  SET_R8(registers.E, 4);
-}
+    // HALT, STOP and invalid opcodes end blocks, so only a dispatched interrupt can leave one midway. A bank switch
+    // may have replaced the code the rest of the block was decoded from.
+    if (HandleInterrupts() != 0 || !block.valid || mmu.GetBankSwitches() != bankSwitches ||
+        cycleCount >= scheduler.NextCycle())
+    {
+      break;
+    }
+  }
 
-void CPU::SET_4_H()
-{
-  SET_R8(registers.H, 4);
+  return i - first;
 }
 
-void CPU::SET_4_L()
+/**********************************************************************************/
+/* JIT                                                                            */
+/**********************************************************************************/
+/**
+ * @brief Whether HandleInterrupts would dispatch an interrupt if it ran now.
+ */
+bool CPU::IsInterruptDue()
 {
-  SET_R8(registers.L, 4);
+  return (registers.IME || imeEnableDelay) && PendingInterrupts();
 }
 
-void CPU::SET_4_dHL()
+/**
+ * @brief Runs hot blocks as native code and everything else through the block cache interpreter.
+ *
+ * Native code is only entered when no interrupt is due, the whole translated prefix fits into the remaining
+ * instruction budget and even its longest path ends before the next event. Nothing it executes can request an
+ * interrupt, so checking once afterwards matches the interpreter checking after every instruction.
+ */
+std::uint64_t CPU::RunJit(std::uint64_t instructionCount)
 {
-  std::uint8_t byte = mmu.Get(registers.HL);
-  SET_R8(byte, 4);
-  mmu.Set(registers.HL, byte);
-}
+  if (!Jit::IsAvailable())
+  {
+    return RunBlockCache(instructionCount);
+  }
 
-void CPU::SET_4_A()
-{
-  SET_R8(registers.A, 4);
-}
+  std::uint64_t executed = 0;
+  BlockCache::Block* previous = nullptr;
 
-void CPU::SET_5_B()
-{
-  SET_R8(registers.B, 5);
-}
+  while (executed < instructionCount && !halted && cycleCount < scheduler.NextCycle())
+  {
+    BlockCache::Block& block = NextBlock(previous);
+    previous = &block;
 
-void CPU::SET_5_C()
-{
-  SET_R8(registers.C, 5);
-}
+    if (!block.native && ++block.executionCount == Jit::hotThreshold && !jit.Compile(block) && jit.IsFull())
+    {
+      blockCache.Clear();
+      jit.Flush();
+      previous = nullptr;
+      continue;
+    }
 
-void CPU::SET_5_D()
-{
-  SET_R8(registers.D, 5);
-}
+    std::size_t first = 0;
+    std::uint64_t* interpreted = nullptr;
 
-void CPU::SET_5_E()
-{
-  SET_R8(registers.E, 5);
-}
+    if (!block.native)
+    {
+      interpreted = (block.executionCount < Jit::hotThreshold) ? &jitCoverage.cold : &jitCoverage.untranslated;
+    }
+    else if (IsInterruptDue())
+    {
+      interpreted = &jitCoverage.interruptDue;
+    }
+    else if (block.nativeLength > instructionCount - executed ||
+             block.nativeCycles > scheduler.NextCycle() - cycleCount || IsInstrumented())
+    {
+      interpreted = &jitCoverage.limited;
+    }
+    else
+    {
+      // Native loops stop early enough for a last pass to fit the budget as well.
+      std::uint64_t iterations = 0;
+      if (block.loopCycles != 0)
+      {
+        iterations = std::min({(scheduler.NextCycle() - cycleCount - block.nativeCycles) / block.loopCycles,
+                               (instructionCount - executed - block.nativeLength) / block.nativeLength,
+                               std::uint64_t{std::numeric_limits<std::uint32_t>::max()}});
+      }
+
+      std::uint64_t bankSwitches = mmu.GetBankSwitches();
+      registers.ResolveFlags();
+      Jit::Result result = jit.Execute(block, &registers, static_cast<std::uint32_t>(iterations));
+      first = result.position;
+      executed += result.executed;
+      cycleCount += result.cycles;
+      jitCoverage.native += result.executed;
+
+      // Native branches bypass the handlers, so loops that stay inside native code are checked here. Calls and
+      // returns also go backwards but never close an idle loop.
+      const BlockCache::Instruction& last = block.instructions.back();
+      bool jump = !last.extended && (last.opcode == 0x18 || last.opcode == 0xC3 || (last.opcode & 0xE7) == 0x20 ||
+                                     (last.opcode & 0xE7) == 0xC2);
+      if (first == block.instructions.size() && jump && registers.PC <= last.address && idleLoopSkipping)
+      {
+        SkipIdleLoop(last.address, true);
+      }
+
+      if (first > 0)
+      {
+        HandleInterrupts();
+      }
+      // After a bank switch the rest of the block may no longer be what is mapped, the next lookup decides.
+      if (first == block.instructions.size() || !block.valid || mmu.GetBankSwitches() != bankSwitches ||
+          executed >= instructionCount || cycleCount >= scheduler.NextCycle())
+      {
+        continue;
+      }
+
+      interpreted = (first < block.nativeLength) ? &jitCoverage.exited : &jitCoverage.untranslated;
+    }
 
-void CPU::SET_5_H()
-{
-  SET_R8(registers.H, 5);
-}
+    std::uint64_t count = ExecuteBlock(block, first, instructionCount - executed);
+    executed += count;
+    *interpreted += count;
+  }
 
-void CPU::SET_5_L()
-{
-  SET_R8(registers.L, 5);
+  return executed;
 }
 
-void CPU::SET_5_dHL()
+/**********************************************************************************/
+/* Debugger                                                                       */
+/**********************************************************************************/
+void CPU::AddBreakpoint(std::uint16_t address, int bank)
 {
-  std::uint8_t byte = mmu.Get(registers.HL);
-  SET_R8(byte, 5);
-  mmu.Set(registers.HL, byte);
+  breakpoints.insert({address, bank});
+  if (!breakpointAddresses)
+  {
+    breakpointAddresses = std::make_unique<std::bitset<0x10000>>();
+  }
+  breakpointAddresses->set(address);
 }
 
-void CPU::SET_5_A()
+void CPU::RemoveBreakpoint(std::uint16_t address, int bank)
 {
-  SET_R8(registers.A, 5);
-}
+  breakpoints.erase({address, bank});
 
-void CPU::SET_6_B()
-{
-  SET_R8(registers.B, 6);
-}
+  if (breakpoints.empty())
+  {
+    breakpointAddresses.reset();
+    return;
+  }
 
-void CPU::SET_6_C()
-{
-  SET_R8(registers.C, 6);
+  auto next = breakpoints.lower_bound({address, std::numeric_limits<int>::min()});
+  if (breakpointAddresses && (next == breakpoints.end() || next->first != address))
+  {
+    breakpointAddresses->reset(address);
+  }
 }
 
-void CPU::SET_6_D()
+void CPU::ClearBreakpoints()
 {
-  SET_R8(registers.D, 6);
+  breakpoints.clear();
+  breakpointAddresses.reset();
 }
 
-void CPU::SET_6_E()
+/**
+ * @brief Checked once per RunUntilEvent call, so the dispatch loops themselves carry no debugging code.
+ */
+bool CPU::HasDebugHooks() const
 {
-  SET_R8(registers.E, 6);
+  return !breakpoints.empty() || mmu.HasWatchpoints();
 }
 
-void CPU::SET_6_H()
+/**
+ * @brief Executes instructions one Tick at a time and stops before any that has a breakpoint or once paused.
+ */
+std::uint64_t CPU::RunDebug(std::uint64_t instructionCount)
 {
-  SET_R8(registers.H, 6);
-}
+  std::uint64_t executed = 0;
 
-void CPU::SET_6_L()
-{
-  SET_R8(registers.L, 6);
-}
+  while (executed < instructionCount && !halted && !paused && cycleCount < scheduler.NextCycle())
+  {
+    bool resumed = std::exchange(breakpointResumed, false);
+    if (!resumed && breakpointAddresses && (*breakpointAddresses)[registers.PC] && HitBreakpoint())
+    {
+      break;
+    }
 
-void CPU::SET_6_dHL()
-{
-  std::uint8_t byte = mmu.Get(registers.HL);
-  SET_R8(byte, 6);
-  mmu.Set(registers.HL, byte);
-}
+    Tick();
+    ++executed;
+  }
 
-void CPU::SET_6_A()
-{
-  SET_R8(registers.A, 6);
+  return executed;
 }
 
-void CPU::SET_7_B()
+/**
+ * @brief Reports the breakpoint at PC if one matches its bank, returns whether the handler paused.
+ */
+bool CPU::HitBreakpoint()
 {
-  SET_R8(registers.B, 7);
-}
+  int bank = mmu.GetBank(registers.PC);
+  if (breakpoints.count({registers.PC, anyBank}) == 0 && breakpoints.count({registers.PC, bank}) == 0)
+  {
+    return false;
+  }
 
-void CPU::SET_7_C()
-{
-  SET_R8(registers.C, 7);
-}
+  instructionAddress = registers.PC;
+  Debug(DebugHit::Kind::Breakpoint, registers.PC, 0);
 
-void CPU::SET_7_D()
-{
-  SET_R8(registers.D, 7);
+  breakpointResumed = paused;
+  return paused;
 }
 
-void CPU::SET_7_E()
+/**
+ * @brief Hands a hit to the debug handler and pauses if it asks to or there is none.
+ *
+ * Watchpoints fire in the middle of an instruction, the pause takes effect once it completed.
+ */
+void CPU::Debug(DebugHit::Kind kind, std::uint16_t address, std::uint8_t value)
 {
-  SET_R8(registers.E, 7);
-}
+  DebugHit hit{kind, mmu.GetBank(address), address, value, instructionAddress, GetState()};
 
-void CPU::SET_7_H()
-{
-  SET_R8(registers.H, 7);
+  if (!debugHandler || debugHandler(hit, mmu) == DebugAction::Pause)
+  {
+    paused = true;
+  }
 }
 
-void CPU::SET_7_L()
+/**********************************************************************************/
+/* Sampling Profiler                                                              */
+/**********************************************************************************/
+/**
+ * @brief Samples the emulated code every interval cycles from now on, a running profile is started over.
+ */
+void CPU::StartSampling(std::uint64_t interval, Symbols symbols)
 {
-  SET_R8(registers.L, 7);
+  sampler = std::make_unique<SamplingProfiler>(interval, std::move(symbols));
+  scheduler.Schedule(sampleEvent, cycleCount + interval);
 }
 
-void CPU::SET_7_dHL()
+/**
+ * @brief Charges the time since the last sample to where the CPU is now.
+ *
+ * Events run between instructions, so a sample can be late. Intervals passed in the meantime, like while skipping
+ * an idle loop, are charged here too instead of being lost.
+ */
+void CPU::TakeSample(std::uint64_t cycle)
 {
-  std::uint8_t byte = mmu.Get(registers.HL);
-  SET_R8(byte, 7);
-  mmu.Set(registers.HL, byte);
-}
+  std::uint64_t interval = sampler->GetInterval();
+  std::uint64_t intervals = 1 + (cycleCount - cycle) / interval;
 
-void CPU::SET_7_A()
-{
-  SET_R8(registers.A, 7);
+  sampler->Sample(mmu.GetBank(registers.PC), registers.PC, intervals * interval);
+  scheduler.Schedule(sampleEvent, cycle + intervals * interval);
 }
 
-void CPU::PrintCPUState()
+/**********************************************************************************/
+/* Trace                                                                          */
+/**********************************************************************************/
+/**
+ * @brief Records the state before the instruction at PC if the trace is on and its filter matches.
+ */
+void CPU::TraceInstruction()
 {
-  static std::ofstream outFile("doclog.txt", std::ios_base::app);
-
-  outFile << std::hex << std::uppercase << std::setfill('0');
-
-  outFile << "A:" << std::setw(2) << static_cast<int>(registers.A) << " F:" << std::setw(2)
-          << static_cast<int>(registers.F) << " B:" << std::setw(2) << static_cast<int>(registers.B)
-          << " C:" << std::setw(2) << static_cast<int>(registers.C) << " D:" << std::setw(2)
-          << static_cast<int>(registers.D) << " E:" << std::setw(2) << static_cast<int>(registers.E)
-          << " H:" << std::setw(2) << static_cast<int>(registers.H) << " L:" << std::setw(2)
-          << static_cast<int>(registers.L) << " SP:" << std::setw(4) << registers.SP << " PC:" << std::setw(4)
-          << registers.PC;
-
-  outFile << " PCMEM:";
-  for (int i = 0; i < 4; ++i)
+  if constexpr (Trace::compiledIn)
   {
-    outFile << std::setw(2) << static_cast<int>(mmu.Get(registers.PC + i));
-    if (i < 3)
+    const Trace::Filter& filter = trace.GetFilter();
+    if (!trace.IsEnabled() || !filter.Contains(registers.PC))
     {
-      outFile << ",";
+      return;
     }
-  }
 
-  outFile << " SPMEM:";
-  for (int i = 0; i < 4; ++i)
-  {
-    outFile << std::setw(2) << static_cast<int>(mmu.Get(registers.SP + i));
-    if (i < 3)
+    std::uint16_t bank = mmu.GetBank(registers.PC);
+    if (filter.bank != Trace::anyBank && filter.bank != bank)
     {
-      outFile << ",";
+      return;
     }
-  }
-
-  outFile << "\n";
-}
 
-void CPU::PrintBLARGGSerial()
-{
-  if (mmu.Get(0xff02) == 0x81)
-  {
-    char c = mmu.Get(0xff01);
-    printf("%c", c);
-    mmu.Set(0xff02, 0x0);
+    TraceRecord record{};
+    record.cycle = cycleCount;
+    record.A = registers.A;
+    record.F = registers.EvaluateFlags();
+    record.B = registers.B;
+    record.C = registers.C;
+    record.D = registers.D;
+    record.E = registers.E;
+    record.H = registers.H;
+    record.L = registers.L;
+    record.SP = registers.SP;
+    record.PC = registers.PC;
+    for (int i = 0; i < 4; ++i)
+    {
+      record.pcMemory[i] = mmu.Peek(registers.PC + i);
+    }
+    record.bank = bank;
+    trace.Record(record);
   }
-}
\ No newline at end of file
+}
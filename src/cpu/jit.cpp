@@ -0,0 +1,1383 @@
+#include "jit.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#if GBE_JIT_AVAILABLE
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "cpu.hpp"
+#include "../mmu.hpp"
+
+#if GBE_JIT_AVAILABLE
+
+namespace
+{
+
+enum HostRegister : int
+{
+  RAX = 0,
+  RCX = 1,
+  RDX = 2,
+  RBX = 3,
+  RSP = 4,
+  RBP = 5,
+  RSI = 6,
+  RDI = 7,
+  R8 = 8,
+  R9 = 9,
+  R10 = 10,
+  R11 = 11,
+  R12 = 12,
+  R13 = 13,
+  R14 = 14,
+  R15 = 15
+};
+
+// rbx holds the CPU registers, rbp the JIT context, the SM83 registers are kept in r8-r15.
+constexpr int hostA = R8;
+constexpr int hostF = R9;
+constexpr int hostB = R10;
+constexpr int hostC = R11;
+constexpr int hostD = R12;
+constexpr int hostE = R13;
+constexpr int hostH = R14;
+constexpr int hostL = R15;
+
+// Host register for the r8 operand encoding of SM83 opcodes, 6 is (HL) and has no register.
+constexpr std::array<int, 8> hostRegisters = {hostB, hostC, hostD, hostE, hostH, hostL, -1, hostA};
+
+enum Condition : std::uint8_t
+{
+  Carry = 0x2,
+  NotCarry = 0x3,
+  Zero = 0x4,
+  NotZero = 0x5,
+  CarryOrZero = 0x6
+};
+
+// IO registers and IE, writes to them can request interrupts or schedule events. HRAM in between is plain memory.
+constexpr bool IsIOWrite(std::uint16_t address)
+{
+  return (address >= 0xFF00 && address < 0xFF80) || address == 0xFFFF;
+}
+
+/**
+ * @brief Maps the AH value stored by LAHF (SF ZF 0 AF 0 PF 1 CF) to SM83 Z, H and C flags.
+ */
+constexpr std::array<std::uint8_t, 256> MakeFlagTable()
+{
+  std::array<std::uint8_t, 256> table{};
+
+  for (int ah = 0; ah < 256; ++ah)
+  {
+    int zero = (ah >> 6) & 1;
+    int halfCarry = (ah >> 4) & 1;
+    int carry = ah & 1;
+    table[ah] = static_cast<std::uint8_t>((zero << 7) | (halfCarry << 5) | (carry << 4));
+  }
+
+  return table;
+}
+
+constexpr std::array<std::uint8_t, 256> flagTable = MakeFlagTable();
+
+class Emitter
+{
+  std::uint8_t* out;
+  std::size_t capacity;
+  std::size_t size = 0;
+
+public:
+  Emitter(std::uint8_t* out, std::size_t capacity) : out(out), capacity(capacity) {}
+
+  [[nodiscard]] std::size_t Size() const { return size; }
+  [[nodiscard]] bool Overflowed() const { return size > capacity; }
+  void Rewind(std::size_t position) { size = position; }
+
+  void Byte(std::uint8_t value)
+  {
+    if (size < capacity)
+    {
+      out[size] = value;
+    }
+    ++size;
+  }
+
+  void Word(std::uint16_t value)
+  {
+    Byte(value & 0xFF);
+    Byte(value >> 8);
+  }
+
+  void Dword(std::uint32_t value)
+  {
+    Word(value & 0xFFFF);
+    Word(value >> 16);
+  }
+
+  void Qword(std::uint64_t value)
+  {
+    Dword(value & 0xFFFFFFFF);
+    Dword(value >> 32);
+  }
+
+  void Rex(bool wide, int reg, int rm) { Byte(0x40 | (wide << 3) | ((reg >> 3) << 2) | (rm >> 3)); }
+  void ModRM(int mod, int reg, int rm) { Byte((mod << 6) | ((reg & 7) << 3) | (rm & 7)); }
+
+  // Prefix and operand for [base + index * scale], base must not be rbp or r13.
+  void RexIndexed(bool wide, int reg, int base, int index)
+  {
+    Byte(0x40 | (wide << 3) | ((reg >> 3) << 2) | ((index >> 3) << 1) | (base >> 3));
+  }
+  void Sib(int reg, int base, int index, int scale)
+  {
+    ModRM(0, reg, 4);
+    Byte((scale << 6) | ((index & 7) << 3) | (base & 7));
+  }
+
+  // 8-bit register forms always carry a REX prefix, so encodings 4-7 address spl-dil instead of ah-bh.
+  void Op8(std::uint8_t opcode, int dst, int src)
+  {
+    Rex(false, src, dst);
+    Byte(opcode);
+    ModRM(3, src, dst);
+  }
+
+  void Op8Imm(int extension, int dst, std::uint8_t imm)
+  {
+    Rex(false, 0, dst);
+    Byte(0x80);
+    ModRM(3, extension, dst);
+    Byte(imm);
+  }
+
+  void Unary8(std::uint8_t opcode, int extension, int dst)
+  {
+    Rex(false, 0, dst);
+    Byte(opcode);
+    ModRM(3, extension, dst);
+  }
+
+  void Mov8(int dst, int src) { Op8(0x88, dst, src); }
+
+  void Mov8Imm(int dst, std::uint8_t imm)
+  {
+    Rex(false, 0, dst);
+    Byte(0xB0 + (dst & 7));
+    Byte(imm);
+  }
+
+  void Movzx8(int dst, int src)
+  {
+    Rex(false, dst, src);
+    Byte(0x0F);
+    Byte(0xB6);
+    ModRM(3, dst, src);
+  }
+
+  // movzx dst, byte [rbx + offset]
+  void LoadRegister(int dst, int offset)
+  {
+    Rex(false, dst, RBX);
+    Byte(0x0F);
+    Byte(0xB6);
+    ModRM(1, dst, RBX);
+    Byte(offset);
+  }
+
+  // movzx dst, word [rbx + offset]
+  void LoadWord(int dst, int offset)
+  {
+    Rex(false, dst, RBX);
+    Byte(0x0F);
+    Byte(0xB7);
+    ModRM(1, dst, RBX);
+    Byte(offset);
+  }
+
+  // add word [rbx + offset], imm
+  void AddWordImm(int offset, std::int8_t imm)
+  {
+    Byte(0x66);
+    Byte(0x83);
+    ModRM(1, 0, RBX);
+    Byte(offset);
+    Byte(static_cast<std::uint8_t>(imm));
+  }
+
+  // mov dst, qword [base + index * 8]
+  void LoadPage(int dst, int base, int index)
+  {
+    RexIndexed(true, dst, base, index);
+    Byte(0x8B);
+    Sib(dst, base, index, 3);
+  }
+
+  // movzx dst, byte [base + index]
+  void LoadByte(int dst, int base, int index)
+  {
+    RexIndexed(false, dst, base, index);
+    Byte(0x0F);
+    Byte(0xB6);
+    Sib(dst, base, index, 0);
+  }
+
+  // mov byte [base + index], src
+  void StoreByte(int base, int index, int src)
+  {
+    RexIndexed(false, src, base, index);
+    Byte(0x88);
+    Sib(src, base, index, 0);
+  }
+
+  // cmp dword [rbp + offset], imm
+  void CompareContextDword(int offset, std::uint8_t imm)
+  {
+    Byte(0x83);
+    ModRM(1, 7, RBP);
+    Byte(offset);
+    Byte(imm);
+  }
+
+  // dec dword [rbp + offset]
+  void DecrementContextDword(int offset)
+  {
+    Byte(0xFF);
+    ModRM(1, 1, RBP);
+    Byte(offset);
+  }
+
+  // cmp byte [rbp + offset], imm
+  void CompareContextByte(int offset, std::uint8_t imm)
+  {
+    Byte(0x80);
+    ModRM(1, 7, RBP);
+    Byte(offset);
+    Byte(imm);
+  }
+
+  // mov byte [rbx + offset], src
+  void StoreRegister(int offset, int src)
+  {
+    Rex(false, src, RBX);
+    Byte(0x88);
+    ModRM(1, src, RBX);
+    Byte(offset);
+  }
+
+  // mov word [rbx + offset], src
+  void StoreWord(int offset, int src)
+  {
+    Byte(0x66);
+    Rex(false, src, RBX);
+    Byte(0x89);
+    ModRM(1, src, RBX);
+    Byte(offset);
+  }
+
+  // mov word [rbx + offset], imm
+  void StoreWordImm(int offset, std::uint16_t imm)
+  {
+    Byte(0x66);
+    Byte(0xC7);
+    ModRM(1, 0, RBX);
+    Byte(offset);
+    Word(imm);
+  }
+
+  // inc/dec word [rbx + offset]
+  void IncDecWord(int extension, int offset)
+  {
+    Byte(0x66);
+    Byte(0xFF);
+    ModRM(1, extension, RBX);
+    Byte(offset);
+  }
+
+  void Shl32(int reg, std::uint8_t imm)
+  {
+    Rex(false, 0, reg);
+    Byte(0xC1);
+    ModRM(3, 4, reg);
+    Byte(imm);
+  }
+
+  void Shr32(int reg, std::uint8_t imm)
+  {
+    Rex(false, 0, reg);
+    Byte(0xC1);
+    ModRM(3, 5, reg);
+    Byte(imm);
+  }
+
+  // Group 1 operation with a 32-bit immediate, extension 0 is add, 1 or, 4 and, 5 sub and 7 cmp.
+  void Op32Imm(int extension, int reg, std::uint32_t imm)
+  {
+    Rex(false, 0, reg);
+    Byte(0x81);
+    ModRM(3, extension, reg);
+    Dword(imm);
+  }
+
+  void Rol8(int reg, std::uint8_t imm)
+  {
+    Rex(false, 0, reg);
+    Byte(0xC0);
+    ModRM(3, 0, reg);
+    Byte(imm);
+  }
+
+  void Shl8(int reg, std::uint8_t imm)
+  {
+    Rex(false, 0, reg);
+    Byte(0xC0);
+    ModRM(3, 4, reg);
+    Byte(imm);
+  }
+
+  void Or32(int dst, int src)
+  {
+    Rex(false, src, dst);
+    Byte(0x09);
+    ModRM(3, src, dst);
+  }
+
+  void Mov32(int dst, int src)
+  {
+    Rex(false, src, dst);
+    Byte(0x89);
+    ModRM(3, src, dst);
+  }
+
+  void Test8(int a, int b) { Op8(0x84, a, b); }
+
+  void Test64(int a, int b)
+  {
+    Rex(true, b, a);
+    Byte(0x85);
+    ModRM(3, b, a);
+  }
+
+  void Test32(int a, int b)
+  {
+    Rex(false, b, a);
+    Byte(0x85);
+    ModRM(3, b, a);
+  }
+
+  void MovImm32(int reg, std::uint32_t imm)
+  {
+    Rex(false, 0, reg);
+    Byte(0xB8 + (reg & 7));
+    Dword(imm);
+  }
+
+  void MovImm64(int reg, std::uint64_t imm)
+  {
+    Rex(true, 0, reg);
+    Byte(0xB8 + (reg & 7));
+    Qword(imm);
+  }
+
+  void Mov64(int dst, int src)
+  {
+    Rex(true, src, dst);
+    Byte(0x89);
+    ModRM(3, src, dst);
+  }
+
+  void CmpImm32(int reg, std::uint32_t imm)
+  {
+    Rex(false, 0, reg);
+    Byte(0x81);
+    ModRM(3, 7, reg);
+    Dword(imm);
+  }
+
+  // bt reg, bit
+  void BitTest(int reg, std::uint8_t bit)
+  {
+    Rex(false, 0, reg);
+    Byte(0x0F);
+    Byte(0xBA);
+    ModRM(3, 4, reg);
+    Byte(bit);
+  }
+
+  void Setcc(Condition condition, int reg)
+  {
+    Rex(false, 0, reg);
+    Byte(0x0F);
+    Byte(0x90 | condition);
+    ModRM(3, 0, reg);
+  }
+
+  void Setc(int reg) { Setcc(Carry, reg); }
+
+  void Lahf() { Byte(0x9F); }
+
+  // movzx ecx, ah, must not have a REX prefix to reach ah.
+  void MovzxEcxAh()
+  {
+    Byte(0x0F);
+    Byte(0xB6);
+    ModRM(3, RCX, 4);
+  }
+
+  // movzx dst, byte [rdx + rcx]
+  void LoadTableEntry(int dst)
+  {
+    Rex(false, dst, 0);
+    Byte(0x0F);
+    Byte(0xB6);
+    ModRM(0, dst, 4);
+    Byte((RCX << 3) | RDX);
+  }
+
+  void Push(int reg)
+  {
+    if (reg >= 8)
+    {
+      Byte(0x41);
+    }
+    Byte(0x50 + (reg & 7));
+  }
+
+  void Pop(int reg)
+  {
+    if (reg >= 8)
+    {
+      Byte(0x41);
+    }
+    Byte(0x58 + (reg & 7));
+  }
+
+  void Call(const void* function)
+  {
+    MovImm64(RAX, reinterpret_cast<std::uint64_t>(function));
+    Byte(0xFF);
+    ModRM(3, 2, RAX);
+  }
+
+  void Ret() { Byte(0xC3); }
+
+  void AddRsp(std::uint8_t imm)
+  {
+    Rex(true, 0, RSP);
+    Byte(0x83);
+    ModRM(3, 0, RSP);
+    Byte(imm);
+  }
+
+  void SubRsp(std::uint8_t imm)
+  {
+    Rex(true, 0, RSP);
+    Byte(0x83);
+    ModRM(3, 5, RSP);
+    Byte(imm);
+  }
+
+  // Returns the position of the rel32 to patch.
+  std::size_t Jcc(Condition condition)
+  {
+    Byte(0x0F);
+    Byte(0x80 | condition);
+    std::size_t position = size;
+    Dword(0);
+    return position;
+  }
+
+  std::size_t Jmp()
+  {
+    Byte(0xE9);
+    std::size_t position = size;
+    Dword(0);
+    return position;
+  }
+
+  void Patch(std::size_t position, std::size_t target)
+  {
+    auto relative = static_cast<std::uint32_t>(static_cast<std::int64_t>(target) - static_cast<std::int64_t>(position + 4));
+    for (int i = 0; i < 4; ++i)
+    {
+      if (position + i < capacity)
+      {
+        out[position + i] = (relative >> (8 * i)) & 0xFF;
+      }
+    }
+  }
+};
+
+} // namespace
+
+#endif
+
+Jit::Jit(MMU& mmu) : context{&mmu, nullptr, false, 0, 0} {}
+
+Jit::~Jit()
+{
+#if GBE_JIT_AVAILABLE
+  if (code)
+  {
+    munmap(code, codeCapacity);
+  }
+#endif
+}
+
+/**
+ * @brief Whether emitted code used up the region, so that Flush has to make room. Never before the first Compile.
+ */
+bool Jit::IsFull() const
+{
+  return code && codeUsed + maxBlockCodeSize > codeCapacity;
+}
+
+/**
+ * @brief Maps the code region on the first Compile, so CPUs that never translate anything never pay for it.
+ */
+bool Jit::MapCode()
+{
+#if GBE_JIT_AVAILABLE
+  if (!code && !mapFailed)
+  {
+    void* memory = mmap(nullptr, codeCapacity, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory != MAP_FAILED)
+    {
+      code = static_cast<std::uint8_t*>(memory);
+    }
+    mapFailed = !code;
+  }
+#endif
+  return code != nullptr;
+}
+
+/**
+ * @brief Forgets all emitted code, blocks still pointing into it must be dropped by the caller.
+ */
+void Jit::Flush()
+{
+  codeUsed = 0;
+}
+
+/**
+ * @brief Runs the native code of a block, which may go back to its start up to iterations times.
+ *
+ * Every iteration but the last is a full pass through the native code, so the totals are counted from the loops.
+ */
+Jit::Result Jit::Execute(const BlockCache::Block& block, void* registers, std::uint32_t iterations)
+{
+  context.block = &block;
+  context.overwritten = false;
+  context.bankSwitches = context.mmu->GetBankSwitches();
+  context.iterations = iterations;
+  std::uint32_t result = block.native(registers, &context);
+  std::uint64_t loops = iterations - context.iterations;
+  return {result & 0xFFFF, (result & 0xFFFF) + loops * block.nativeLength, (result >> 16) + loops * block.loopCycles};
+}
+
+std::uint8_t Jit::Read(Context* context, std::uint32_t address)
+{
+  return context->mmu->Get(address);
+}
+
+/**
+ * @brief Flags the running block as overwritten, the native code then leaves it right after the instruction.
+ *
+ * Switching banks counts as overwriting, the rest of the block may no longer be what is mapped.
+ */
+void Jit::Write(Context* context, std::uint32_t address, std::uint32_t value)
+{
+  context->mmu->Set(address, value);
+  context->overwritten = !context->block->valid || context->mmu->GetBankSwitches() != context->bankSwitches;
+}
+
+bool Jit::Compile(BlockCache::Block& block)
+{
+#if GBE_JIT_AVAILABLE
+  if (!MapCode() || IsFull())
+  {
+    return false;
+  }
+
+  using Registers = CPU::Registers;
+  const int offsetA = offsetof(Registers, A);
+  const int offsetF = offsetof(Registers, F);
+  const int offsetB = offsetof(Registers, B);
+  const int offsetC = offsetof(Registers, C);
+  const int offsetD = offsetof(Registers, D);
+  const int offsetE = offsetof(Registers, E);
+  const int offsetH = offsetof(Registers, H);
+  const int offsetL = offsetof(Registers, L);
+  const int offsetSP = offsetof(Registers, SP);
+  const int offsetPC = offsetof(Registers, PC);
+
+  const std::array<std::pair<int, int>, 8> registerSlots = {{{hostA, offsetA},
+                                                             {hostF, offsetF},
+                                                             {hostB, offsetB},
+                                                             {hostC, offsetC},
+                                                             {hostD, offsetD},
+                                                             {hostE, offsetE},
+                                                             {hostH, offsetH},
+                                                             {hostL, offsetL}}};
+
+  // Exits leave the block with PC set to a constant, the number of instructions that completed and their cycles.
+  struct Exit
+  {
+    std::size_t fixup;
+    int executed;
+    int cycles;
+    std::uint16_t pc;
+  };
+  std::vector<Exit> exits;
+  std::vector<std::size_t> epilogueFixups;
+
+  // Cycles of the instructions before the current one, and including it when a branch is taken.
+  int cyclesBefore = 0;
+  int cyclesAfter = 0;
+  int longestCycles = 0;
+
+  // Blocks that write memory might switch the ROM bank they run from, so they never loop natively.
+  bool writesMemory = false;
+  bool loops = false;
+
+  const std::uint8_t* const* readPages = context.mmu->GetReadPages();
+  std::uint8_t* const* writePages = context.mmu->GetWritePages();
+
+  // Only the pages the block can be emitted into are made writable, everything else stays executable.
+  static const std::size_t hostPageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  std::size_t writableStart = codeUsed & ~(hostPageSize - 1);
+  std::size_t writableEnd =
+      std::min(codeCapacity, (codeUsed + maxBlockCodeSize + hostPageSize - 1) & ~(hostPageSize - 1));
+  auto protect = [&](int protection) { mprotect(code + writableStart, writableEnd - writableStart, protection); };
+
+  protect(PROT_READ | PROT_WRITE);
+  Emitter emitter{code + codeUsed, maxBlockCodeSize};
+
+  // Prologue, keeps the stack 16 byte aligned for the helper calls.
+  for (int reg : {RBX, RBP, R12, R13, R14, R15})
+  {
+    emitter.Push(reg);
+  }
+  emitter.SubRsp(8);
+  emitter.Mov64(RBX, RDI);
+  emitter.Mov64(RBP, RSI);
+  for (auto [reg, offset] : registerSlots)
+  {
+    emitter.LoadRegister(reg, offset);
+  }
+  const std::size_t loopStart = emitter.Size();
+
+  auto flagsFromHost = [&](int dst) {
+    emitter.Lahf();
+    emitter.MovzxEcxAh();
+    emitter.MovImm64(RDX, reinterpret_cast<std::uint64_t>(flagTable.data()));
+    emitter.LoadTableEntry(dst);
+  };
+
+  auto carryToFlags = [&]() {
+    emitter.Setc(RDX);
+    emitter.Shl8(RDX, 4);
+    emitter.Mov8(hostF, RDX);
+  };
+
+  auto pairAddress = [&](int high, int low) {
+    emitter.Movzx8(RSI, high);
+    emitter.Shl32(RSI, 8);
+    emitter.Movzx8(RAX, low);
+    emitter.Or32(RSI, RAX);
+  };
+
+  // Writes to IO registers and IE can request interrupts or schedule events, so they are left to the interpreter.
+  // bytes is 2 for pushes, with RSI holding the lower of the two addresses.
+  auto bailOnIOWrite = [&](int bytes, int index, std::uint16_t pc) {
+    emitter.Mov32(RAX, RSI);
+    emitter.Op32Imm(5, RAX, 0xFF00 - (bytes - 1));
+    emitter.Op32Imm(7, RAX, 0x7F + (bytes - 1));
+    exits.push_back({emitter.Jcc(CarryOrZero), index, cyclesBefore, pc});
+    emitter.Op32Imm(7, RSI, 0x10000 - bytes);
+    exits.push_back({emitter.Jcc(NotCarry), index, cyclesBefore, pc});
+  };
+
+  // Caller saved SM83 registers survive helper calls on the stack, 4 pushes keep the alignment.
+  auto callHelper = [&](const void* helper) {
+    for (int reg : {hostA, hostF, hostB, hostC})
+    {
+      emitter.Push(reg);
+    }
+    emitter.Mov64(RDI, RBP);
+    emitter.Call(helper);
+  };
+
+  auto restoreAfterHelper = [&]() {
+    for (int reg : {hostC, hostB, hostF, hostA})
+    {
+      emitter.Pop(reg);
+    }
+  };
+
+  auto readHelper = [&](int dst) {
+    callHelper(reinterpret_cast<const void*>(&Jit::Read));
+    restoreAfterHelper();
+    if (dst != RAX)
+    {
+      emitter.Mov8(dst, RAX);
+    }
+  };
+
+  auto writeHelper = [&]() {
+    callHelper(reinterpret_cast<const void*>(&Jit::Write));
+    restoreAfterHelper();
+  };
+
+  // Reads and writes index the MMU page table inline like Get and Set, null pages go through the helpers.
+  auto pageLookup = [&](const void* pages) {
+    emitter.Mov32(RAX, RSI);
+    emitter.Shr32(RAX, 8);
+    emitter.MovImm64(RCX, reinterpret_cast<std::uint64_t>(pages));
+    emitter.LoadPage(RAX, RCX, RAX);
+    emitter.Test64(RAX, RAX);
+    std::size_t slow = emitter.Jcc(Zero);
+    emitter.Movzx8(RCX, RSI);
+    return slow;
+  };
+
+  auto read = [&](int dst) {
+    std::size_t slow = pageLookup(readPages);
+    emitter.LoadByte(dst, RAX, RCX);
+    std::size_t done = emitter.Jmp();
+    emitter.Patch(slow, emitter.Size());
+    readHelper(dst);
+    emitter.Patch(done, emitter.Size());
+  };
+
+  // Value in RDX. Pages holding cached code always take the helper, which notices the running block being hit.
+  auto write = [&]() {
+    writesMemory = true;
+    std::size_t slow = pageLookup(writePages);
+    emitter.StoreByte(RAX, RCX, RDX);
+    std::size_t done = emitter.Jmp();
+    emitter.Patch(slow, emitter.Size());
+    writeHelper();
+    emitter.Patch(done, emitter.Size());
+  };
+
+  auto leaveIfOverwritten = [&](int executed, std::uint16_t pc) {
+    emitter.CompareContextByte(offsetof(Context, overwritten), 0);
+    exits.push_back({emitter.Jcc(NotZero), executed, cyclesAfter, pc});
+  };
+
+  auto stackAddress = [&](int offset) {
+    emitter.LoadWord(RSI, offsetSP);
+    if (offset != 0)
+    {
+      emitter.Op32Imm(0, RSI, static_cast<std::uint32_t>(offset));
+      emitter.Op32Imm(4, RSI, 0xFFFF);
+    }
+  };
+
+  // PUSH_N16 order, the high byte goes to SP - 1 first. A negative register pushes value instead.
+  auto push = [&](int index, int high, int low, std::uint16_t value) {
+    stackAddress(-2);
+    bailOnIOWrite(2, index, block.instructions[index].address);
+    emitter.StoreWord(offsetSP, RSI);
+    emitter.Op32Imm(0, RSI, 1);
+    if (high >= 0)
+    {
+      emitter.Movzx8(RDX, high);
+    }
+    else
+    {
+      emitter.MovImm32(RDX, value >> 8);
+    }
+    write();
+    stackAddress(0);
+    if (low >= 0)
+    {
+      emitter.Movzx8(RDX, low);
+    }
+    else
+    {
+      emitter.MovImm32(RDX, value & 0xFF);
+    }
+    write();
+  };
+
+  auto pop = [&](int high, int low) {
+    stackAddress(0);
+    read(low);
+    stackAddress(1);
+    read(high);
+    emitter.AddWordImm(offsetSP, 2);
+  };
+
+  auto stepPair = [&](int high, int low, bool increment) {
+    emitter.Op8Imm(increment ? 0 : 5, low, 1);
+    emitter.Op8Imm(increment ? 2 : 3, high, 0);
+  };
+
+  // x86 opcodes and immediate group extensions for ADD ADC SUB SBC AND XOR OR CP.
+  constexpr std::array<std::uint8_t, 8> aluOpcodes = {0x00, 0x10, 0x28, 0x18, 0x20, 0x30, 0x08, 0x38};
+  constexpr std::array<int, 8> aluExtensions = {0, 2, 5, 3, 4, 6, 1, 7};
+
+  auto alu = [&](int operation, int src, std::uint8_t imm) {
+    if (operation == 1 || operation == 3)
+    {
+      emitter.BitTest(hostF, 4);
+    }
+
+    if (src >= 0)
+    {
+      emitter.Op8(aluOpcodes[operation], hostA, src);
+    }
+    else
+    {
+      emitter.Op8Imm(aluExtensions[operation], hostA, imm);
+    }
+
+    flagsFromHost(hostF);
+
+    switch (operation)
+    {
+    case 2:
+    case 3:
+    case 7:
+      emitter.Op8Imm(1, hostF, 0x40);
+      break;
+    case 4:
+      emitter.Op8Imm(4, hostF, 0x80);
+      emitter.Op8Imm(1, hostF, 0x20);
+      break;
+    case 5:
+    case 6:
+      emitter.Op8Imm(4, hostF, 0x80);
+      break;
+    default:
+      break;
+    }
+  };
+
+  auto incDec = [&](int reg, bool increment) {
+    emitter.Unary8(0xFE, increment ? 0 : 1, reg);
+    flagsFromHost(RDX);
+    emitter.Op8Imm(4, RDX, 0xA0);
+    emitter.Op8Imm(4, hostF, 0x10);
+    emitter.Op8(0x08, hostF, RDX);
+    if (!increment)
+    {
+      emitter.Op8Imm(1, hostF, 0x40);
+    }
+  };
+
+  // x86 rotate and shift extensions for RLC RRC RL RR SLA SRA SWAP SRL, SWAP is a rotate by 4.
+  constexpr std::array<int, 8> shiftExtensions = {0, 1, 2, 3, 4, 7, 0, 5};
+
+  auto shift = [&](int operation, int reg) {
+    if (operation == 2 || operation == 3)
+    {
+      emitter.BitTest(hostF, 4);
+    }
+
+    if (operation == 6)
+    {
+      emitter.Rol8(reg, 4);
+      emitter.MovImm32(RDX, 0);
+    }
+    else
+    {
+      emitter.Unary8(0xD0, shiftExtensions[operation], reg);
+      emitter.Setc(RDX);
+      emitter.Shl8(RDX, 4);
+    }
+
+    emitter.Test8(reg, reg);
+    emitter.Setcc(Zero, RAX);
+    emitter.Shl8(RAX, 7);
+    emitter.Op8(0x08, RDX, RAX);
+    emitter.Mov8(hostF, RDX);
+  };
+
+  auto conditionBit = [](std::uint8_t opcode) { return ((opcode >> 3) & 2) ? 4 : 7; };
+  auto conditionTaken = [](std::uint8_t opcode) { return ((opcode >> 3) & 1) ? Carry : NotCarry; };
+  auto conditionNotTaken = [](std::uint8_t opcode) { return ((opcode >> 3) & 1) ? NotCarry : Carry; };
+
+  // Jumps over a conditional CALL or RET when its condition does not hold, falling through ends the block.
+  auto skipUnlessTaken = [&](std::uint8_t opcode) {
+    emitter.BitTest(hostF, conditionBit(opcode));
+    return emitter.Jcc(conditionNotTaken(opcode));
+  };
+
+  // Goes back to the start of the block while the caller allows more iterations, returns the exit taken otherwise.
+  auto loopBack = [&]() {
+    emitter.CompareContextDword(offsetof(Context, iterations), 0);
+    std::size_t done = emitter.Jcc(Zero);
+    emitter.DecrementContextDword(offsetof(Context, iterations));
+    emitter.Patch(emitter.Jmp(), loopStart);
+    loops = true;
+    return done;
+  };
+
+  std::size_t compiled = 0;
+  bool terminated = false;
+
+  for (const BlockCache::Instruction& instruction : block.instructions)
+  {
+    const std::uint8_t opcode = instruction.opcode;
+    const int index = static_cast<int>(compiled);
+    const int executed = index + 1;
+    const CPU::OpcodeDescription& description =
+        instruction.extended ? CPU::extendedOpcodeTable[opcode] : CPU::opcodeTable[opcode];
+    const std::uint16_t next = instruction.address + instruction.length;
+    const std::size_t start = emitter.Size();
+    const std::size_t exitCount = exits.size();
+    cyclesAfter = cyclesBefore + description.cycles;
+
+    bool supported = instruction.length != 0;
+
+    if (!supported)
+    {
+    }
+    else if (instruction.extended)
+    {
+      // Rotates, shifts, BIT, RES and SET on registers
+      int reg = hostRegisters[opcode & 7];
+      int bit = (opcode >> 3) & 7;
+      if (reg < 0)
+      {
+        supported = false;
+      }
+      else if (opcode < 0x40)
+      {
+        shift(bit, reg);
+      }
+      else if (opcode < 0x80)
+      {
+        emitter.BitTest(reg, bit);
+        emitter.Setcc(NotCarry, RDX);
+        emitter.Shl8(RDX, 7);
+        emitter.Op8Imm(4, hostF, 0x10);
+        emitter.Op8Imm(1, hostF, 0x20);
+        emitter.Op8(0x08, hostF, RDX);
+      }
+      else if (opcode < 0xC0)
+      {
+        emitter.Op8Imm(4, reg, static_cast<std::uint8_t>(~(1 << bit)));
+      }
+      else
+      {
+        emitter.Op8Imm(1, reg, static_cast<std::uint8_t>(1 << bit));
+      }
+    }
+    else if (opcode == 0x00)
+    {
+      // NOP
+    }
+    else if ((opcode & 0xCF) == 0x01)
+    {
+      // LD r16,n16
+      switch (opcode >> 4)
+      {
+      case 0:
+        emitter.Mov8Imm(hostB, instruction.operand >> 8);
+        emitter.Mov8Imm(hostC, instruction.operand & 0xFF);
+        break;
+      case 1:
+        emitter.Mov8Imm(hostD, instruction.operand >> 8);
+        emitter.Mov8Imm(hostE, instruction.operand & 0xFF);
+        break;
+      case 2:
+        emitter.Mov8Imm(hostH, instruction.operand >> 8);
+        emitter.Mov8Imm(hostL, instruction.operand & 0xFF);
+        break;
+      default:
+        emitter.StoreWordImm(offsetSP, instruction.operand);
+        break;
+      }
+    }
+    else if ((opcode & 0xC7) == 0x03)
+    {
+      // INC r16 / DEC r16
+      bool increment = !(opcode & 0x08);
+      switch (opcode >> 4)
+      {
+      case 0:
+        stepPair(hostB, hostC, increment);
+        break;
+      case 1:
+        stepPair(hostD, hostE, increment);
+        break;
+      case 2:
+        stepPair(hostH, hostL, increment);
+        break;
+      default:
+        emitter.IncDecWord(increment ? 0 : 1, offsetSP);
+        break;
+      }
+    }
+    else if ((opcode & 0xC6) == 0x04 && ((opcode >> 3) & 7) != 6)
+    {
+      // INC r8 / DEC r8
+      incDec(hostRegisters[(opcode >> 3) & 7], !(opcode & 1));
+    }
+    else if ((opcode & 0xC7) == 0x06)
+    {
+      // LD r8,n8 / LD (HL),n8
+      int dst = (opcode >> 3) & 7;
+      if (dst != 6)
+      {
+        emitter.Mov8Imm(hostRegisters[dst], instruction.operand);
+      }
+      else
+      {
+        pairAddress(hostH, hostL);
+        bailOnIOWrite(1, index, instruction.address);
+        emitter.MovImm32(RDX, instruction.operand & 0xFF);
+        write();
+        leaveIfOverwritten(executed, next);
+      }
+    }
+    else if (opcode == 0x02 || opcode == 0x12 || opcode == 0x22 || opcode == 0x32)
+    {
+      // LD (BC),A / LD (DE),A / LD (HL+),A / LD (HL-),A
+      if (opcode == 0x02)
+      {
+        pairAddress(hostB, hostC);
+      }
+      else if (opcode == 0x12)
+      {
+        pairAddress(hostD, hostE);
+      }
+      else
+      {
+        pairAddress(hostH, hostL);
+      }
+      bailOnIOWrite(1, index, instruction.address);
+      if (opcode == 0x22 || opcode == 0x32)
+      {
+        stepPair(hostH, hostL, opcode == 0x22);
+      }
+      emitter.Movzx8(RDX, hostA);
+      write();
+      leaveIfOverwritten(executed, next);
+    }
+    else if (opcode == 0x0A || opcode == 0x1A || opcode == 0x2A || opcode == 0x3A)
+    {
+      // LD A,(BC) / LD A,(DE) / LD A,(HL+) / LD A,(HL-)
+      if (opcode == 0x0A)
+      {
+        pairAddress(hostB, hostC);
+      }
+      else if (opcode == 0x1A)
+      {
+        pairAddress(hostD, hostE);
+      }
+      else
+      {
+        pairAddress(hostH, hostL);
+      }
+      read(hostA);
+      if (opcode == 0x2A || opcode == 0x3A)
+      {
+        stepPair(hostH, hostL, opcode == 0x2A);
+      }
+    }
+    else if (opcode == 0x07 || opcode == 0x0F || opcode == 0x17 || opcode == 0x1F)
+    {
+      // RLCA / RRCA / RLA / RRA
+      if (opcode == 0x17 || opcode == 0x1F)
+      {
+        emitter.BitTest(hostF, 4);
+      }
+      emitter.Unary8(0xD0, (opcode >> 3) & 3, hostA);
+      carryToFlags();
+    }
+    else if (opcode == 0x2F)
+    {
+      // CPL
+      emitter.Unary8(0xF6, 2, hostA);
+      emitter.Op8Imm(1, hostF, 0x60);
+    }
+    else if (opcode == 0x37)
+    {
+      // SCF
+      emitter.Op8Imm(4, hostF, 0x80);
+      emitter.Op8Imm(1, hostF, 0x10);
+    }
+    else if (opcode == 0x3F)
+    {
+      // CCF
+      emitter.Op8Imm(4, hostF, 0x90);
+      emitter.Op8Imm(6, hostF, 0x10);
+    }
+    else if (opcode == 0x18 || opcode == 0xC3)
+    {
+      // JR e8 / JP a16
+      std::uint16_t target =
+          (opcode == 0x18) ? static_cast<std::uint16_t>(next + static_cast<std::int8_t>(instruction.operand & 0xFF))
+                           : instruction.operand;
+      bool loop = target == block.startAddress && !writesMemory;
+      exits.push_back({loop ? loopBack() : emitter.Jmp(), executed, cyclesAfter, target});
+      terminated = true;
+    }
+    else if ((opcode & 0xE7) == 0x20 || (opcode & 0xE7) == 0xC2)
+    {
+      // JR cc,e8 / JP cc,a16, falling through ends the block as well
+      std::uint16_t target =
+          (opcode < 0x40) ? static_cast<std::uint16_t>(next + static_cast<std::int8_t>(instruction.operand & 0xFF))
+                          : instruction.operand;
+      emitter.BitTest(hostF, conditionBit(opcode));
+      if (target == block.startAddress && !writesMemory)
+      {
+        std::size_t skip = emitter.Jcc(conditionNotTaken(opcode));
+        exits.push_back({loopBack(), executed, cyclesAfter, target});
+        emitter.Patch(skip, emitter.Size());
+      }
+      else
+      {
+        exits.push_back({emitter.Jcc(conditionTaken(opcode)), executed, cyclesAfter, target});
+      }
+    }
+    else if (opcode == 0xE9)
+    {
+      // JP HL
+      pairAddress(hostH, hostL);
+      emitter.StoreWord(offsetPC, RSI);
+      emitter.MovImm32(RAX, PackResult(executed, cyclesAfter));
+      epilogueFixups.push_back(emitter.Jmp());
+      terminated = true;
+    }
+    else if (opcode == 0xCD || (opcode & 0xE7) == 0xC4 || (opcode & 0xC7) == 0xC7)
+    {
+      // CALL a16 / CALL cc,a16 / RST
+      std::uint16_t target =
+          ((opcode & 0xC7) == 0xC7) ? static_cast<std::uint16_t>(opcode & 0x38) : instruction.operand;
+      bool conditional = (opcode & 0xE7) == 0xC4;
+      std::size_t skip = conditional ? skipUnlessTaken(opcode) : 0;
+      push(index, -1, -1, next);
+      leaveIfOverwritten(executed, target);
+      exits.push_back({emitter.Jmp(), executed, cyclesAfter, target});
+      if (conditional)
+      {
+        emitter.Patch(skip, emitter.Size());
+      }
+      terminated = !conditional;
+    }
+    else if (opcode == 0xC9 || (opcode & 0xE7) == 0xC0)
+    {
+      // RET / RET cc
+      bool conditional = opcode != 0xC9;
+      std::size_t skip = conditional ? skipUnlessTaken(opcode) : 0;
+      stackAddress(0);
+      read(RAX);
+      emitter.StoreRegister(offsetPC, RAX);
+      stackAddress(1);
+      read(RAX);
+      emitter.StoreRegister(offsetPC + 1, RAX);
+      emitter.AddWordImm(offsetSP, 2);
+      emitter.MovImm32(RAX, PackResult(executed, cyclesAfter));
+      epilogueFixups.push_back(emitter.Jmp());
+      if (conditional)
+      {
+        emitter.Patch(skip, emitter.Size());
+      }
+      terminated = !conditional;
+    }
+    else if ((opcode & 0xCF) == 0xC5)
+    {
+      // PUSH r16, F keeps its low nibble clear
+      switch ((opcode >> 4) & 3)
+      {
+      case 0:
+        push(index, hostB, hostC, 0);
+        break;
+      case 1:
+        push(index, hostD, hostE, 0);
+        break;
+      case 2:
+        push(index, hostH, hostL, 0);
+        break;
+      default:
+        emitter.Op8Imm(4, hostF, 0xF0);
+        push(index, hostA, hostF, 0);
+        break;
+      }
+      leaveIfOverwritten(executed, next);
+    }
+    else if ((opcode & 0xCF) == 0xC1)
+    {
+      // POP r16
+      switch ((opcode >> 4) & 3)
+      {
+      case 0:
+        pop(hostB, hostC);
+        break;
+      case 1:
+        pop(hostD, hostE);
+        break;
+      case 2:
+        pop(hostH, hostL);
+        break;
+      default:
+        pop(hostA, hostF);
+        emitter.Op8Imm(4, hostF, 0xF0);
+        break;
+      }
+    }
+    else if (opcode >= 0x40 && opcode < 0x80 && opcode != 0x76)
+    {
+      // LD r8,r8 / LD r8,(HL) / LD (HL),r8
+      int dst = (opcode >> 3) & 7;
+      int src = opcode & 7;
+      if (src == 6)
+      {
+        pairAddress(hostH, hostL);
+        read(hostRegisters[dst]);
+      }
+      else if (dst == 6)
+      {
+        pairAddress(hostH, hostL);
+        bailOnIOWrite(1, index, instruction.address);
+        emitter.Movzx8(RDX, hostRegisters[src]);
+        write();
+        leaveIfOverwritten(executed, next);
+      }
+      else if (dst != src)
+      {
+        emitter.Mov8(hostRegisters[dst], hostRegisters[src]);
+      }
+    }
+    else if (opcode >= 0x80 && opcode < 0xC0)
+    {
+      // ALU A,r8 / ALU A,(HL)
+      int src = opcode & 7;
+      if (src == 6)
+      {
+        pairAddress(hostH, hostL);
+        read(RAX);
+        alu((opcode >> 3) & 7, RAX, 0);
+      }
+      else
+      {
+        alu((opcode >> 3) & 7, hostRegisters[src], 0);
+      }
+    }
+    else if ((opcode & 0xC7) == 0xC6)
+    {
+      // ALU A,n8
+      alu((opcode >> 3) & 7, -1, instruction.operand & 0xFF);
+    }
+    else if (opcode == 0xFA || opcode == 0xF0 || opcode == 0xF2)
+    {
+      // LD A,(a16) / LDH A,(a8) / LD A,(C), IO registers read without side effects
+      if (opcode == 0xF2)
+      {
+        emitter.Movzx8(RSI, hostC);
+        emitter.Op32Imm(1, RSI, 0xFF00);
+      }
+      else
+      {
+        emitter.MovImm32(RSI, (opcode == 0xFA) ? instruction.operand : (0xFF00 | (instruction.operand & 0xFF)));
+      }
+      read(hostA);
+    }
+    else if ((opcode == 0xEA && !IsIOWrite(instruction.operand)) ||
+             (opcode == 0xE0 && !IsIOWrite(0xFF00 | (instruction.operand & 0xFF))) || opcode == 0xE2)
+    {
+      // LD (a16),A / LDH (a8),A / LD (C),A, HRAM only
+      if (opcode == 0xE2)
+      {
+        emitter.Movzx8(RSI, hostC);
+        emitter.Op32Imm(1, RSI, 0xFF00);
+        bailOnIOWrite(1, index, instruction.address);
+      }
+      else
+      {
+        emitter.MovImm32(RSI, (opcode == 0xEA) ? instruction.operand : (0xFF00 | (instruction.operand & 0xFF)));
+      }
+      emitter.Movzx8(RDX, hostA);
+      write();
+      leaveIfOverwritten(executed, next);
+    }
+    else
+    {
+      supported = false;
+    }
+
+    if (!supported)
+    {
+      emitter.Rewind(start);
+      exits.resize(exitCount);
+      break;
+    }
+
+    ++compiled;
+    longestCycles = std::max(longestCycles, cyclesAfter);
+    cyclesBefore += (description.cyclesNotTaken != 0) ? description.cyclesNotTaken : description.cycles;
+
+    if (terminated)
+    {
+      break;
+    }
+  }
+
+  if (compiled == 0)
+  {
+    protect(PROT_READ | PROT_EXEC);
+    return false;
+  }
+
+  if (!terminated)
+  {
+    const BlockCache::Instruction& last = block.instructions[compiled - 1];
+    emitter.StoreWordImm(offsetPC, last.address + last.length);
+    emitter.MovImm32(RAX, PackResult(compiled, cyclesBefore));
+  }
+
+  // Epilogue, writes the SM83 registers back.
+  std::size_t epilogue = emitter.Size();
+  for (std::size_t fixup : epilogueFixups)
+  {
+    emitter.Patch(fixup, epilogue);
+  }
+  for (auto [reg, offset] : registerSlots)
+  {
+    emitter.StoreRegister(offset, reg);
+  }
+  emitter.AddRsp(8);
+  for (int reg : {R15, R14, R13, R12, RBP, RBX})
+  {
+    emitter.Pop(reg);
+  }
+  emitter.Ret();
+
+  for (const Exit& exit : exits)
+  {
+    emitter.Patch(exit.fixup, emitter.Size());
+    emitter.StoreWordImm(offsetPC, exit.pc);
+    emitter.MovImm32(RAX, PackResult(exit.executed, exit.cycles));
+    emitter.Patch(emitter.Jmp(), epilogue);
+  }
+
+  protect(PROT_READ | PROT_EXEC);
+
+  if (emitter.Overflowed())
+  {
+    return false;
+  }
+
+  block.native = reinterpret_cast<BlockCache::NativeCode>(code + codeUsed);
+  block.nativeLength = compiled;
+  block.nativeCycles = static_cast<std::uint64_t>(std::max(cyclesBefore, longestCycles));
+  // Only the last instruction can branch back, after a pass through all of the native code.
+  block.loopCycles = loops ? static_cast<std::uint64_t>(cyclesAfter) : 0;
+  codeUsed += (emitter.Size() + 15) & ~std::size_t{15};
+
+  return true;
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "blockcache.hpp"
+
+class MMU;
+
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__unix__) || defined(__APPLE__))
+#define GBE_JIT_AVAILABLE 1
+#else
+#define GBE_JIT_AVAILABLE 0
+#endif
+
+/**
+ * @brief Translates hot cached blocks into x86-64 code.
+ *
+ * The SM83 registers live in host registers for the whole block. Memory goes through the MMU page table inline, pages
+ * without a host pointer through helpers calling Get and Set. IO reads have no side effects and run natively, but the
+ * native code bails out to the interpreter before writing an IO register or IE, so interrupt requests and scheduled
+ * events are always handled by the interpreter. A write that overwrites the running block or switches banks ends it
+ * right after that instruction.
+ *
+ * Only the longest prefix of a block made of supported opcodes is translated, the interpreter runs the rest. A block
+ * ending in a branch back to its start loops in native code as many times as the caller allows.
+ */
+class Jit
+{
+public:
+  static constexpr std::uint32_t hotThreshold = 16;
+  // Address space the native code of one instance is emitted into, mapped by its first Compile.
+  static constexpr std::size_t codeCapacity = 4 * 1024 * 1024;
+
+  explicit Jit(MMU& mmu);
+  ~Jit();
+
+  Jit(const Jit&) = delete;
+  Jit& operator=(const Jit&) = delete;
+
+  static bool IsAvailable() { return GBE_JIT_AVAILABLE; }
+
+  struct Result
+  {
+    // Instructions of the block completed by the last pass, and the totals over all passes.
+    std::size_t position;
+    std::uint64_t executed;
+    std::uint64_t cycles;
+  };
+
+  bool Compile(BlockCache::Block& block);
+  Result Execute(const BlockCache::Block& block, void* registers, std::uint32_t iterations);
+
+  [[nodiscard]] bool IsFull() const;
+  void Flush();
+
+private:
+  static constexpr std::size_t maxBlockCodeSize = 16 * 1024;
+
+  // Passed to the native code and the memory helpers it calls.
+  struct Context
+  {
+    MMU* mmu;
+    const BlockCache::Block* block;
+    // Set by Write when it hit the running block or switched banks since bankSwitches was taken.
+    bool overwritten;
+    std::uint64_t bankSwitches;
+    // Times the native code may still go back to the start of the block.
+    std::uint32_t iterations;
+  };
+
+  Context context;
+
+  // Mapped by the first Compile.
+  std::uint8_t* code = nullptr;
+  std::size_t codeUsed = 0;
+  bool mapFailed = false;
+
+  bool MapCode();
+
+  // Native code returns the executed instructions in the low half and their cycles in the high half.
+  static constexpr std::uint32_t PackResult(std::size_t executed, int cycles)
+  {
+    return static_cast<std::uint32_t>(executed) | (static_cast<std::uint32_t>(cycles) << 16);
+  }
+
+  static std::uint8_t Read(Context* context, std::uint32_t address);
+  static void Write(Context* context, std::uint32_t address, std::uint32_t value);
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+
+namespace opcodes
+{
+
+// Mnemonics as in the Pan Docs opcode tables, for reports and debug output.
+constexpr std::array<const char*, 256> mnemonics = {{
+    "NOP", "LD BC,n16", "LD (BC),A", "INC BC", "INC B", "DEC B", "LD B,n8", "RLCA", // 00
+    "LD (a16),SP", "ADD HL,BC", "LD A,(BC)", "DEC BC", "INC C", "DEC C", "LD C,n8", "RRCA", // 08
+    "STOP n8", "LD DE,n16", "LD (DE),A", "INC DE", "INC D", "DEC D", "LD D,n8", "RLA", // 10
+    "JR e8", "ADD HL,DE", "LD A,(DE)", "DEC DE", "INC E", "DEC E", "LD E,n8", "RRA", // 18
+    "JR NZ,e8", "LD HL,n16", "LD (HL+),A", "INC HL", "INC H", "DEC H", "LD H,n8", "DAA", // 20
+    "JR Z,e8", "ADD HL,HL", "LD A,(HL+)", "DEC HL", "INC L", "DEC L", "LD L,n8", "CPL", // 28
+    "JR NC,e8", "LD SP,n16", "LD (HL-),A", "INC SP", "INC (HL)", "DEC (HL)", "LD (HL),n8", "SCF", // 30
+    "JR C,e8", "ADD HL,SP", "LD A,(HL-)", "DEC SP", "INC A", "DEC A", "LD A,n8", "CCF", // 38
+    "LD B,B", "LD B,C", "LD B,D", "LD B,E", "LD B,H", "LD B,L", "LD B,(HL)", "LD B,A", // 40
+    "LD C,B", "LD C,C", "LD C,D", "LD C,E", "LD C,H", "LD C,L", "LD C,(HL)", "LD C,A", // 48
+    "LD D,B", "LD D,C", "LD D,D", "LD D,E", "LD D,H", "LD D,L", "LD D,(HL)", "LD D,A", // 50
+    "LD E,B", "LD E,C", "LD E,D", "LD E,E", "LD E,H", "LD E,L", "LD E,(HL)", "LD E,A", // 58
+    "LD H,B", "LD H,C", "LD H,D", "LD H,E", "LD H,H", "LD H,L", "LD H,(HL)", "LD H,A", // 60
+    "LD L,B", "LD L,C", "LD L,D", "LD L,E", "LD L,H", "LD L,L", "LD L,(HL)", "LD L,A", // 68
+    "LD (HL),B", "LD (HL),C", "LD (HL),D", "LD (HL),E", "LD (HL),H", "LD (HL),L", "HALT", "LD (HL),A", // 70
+    "LD A,B", "LD A,C", "LD A,D", "LD A,E", "LD A,H", "LD A,L", "LD A,(HL)", "LD A,A", // 78
+    "ADD A,B", "ADD A,C", "ADD A,D", "ADD A,E", "ADD A,H", "ADD A,L", "ADD A,(HL)", "ADD A,A", // 80
+    "ADC A,B", "ADC A,C", "ADC A,D", "ADC A,E", "ADC A,H", "ADC A,L", "ADC A,(HL)", "ADC A,A", // 88
+    "SUB A,B", "SUB A,C", "SUB A,D", "SUB A,E", "SUB A,H", "SUB A,L", "SUB A,(HL)", "SUB A,A", // 90
+    "SBC A,B", "SBC A,C", "SBC A,D", "SBC A,E", "SBC A,H", "SBC A,L", "SBC A,(HL)", "SBC A,A", // 98
+    "AND A,B", "AND A,C", "AND A,D", "AND A,E", "AND A,H", "AND A,L", "AND A,(HL)", "AND A,A", // A0
+    "XOR A,B", "XOR A,C", "XOR A,D", "XOR A,E", "XOR A,H", "XOR A,L", "XOR A,(HL)", "XOR A,A", // A8
+    "OR A,B", "OR A,C", "OR A,D", "OR A,E", "OR A,H", "OR A,L", "OR A,(HL)", "OR A,A", // B0
+    "CP A,B", "CP A,C", "CP A,D", "CP A,E", "CP A,H", "CP A,L", "CP A,(HL)", "CP A,A", // B8
+    "RET NZ", "POP BC", "JP NZ,a16", "JP a16", "CALL NZ,a16", "PUSH BC", "ADD A,n8", "RST $00", // C0
+    "RET Z", "RET", "JP Z,a16", "PREFIX CB", "CALL Z,a16", "CALL a16", "ADC A,n8", "RST $08", // C8
+    "RET NC", "POP DE", "JP NC,a16", "invalid", "CALL NC,a16", "PUSH DE", "SUB A,n8", "RST $10", // D0
+    "RET C", "RETI", "JP C,a16", "invalid", "CALL C,a16", "invalid", "SBC A,n8", "RST $18", // D8
+    "LDH (a8),A", "POP HL", "LDH (C),A", "invalid", "invalid", "PUSH HL", "AND A,n8", "RST $20", // E0
+    "ADD SP,e8", "JP HL", "LD (a16),A", "invalid", "invalid", "invalid", "XOR A,n8", "RST $28", // E8
+    "LDH A,(a8)", "POP AF", "LDH A,(C)", "DI", "invalid", "PUSH AF", "OR A,n8", "RST $30", // F0
+    "LD HL,SP+e8", "LD SP,HL", "LD A,(a16)", "EI", "invalid", "invalid", "CP A,n8", "RST $38", // F8
+}};
+
+constexpr std::array<const char*, 256> extendedMnemonics = {{
+    "RLC B", "RLC C", "RLC D", "RLC E", "RLC H", "RLC L", "RLC (HL)", "RLC A", // 00
+    "RRC B", "RRC C", "RRC D", "RRC E", "RRC H", "RRC L", "RRC (HL)", "RRC A", // 08
+    "RL B", "RL C", "RL D", "RL E", "RL H", "RL L", "RL (HL)", "RL A", // 10
+    "RR B", "RR C", "RR D", "RR E", "RR H", "RR L", "RR (HL)", "RR A", // 18
+    "SLA B", "SLA C", "SLA D", "SLA E", "SLA H", "SLA L", "SLA (HL)", "SLA A", // 20
+    "SRA B", "SRA C", "SRA D", "SRA E", "SRA H", "SRA L", "SRA (HL)", "SRA A", // 28
+    "SWAP B", "SWAP C", "SWAP D", "SWAP E", "SWAP H", "SWAP L", "SWAP (HL)", "SWAP A", // 30
+    "SRL B", "SRL C", "SRL D", "SRL E", "SRL H", "SRL L", "SRL (HL)", "SRL A", // 38
+    "BIT 0,B", "BIT 0,C", "BIT 0,D", "BIT 0,E", "BIT 0,H", "BIT 0,L", "BIT 0,(HL)", "BIT 0,A", // 40
+    "BIT 1,B", "BIT 1,C", "BIT 1,D", "BIT 1,E", "BIT 1,H", "BIT 1,L", "BIT 1,(HL)", "BIT 1,A", // 48
+    "BIT 2,B", "BIT 2,C", "BIT 2,D", "BIT 2,E", "BIT 2,H", "BIT 2,L", "BIT 2,(HL)", "BIT 2,A", // 50
+    "BIT 3,B", "BIT 3,C", "BIT 3,D", "BIT 3,E", "BIT 3,H", "BIT 3,L", "BIT 3,(HL)", "BIT 3,A", // 58
+    "BIT 4,B", "BIT 4,C", "BIT 4,D", "BIT 4,E", "BIT 4,H", "BIT 4,L", "BIT 4,(HL)", "BIT 4,A", // 60
+    "BIT 5,B", "BIT 5,C", "BIT 5,D", "BIT 5,E", "BIT 5,H", "BIT 5,L", "BIT 5,(HL)", "BIT 5,A", // 68
+    "BIT 6,B", "BIT 6,C", "BIT 6,D", "BIT 6,E", "BIT 6,H", "BIT 6,L", "BIT 6,(HL)", "BIT 6,A", // 70
+    "BIT 7,B", "BIT 7,C", "BIT 7,D", "BIT 7,E", "BIT 7,H", "BIT 7,L", "BIT 7,(HL)", "BIT 7,A", // 78
+    "RES 0,B", "RES 0,C", "RES 0,D", "RES 0,E", "RES 0,H", "RES 0,L", "RES 0,(HL)", "RES 0,A", // 80
+    "RES 1,B", "RES 1,C", "RES 1,D", "RES 1,E", "RES 1,H", "RES 1,L", "RES 1,(HL)", "RES 1,A", // 88
+    "RES 2,B", "RES 2,C", "RES 2,D", "RES 2,E", "RES 2,H", "RES 2,L", "RES 2,(HL)", "RES 2,A", // 90
+    "RES 3,B", "RES 3,C", "RES 3,D", "RES 3,E", "RES 3,H", "RES 3,L", "RES 3,(HL)", "RES 3,A", // 98
+    "RES 4,B", "RES 4,C", "RES 4,D", "RES 4,E", "RES 4,H", "RES 4,L", "RES 4,(HL)", "RES 4,A", // A0
+    "RES 5,B", "RES 5,C", "RES 5,D", "RES 5,E", "RES 5,H", "RES 5,L", "RES 5,(HL)", "RES 5,A", // A8
+    "RES 6,B", "RES 6,C", "RES 6,D", "RES 6,E", "RES 6,H", "RES 6,L", "RES 6,(HL)", "RES 6,A", // B0
+    "RES 7,B", "RES 7,C", "RES 7,D", "RES 7,E", "RES 7,H", "RES 7,L", "RES 7,(HL)", "RES 7,A", // B8
+    "SET 0,B", "SET 0,C", "SET 0,D", "SET 0,E", "SET 0,H", "SET 0,L", "SET 0,(HL)", "SET 0,A", // C0
+    "SET 1,B", "SET 1,C", "SET 1,D", "SET 1,E", "SET 1,H", "SET 1,L", "SET 1,(HL)", "SET 1,A", // C8
+    "SET 2,B", "SET 2,C", "SET 2,D", "SET 2,E", "SET 2,H", "SET 2,L", "SET 2,(HL)", "SET 2,A", // D0
+    "SET 3,B", "SET 3,C", "SET 3,D", "SET 3,E", "SET 3,H", "SET 3,L", "SET 3,(HL)", "SET 3,A", // D8
+    "SET 4,B", "SET 4,C", "SET 4,D", "SET 4,E", "SET 4,H", "SET 4,L", "SET 4,(HL)", "SET 4,A", // E0
+    "SET 5,B", "SET 5,C", "SET 5,D", "SET 5,E", "SET 5,H", "SET 5,L", "SET 5,(HL)", "SET 5,A", // E8
+    "SET 6,B", "SET 6,C", "SET 6,D", "SET 6,E", "SET 6,H", "SET 6,L", "SET 6,(HL)", "SET 6,A", // F0
+    "SET 7,B", "SET 7,C", "SET 7,D", "SET 7,E", "SET 7,H", "SET 7,L", "SET 7,(HL)", "SET 7,A", // F8
+}};
+
+} // namespace opcodes
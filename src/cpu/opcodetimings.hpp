@@ -0,0 +1,542 @@
+#pragma once
+
+#include <array>
+
+namespace opcodes
+{
+
+/**
+ * @brief Length in bytes and duration in T-cycles of an instruction.
+ *
+ * cyclesNotTaken is only set for conditional instructions, invalid opcodes have a length of 0.
+ */
+struct Timing
+{
+  int length;
+  int cycles;
+  int cyclesNotTaken;
+
+  constexpr bool operator==(const Timing& other) const
+  {
+    return length == other.length && cycles == other.cycles && cyclesNotTaken == other.cyclesNotTaken;
+  }
+  constexpr bool operator!=(const Timing& other) const { return !(*this == other); }
+};
+
+// Timings as documented in the Pan Docs opcode tables. The opcode handlers are generated from the operand kinds,
+// cpu.cpp checks at compile time that the lengths and cycles derived from those agree with this table.
+constexpr std::array<Timing, 256> documentedTimings = {
+    {{1, 4, 0}, // 00 NOP
+     {3, 12, 0}, // 01 LD BC,n16
+     {1, 8, 0}, // 02 LD (BC),A
+     {1, 8, 0}, // 03 INC BC
+     {1, 4, 0}, // 04 INC B
+     {1, 4, 0}, // 05 DEC B
+     {2, 8, 0}, // 06 LD B,n8
+     {1, 4, 0}, // 07 RLCA
+     {3, 20, 0}, // 08 LD (a16),SP
+     {1, 8, 0}, // 09 ADD HL,BC
+     {1, 8, 0}, // 0A LD A,(BC)
+     {1, 8, 0}, // 0B DEC BC
+     {1, 4, 0}, // 0C INC C
+     {1, 4, 0}, // 0D DEC C
+     {2, 8, 0}, // 0E LD C,n8
+     {1, 4, 0}, // 0F RRCA
+     {2, 4, 0}, // 10 STOP n8
+     {3, 12, 0}, // 11 LD DE,n16
+     {1, 8, 0}, // 12 LD (DE),A
+     {1, 8, 0}, // 13 INC DE
+     {1, 4, 0}, // 14 INC D
+     {1, 4, 0}, // 15 DEC D
+     {2, 8, 0}, // 16 LD D,n8
+     {1, 4, 0}, // 17 RLA
+     {2, 12, 0}, // 18 JR e8
+     {1, 8, 0}, // 19 ADD HL,DE
+     {1, 8, 0}, // 1A LD A,(DE)
+     {1, 8, 0}, // 1B DEC DE
+     {1, 4, 0}, // 1C INC E
+     {1, 4, 0}, // 1D DEC E
+     {2, 8, 0}, // 1E LD E,n8
+     {1, 4, 0}, // 1F RRA
+     {2, 12, 8}, // 20 JR NZ,e8
+     {3, 12, 0}, // 21 LD HL,n16
+     {1, 8, 0}, // 22 LD (HL+),A
+     {1, 8, 0}, // 23 INC HL
+     {1, 4, 0}, // 24 INC H
+     {1, 4, 0}, // 25 DEC H
+     {2, 8, 0}, // 26 LD H,n8
+     {1, 4, 0}, // 27 DAA
+     {2, 12, 8}, // 28 JR Z,e8
+     {1, 8, 0}, // 29 ADD HL,HL
+     {1, 8, 0}, // 2A LD A,(HL+)
+     {1, 8, 0}, // 2B DEC HL
+     {1, 4, 0}, // 2C INC L
+     {1, 4, 0}, // 2D DEC L
+     {2, 8, 0}, // 2E LD L,n8
+     {1, 4, 0}, // 2F CPL
+     {2, 12, 8}, // 30 JR NC,e8
+     {3, 12, 0}, // 31 LD SP,n16
+     {1, 8, 0}, // 32 LD (HL-),A
+     {1, 8, 0}, // 33 INC SP
+     {1, 12, 0}, // 34 INC (HL)
+     {1, 12, 0}, // 35 DEC (HL)
+     {2, 12, 0}, // 36 LD (HL),n8
+     {1, 4, 0}, // 37 SCF
+     {2, 12, 8}, // 38 JR C,e8
+     {1, 8, 0}, // 39 ADD HL,SP
+     {1, 8, 0}, // 3A LD A,(HL-)
+     {1, 8, 0}, // 3B DEC SP
+     {1, 4, 0}, // 3C INC A
+     {1, 4, 0}, // 3D DEC A
+     {2, 8, 0}, // 3E LD A,n8
+     {1, 4, 0}, // 3F CCF
+     {1, 4, 0}, // 40 LD B,B
+     {1, 4, 0}, // 41 LD B,C
+     {1, 4, 0}, // 42 LD B,D
+     {1, 4, 0}, // 43 LD B,E
+     {1, 4, 0}, // 44 LD B,H
+     {1, 4, 0}, // 45 LD B,L
+     {1, 8, 0}, // 46 LD B,(HL)
+     {1, 4, 0}, // 47 LD B,A
+     {1, 4, 0}, // 48 LD C,B
+     {1, 4, 0}, // 49 LD C,C
+     {1, 4, 0}, // 4A LD C,D
+     {1, 4, 0}, // 4B LD C,E
+     {1, 4, 0}, // 4C LD C,H
+     {1, 4, 0}, // 4D LD C,L
+     {1, 8, 0}, // 4E LD C,(HL)
+     {1, 4, 0}, // 4F LD C,A
+     {1, 4, 0}, // 50 LD D,B
+     {1, 4, 0}, // 51 LD D,C
+     {1, 4, 0}, // 52 LD D,D
+     {1, 4, 0}, // 53 LD D,E
+     {1, 4, 0}, // 54 LD D,H
+     {1, 4, 0}, // 55 LD D,L
+     {1, 8, 0}, // 56 LD D,(HL)
+     {1, 4, 0}, // 57 LD D,A
+     {1, 4, 0}, // 58 LD E,B
+     {1, 4, 0}, // 59 LD E,C
+     {1, 4, 0}, // 5A LD E,D
+     {1, 4, 0}, // 5B LD E,E
+     {1, 4, 0}, // 5C LD E,H
+     {1, 4, 0}, // 5D LD E,L
+     {1, 8, 0}, // 5E LD E,(HL)
+     {1, 4, 0}, // 5F LD E,A
+     {1, 4, 0}, // 60 LD H,B
+     {1, 4, 0}, // 61 LD H,C
+     {1, 4, 0}, // 62 LD H,D
+     {1, 4, 0}, // 63 LD H,E
+     {1, 4, 0}, // 64 LD H,H
+     {1, 4, 0}, // 65 LD H,L
+     {1, 8, 0}, // 66 LD H,(HL)
+     {1, 4, 0}, // 67 LD H,A
+     {1, 4, 0}, // 68 LD L,B
+     {1, 4, 0}, // 69 LD L,C
+     {1, 4, 0}, // 6A LD L,D
+     {1, 4, 0}, // 6B LD L,E
+     {1, 4, 0}, // 6C LD L,H
+     {1, 4, 0}, // 6D LD L,L
+     {1, 8, 0}, // 6E LD L,(HL)
+     {1, 4, 0}, // 6F LD L,A
+     {1, 8, 0}, // 70 LD (HL),B
+     {1, 8, 0}, // 71 LD (HL),C
+     {1, 8, 0}, // 72 LD (HL),D
+     {1, 8, 0}, // 73 LD (HL),E
+     {1, 8, 0}, // 74 LD (HL),H
+     {1, 8, 0}, // 75 LD (HL),L
+     {1, 4, 0}, // 76 HALT
+     {1, 8, 0}, // 77 LD (HL),A
+     {1, 4, 0}, // 78 LD A,B
+     {1, 4, 0}, // 79 LD A,C
+     {1, 4, 0}, // 7A LD A,D
+     {1, 4, 0}, // 7B LD A,E
+     {1, 4, 0}, // 7C LD A,H
+     {1, 4, 0}, // 7D LD A,L
+     {1, 8, 0}, // 7E LD A,(HL)
+     {1, 4, 0}, // 7F LD A,A
+     {1, 4, 0}, // 80 ADD A,B
+     {1, 4, 0}, // 81 ADD A,C
+     {1, 4, 0}, // 82 ADD A,D
+     {1, 4, 0}, // 83 ADD A,E
+     {1, 4, 0}, // 84 ADD A,H
+     {1, 4, 0}, // 85 ADD A,L
+     {1, 8, 0}, // 86 ADD A,(HL)
+     {1, 4, 0}, // 87 ADD A,A
+     {1, 4, 0}, // 88 ADC A,B
+     {1, 4, 0}, // 89 ADC A,C
+     {1, 4, 0}, // 8A ADC A,D
+     {1, 4, 0}, // 8B ADC A,E
+     {1, 4, 0}, // 8C ADC A,H
+     {1, 4, 0}, // 8D ADC A,L
+     {1, 8, 0}, // 8E ADC A,(HL)
+     {1, 4, 0}, // 8F ADC A,A
+     {1, 4, 0}, // 90 SUB A,B
+     {1, 4, 0}, // 91 SUB A,C
+     {1, 4, 0}, // 92 SUB A,D
+     {1, 4, 0}, // 93 SUB A,E
+     {1, 4, 0}, // 94 SUB A,H
+     {1, 4, 0}, // 95 SUB A,L
+     {1, 8, 0}, // 96 SUB A,(HL)
+     {1, 4, 0}, // 97 SUB A,A
+     {1, 4, 0}, // 98 SBC A,B
+     {1, 4, 0}, // 99 SBC A,C
+     {1, 4, 0}, // 9A SBC A,D
+     {1, 4, 0}, // 9B SBC A,E
+     {1, 4, 0}, // 9C SBC A,H
+     {1, 4, 0}, // 9D SBC A,L
+     {1, 8, 0}, // 9E SBC A,(HL)
+     {1, 4, 0}, // 9F SBC A,A
+     {1, 4, 0}, // A0 AND A,B
+     {1, 4, 0}, // A1 AND A,C
+     {1, 4, 0}, // A2 AND A,D
+     {1, 4, 0}, // A3 AND A,E
+     {1, 4, 0}, // A4 AND A,H
+     {1, 4, 0}, // A5 AND A,L
+     {1, 8, 0}, // A6 AND A,(HL)
+     {1, 4, 0}, // A7 AND A,A
+     {1, 4, 0}, // A8 XOR A,B
+     {1, 4, 0}, // A9 XOR A,C
+     {1, 4, 0}, // AA XOR A,D
+     {1, 4, 0}, // AB XOR A,E
+     {1, 4, 0}, // AC XOR A,H
+     {1, 4, 0}, // AD XOR A,L
+     {1, 8, 0}, // AE XOR A,(HL)
+     {1, 4, 0}, // AF XOR A,A
+     {1, 4, 0}, // B0 OR A,B
+     {1, 4, 0}, // B1 OR A,C
+     {1, 4, 0}, // B2 OR A,D
+     {1, 4, 0}, // B3 OR A,E
+     {1, 4, 0}, // B4 OR A,H
+     {1, 4, 0}, // B5 OR A,L
+     {1, 8, 0}, // B6 OR A,(HL)
+     {1, 4, 0}, // B7 OR A,A
+     {1, 4, 0}, // B8 CP A,B
+     {1, 4, 0}, // B9 CP A,C
+     {1, 4, 0}, // BA CP A,D
+     {1, 4, 0}, // BB CP A,E
+     {1, 4, 0}, // BC CP A,H
+     {1, 4, 0}, // BD CP A,L
+     {1, 8, 0}, // BE CP A,(HL)
+     {1, 4, 0}, // BF CP A,A
+     {1, 20, 8}, // C0 RET NZ
+     {1, 12, 0}, // C1 POP BC
+     {3, 16, 12}, // C2 JP NZ,a16
+     {3, 16, 0}, // C3 JP a16
+     {3, 24, 12}, // C4 CALL NZ,a16
+     {1, 16, 0}, // C5 PUSH BC
+     {2, 8, 0}, // C6 ADD A,n8
+     {1, 16, 0}, // C7 RST $00
+     {1, 20, 8}, // C8 RET Z
+     {1, 16, 0}, // C9 RET
+     {3, 16, 12}, // CA JP Z,a16
+     {1, 4, 0}, // CB PREFIX CB
+     {3, 24, 12}, // CC CALL Z,a16
+     {3, 24, 0}, // CD CALL a16
+     {2, 8, 0}, // CE ADC A,n8
+     {1, 16, 0}, // CF RST $08
+     {1, 20, 8}, // D0 RET NC
+     {1, 12, 0}, // D1 POP DE
+     {3, 16, 12}, // D2 JP NC,a16
+     {0, 0, 0}, // D3 invalid
+     {3, 24, 12}, // D4 CALL NC,a16
+     {1, 16, 0}, // D5 PUSH DE
+     {2, 8, 0}, // D6 SUB A,n8
+     {1, 16, 0}, // D7 RST $10
+     {1, 20, 8}, // D8 RET C
+     {1, 16, 0}, // D9 RETI
+     {3, 16, 12}, // DA JP C,a16
+     {0, 0, 0}, // DB invalid
+     {3, 24, 12}, // DC CALL C,a16
+     {0, 0, 0}, // DD invalid
+     {2, 8, 0}, // DE SBC A,n8
+     {1, 16, 0}, // DF RST $18
+     {2, 12, 0}, // E0 LDH (a8),A
+     {1, 12, 0}, // E1 POP HL
+     {1, 8, 0}, // E2 LDH (C),A
+     {0, 0, 0}, // E3 invalid
+     {0, 0, 0}, // E4 invalid
+     {1, 16, 0}, // E5 PUSH HL
+     {2, 8, 0}, // E6 AND A,n8
+     {1, 16, 0}, // E7 RST $20
+     {2, 16, 0}, // E8 ADD SP,e8
+     {1, 4, 0}, // E9 JP HL
+     {3, 16, 0}, // EA LD (a16),A
+     {0, 0, 0}, // EB invalid
+     {0, 0, 0}, // EC invalid
+     {0, 0, 0}, // ED invalid
+     {2, 8, 0}, // EE XOR A,n8
+     {1, 16, 0}, // EF RST $28
+     {2, 12, 0}, // F0 LDH A,(a8)
+     {1, 12, 0}, // F1 POP AF
+     {1, 8, 0}, // F2 LDH A,(C)
+     {1, 4, 0}, // F3 DI
+     {0, 0, 0}, // F4 invalid
+     {1, 16, 0}, // F5 PUSH AF
+     {2, 8, 0}, // F6 OR A,n8
+     {1, 16, 0}, // F7 RST $30
+     {2, 12, 0}, // F8 LD HL,SP+e8
+     {1, 8, 0}, // F9 LD SP,HL
+     {3, 16, 0}, // FA LD A,(a16)
+     {1, 4, 0}, // FB EI
+     {0, 0, 0}, // FC invalid
+     {0, 0, 0}, // FD invalid
+     {2, 8, 0}, // FE CP A,n8
+     {1, 16, 0}}}; // FF RST $38
+constexpr std::array<Timing, 256> documentedExtendedTimings = {
+    {{2, 8, 0}, // 00 RLC B
+     {2, 8, 0}, // 01 RLC C
+     {2, 8, 0}, // 02 RLC D
+     {2, 8, 0}, // 03 RLC E
+     {2, 8, 0}, // 04 RLC H
+     {2, 8, 0}, // 05 RLC L
+     {2, 16, 0}, // 06 RLC (HL)
+     {2, 8, 0}, // 07 RLC A
+     {2, 8, 0}, // 08 RRC B
+     {2, 8, 0}, // 09 RRC C
+     {2, 8, 0}, // 0A RRC D
+     {2, 8, 0}, // 0B RRC E
+     {2, 8, 0}, // 0C RRC H
+     {2, 8, 0}, // 0D RRC L
+     {2, 16, 0}, // 0E RRC (HL)
+     {2, 8, 0}, // 0F RRC A
+     {2, 8, 0}, // 10 RL B
+     {2, 8, 0}, // 11 RL C
+     {2, 8, 0}, // 12 RL D
+     {2, 8, 0}, // 13 RL E
+     {2, 8, 0}, // 14 RL H
+     {2, 8, 0}, // 15 RL L
+     {2, 16, 0}, // 16 RL (HL)
+     {2, 8, 0}, // 17 RL A
+     {2, 8, 0}, // 18 RR B
+     {2, 8, 0}, // 19 RR C
+     {2, 8, 0}, // 1A RR D
+     {2, 8, 0}, // 1B RR E
+     {2, 8, 0}, // 1C RR H
+     {2, 8, 0}, // 1D RR L
+     {2, 16, 0}, // 1E RR (HL)
+     {2, 8, 0}, // 1F RR A
+     {2, 8, 0}, // 20 SLA B
+     {2, 8, 0}, // 21 SLA C
+     {2, 8, 0}, // 22 SLA D
+     {2, 8, 0}, // 23 SLA E
+     {2, 8, 0}, // 24 SLA H
+     {2, 8, 0}, // 25 SLA L
+     {2, 16, 0}, // 26 SLA (HL)
+     {2, 8, 0}, // 27 SLA A
+     {2, 8, 0}, // 28 SRA B
+     {2, 8, 0}, // 29 SRA C
+     {2, 8, 0}, // 2A SRA D
+     {2, 8, 0}, // 2B SRA E
+     {2, 8, 0}, // 2C SRA H
+     {2, 8, 0}, // 2D SRA L
+     {2, 16, 0}, // 2E SRA (HL)
+     {2, 8, 0}, // 2F SRA A
+     {2, 8, 0}, // 30 SWAP B
+     {2, 8, 0}, // 31 SWAP C
+     {2, 8, 0}, // 32 SWAP D
+     {2, 8, 0}, // 33 SWAP E
+     {2, 8, 0}, // 34 SWAP H
+     {2, 8, 0}, // 35 SWAP L
+     {2, 16, 0}, // 36 SWAP (HL)
+     {2, 8, 0}, // 37 SWAP A
+     {2, 8, 0}, // 38 SRL B
+     {2, 8, 0}, // 39 SRL C
+     {2, 8, 0}, // 3A SRL D
+     {2, 8, 0}, // 3B SRL E
+     {2, 8, 0}, // 3C SRL H
+     {2, 8, 0}, // 3D SRL L
+     {2, 16, 0}, // 3E SRL (HL)
+     {2, 8, 0}, // 3F SRL A
+     {2, 8, 0}, // 40 BIT 0,B
+     {2, 8, 0}, // 41 BIT 0,C
+     {2, 8, 0}, // 42 BIT 0,D
+     {2, 8, 0}, // 43 BIT 0,E
+     {2, 8, 0}, // 44 BIT 0,H
+     {2, 8, 0}, // 45 BIT 0,L
+     {2, 12, 0}, // 46 BIT 0,(HL)
+     {2, 8, 0}, // 47 BIT 0,A
+     {2, 8, 0}, // 48 BIT 1,B
+     {2, 8, 0}, // 49 BIT 1,C
+     {2, 8, 0}, // 4A BIT 1,D
+     {2, 8, 0}, // 4B BIT 1,E
+     {2, 8, 0}, // 4C BIT 1,H
+     {2, 8, 0}, // 4D BIT 1,L
+     {2, 12, 0}, // 4E BIT 1,(HL)
+     {2, 8, 0}, // 4F BIT 1,A
+     {2, 8, 0}, // 50 BIT 2,B
+     {2, 8, 0}, // 51 BIT 2,C
+     {2, 8, 0}, // 52 BIT 2,D
+     {2, 8, 0}, // 53 BIT 2,E
+     {2, 8, 0}, // 54 BIT 2,H
+     {2, 8, 0}, // 55 BIT 2,L
+     {2, 12, 0}, // 56 BIT 2,(HL)
+     {2, 8, 0}, // 57 BIT 2,A
+     {2, 8, 0}, // 58 BIT 3,B
+     {2, 8, 0}, // 59 BIT 3,C
+     {2, 8, 0}, // 5A BIT 3,D
+     {2, 8, 0}, // 5B BIT 3,E
+     {2, 8, 0}, // 5C BIT 3,H
+     {2, 8, 0}, // 5D BIT 3,L
+     {2, 12, 0}, // 5E BIT 3,(HL)
+     {2, 8, 0}, // 5F BIT 3,A
+     {2, 8, 0}, // 60 BIT 4,B
+     {2, 8, 0}, // 61 BIT 4,C
+     {2, 8, 0}, // 62 BIT 4,D
+     {2, 8, 0}, // 63 BIT 4,E
+     {2, 8, 0}, // 64 BIT 4,H
+     {2, 8, 0}, // 65 BIT 4,L
+     {2, 12, 0}, // 66 BIT 4,(HL)
+     {2, 8, 0}, // 67 BIT 4,A
+     {2, 8, 0}, // 68 BIT 5,B
+     {2, 8, 0}, // 69 BIT 5,C
+     {2, 8, 0}, // 6A BIT 5,D
+     {2, 8, 0}, // 6B BIT 5,E
+     {2, 8, 0}, // 6C BIT 5,H
+     {2, 8, 0}, // 6D BIT 5,L
+     {2, 12, 0}, // 6E BIT 5,(HL)
+     {2, 8, 0}, // 6F BIT 5,A
+     {2, 8, 0}, // 70 BIT 6,B
+     {2, 8, 0}, // 71 BIT 6,C
+     {2, 8, 0}, // 72 BIT 6,D
+     {2, 8, 0}, // 73 BIT 6,E
+     {2, 8, 0}, // 74 BIT 6,H
+     {2, 8, 0}, // 75 BIT 6,L
+     {2, 12, 0}, // 76 BIT 6,(HL)
+     {2, 8, 0}, // 77 BIT 6,A
+     {2, 8, 0}, // 78 BIT 7,B
+     {2, 8, 0}, // 79 BIT 7,C
+     {2, 8, 0}, // 7A BIT 7,D
+     {2, 8, 0}, // 7B BIT 7,E
+     {2, 8, 0}, // 7C BIT 7,H
+     {2, 8, 0}, // 7D BIT 7,L
+     {2, 12, 0}, // 7E BIT 7,(HL)
+     {2, 8, 0}, // 7F BIT 7,A
+     {2, 8, 0}, // 80 RES 0,B
+     {2, 8, 0}, // 81 RES 0,C
+     {2, 8, 0}, // 82 RES 0,D
+     {2, 8, 0}, // 83 RES 0,E
+     {2, 8, 0}, // 84 RES 0,H
+     {2, 8, 0}, // 85 RES 0,L
+     {2, 16, 0}, // 86 RES 0,(HL)
+     {2, 8, 0}, // 87 RES 0,A
+     {2, 8, 0}, // 88 RES 1,B
+     {2, 8, 0}, // 89 RES 1,C
+     {2, 8, 0}, // 8A RES 1,D
+     {2, 8, 0}, // 8B RES 1,E
+     {2, 8, 0}, // 8C RES 1,H
+     {2, 8, 0}, // 8D RES 1,L
+     {2, 16, 0}, // 8E RES 1,(HL)
+     {2, 8, 0}, // 8F RES 1,A
+     {2, 8, 0}, // 90 RES 2,B
+     {2, 8, 0}, // 91 RES 2,C
+     {2, 8, 0}, // 92 RES 2,D
+     {2, 8, 0}, // 93 RES 2,E
+     {2, 8, 0}, // 94 RES 2,H
+     {2, 8, 0}, // 95 RES 2,L
+     {2, 16, 0}, // 96 RES 2,(HL)
+     {2, 8, 0}, // 97 RES 2,A
+     {2, 8, 0}, // 98 RES 3,B
+     {2, 8, 0}, // 99 RES 3,C
+     {2, 8, 0}, // 9A RES 3,D
+     {2, 8, 0}, // 9B RES 3,E
+     {2, 8, 0}, // 9C RES 3,H
+     {2, 8, 0}, // 9D RES 3,L
+     {2, 16, 0}, // 9E RES 3,(HL)
+     {2, 8, 0}, // 9F RES 3,A
+     {2, 8, 0}, // A0 RES 4,B
+     {2, 8, 0}, // A1 RES 4,C
+     {2, 8, 0}, // A2 RES 4,D
+     {2, 8, 0}, // A3 RES 4,E
+     {2, 8, 0}, // A4 RES 4,H
+     {2, 8, 0}, // A5 RES 4,L
+     {2, 16, 0}, // A6 RES 4,(HL)
+     {2, 8, 0}, // A7 RES 4,A
+     {2, 8, 0}, // A8 RES 5,B
+     {2, 8, 0}, // A9 RES 5,C
+     {2, 8, 0}, // AA RES 5,D
+     {2, 8, 0}, // AB RES 5,E
+     {2, 8, 0}, // AC RES 5,H
+     {2, 8, 0}, // AD RES 5,L
+     {2, 16, 0}, // AE RES 5,(HL)
+     {2, 8, 0}, // AF RES 5,A
+     {2, 8, 0}, // B0 RES 6,B
+     {2, 8, 0}, // B1 RES 6,C
+     {2, 8, 0}, // B2 RES 6,D
+     {2, 8, 0}, // B3 RES 6,E
+     {2, 8, 0}, // B4 RES 6,H
+     {2, 8, 0}, // B5 RES 6,L
+     {2, 16, 0}, // B6 RES 6,(HL)
+     {2, 8, 0}, // B7 RES 6,A
+     {2, 8, 0}, // B8 RES 7,B
+     {2, 8, 0}, // B9 RES 7,C
+     {2, 8, 0}, // BA RES 7,D
+     {2, 8, 0}, // BB RES 7,E
+     {2, 8, 0}, // BC RES 7,H
+     {2, 8, 0}, // BD RES 7,L
+     {2, 16, 0}, // BE RES 7,(HL)
+     {2, 8, 0}, // BF RES 7,A
+     {2, 8, 0}, // C0 SET 0,B
+     {2, 8, 0}, // C1 SET 0,C
+     {2, 8, 0}, // C2 SET 0,D
+     {2, 8, 0}, // C3 SET 0,E
+     {2, 8, 0}, // C4 SET 0,H
+     {2, 8, 0}, // C5 SET 0,L
+     {2, 16, 0}, // C6 SET 0,(HL)
+     {2, 8, 0}, // C7 SET 0,A
+     {2, 8, 0}, // C8 SET 1,B
+     {2, 8, 0}, // C9 SET 1,C
+     {2, 8, 0}, // CA SET 1,D
+     {2, 8, 0}, // CB SET 1,E
+     {2, 8, 0}, // CC SET 1,H
+     {2, 8, 0}, // CD SET 1,L
+     {2, 16, 0}, // CE SET 1,(HL)
+     {2, 8, 0}, // CF SET 1,A
+     {2, 8, 0}, // D0 SET 2,B
+     {2, 8, 0}, // D1 SET 2,C
+     {2, 8, 0}, // D2 SET 2,D
+     {2, 8, 0}, // D3 SET 2,E
+     {2, 8, 0}, // D4 SET 2,H
+     {2, 8, 0}, // D5 SET 2,L
+     {2, 16, 0}, // D6 SET 2,(HL)
+     {2, 8, 0}, // D7 SET 2,A
+     {2, 8, 0}, // D8 SET 3,B
+     {2, 8, 0}, // D9 SET 3,C
+     {2, 8, 0}, // DA SET 3,D
+     {2, 8, 0}, // DB SET 3,E
+     {2, 8, 0}, // DC SET 3,H
+     {2, 8, 0}, // DD SET 3,L
+     {2, 16, 0}, // DE SET 3,(HL)
+     {2, 8, 0}, // DF SET 3,A
+     {2, 8, 0}, // E0 SET 4,B
+     {2, 8, 0}, // E1 SET 4,C
+     {2, 8, 0}, // E2 SET 4,D
+     {2, 8, 0}, // E3 SET 4,E
+     {2, 8, 0}, // E4 SET 4,H
+     {2, 8, 0}, // E5 SET 4,L
+     {2, 16, 0}, // E6 SET 4,(HL)
+     {2, 8, 0}, // E7 SET 4,A
+     {2, 8, 0}, // E8 SET 5,B
+     {2, 8, 0}, // E9 SET 5,C
+     {2, 8, 0}, // EA SET 5,D
+     {2, 8, 0}, // EB SET 5,E
+     {2, 8, 0}, // EC SET 5,H
+     {2, 8, 0}, // ED SET 5,L
+     {2, 16, 0}, // EE SET 5,(HL)
+     {2, 8, 0}, // EF SET 5,A
+     {2, 8, 0}, // F0 SET 6,B
+     {2, 8, 0}, // F1 SET 6,C
+     {2, 8, 0}, // F2 SET 6,D
+     {2, 8, 0}, // F3 SET 6,E
+     {2, 8, 0}, // F4 SET 6,H
+     {2, 8, 0}, // F5 SET 6,L
+     {2, 16, 0}, // F6 SET 6,(HL)
+     {2, 8, 0}, // F7 SET 6,A
+     {2, 8, 0}, // F8 SET 7,B
+     {2, 8, 0}, // F9 SET 7,C
+     {2, 8, 0}, // FA SET 7,D
+     {2, 8, 0}, // FB SET 7,E
+     {2, 8, 0}, // FC SET 7,H
+     {2, 8, 0}, // FD SET 7,L
+     {2, 16, 0}, // FE SET 7,(HL)
+     {2, 8, 0}}}; // FF SET 7,A
+} // namespace opcodes
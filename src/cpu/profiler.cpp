@@ -0,0 +1,168 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mnemonics.hpp"
+
+namespace
+{
+
+struct Row
+{
+  bool extended;
+  std::uint8_t opcode;
+  const Profiler::OpcodeStats* stats;
+};
+
+std::string OpcodeName(bool extended, std::uint8_t opcode)
+{
+  std::ostringstream name;
+  name << std::hex << std::uppercase << std::setfill('0') << (extended ? "CB " : "") << std::setw(2)
+       << static_cast<int>(opcode);
+  return name.str();
+}
+
+std::string CycleHistogram(const Profiler::OpcodeStats& stats)
+{
+  std::string histogram;
+  for (std::size_t bucket = 0; bucket < stats.cycles.size(); ++bucket)
+  {
+    if (stats.cycles[bucket] != 0)
+    {
+      histogram += (histogram.empty() ? "" : " ") + std::to_string(bucket * 4) + ":" +
+                   std::to_string(stats.cycles[bucket]);
+    }
+  }
+  return histogram;
+}
+
+} // namespace
+
+/**
+ * @brief Average of the samples scaled up to every execution, 0 if the opcode was never sampled.
+ */
+double Profiler::OpcodeStats::EstimatedNanoseconds() const
+{
+  return (samples == 0) ? 0.0 : static_cast<double>(sampledNanoseconds) / samples * count;
+}
+
+Profiler::Profiler()
+{
+  constexpr int calibrationRounds = 1000;
+
+  std::uint64_t start = Now();
+  for (int i = 0; i < calibrationRounds; ++i)
+  {
+    Now();
+  }
+  clockOverhead = (Now() - start) / (calibrationRounds + 1);
+}
+
+void Profiler::Reset()
+{
+  stats = {};
+  sampleCounter = 0;
+}
+
+std::uint64_t Profiler::Now()
+{
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+/**
+ * @brief Writes the opcodes that took the most host time, with counts, branch outcomes and cycle histograms.
+ */
+void Profiler::WriteReport(std::ostream& stream, std::size_t rows) const
+{
+  std::vector<Row> executed;
+  std::uint64_t totalCount = 0;
+  double totalNanoseconds = 0.0;
+
+  for (bool extended : {false, true})
+  {
+    for (int opcode = 0; opcode < 256; ++opcode)
+    {
+      const OpcodeStats& entry = stats[extended][opcode];
+      if (entry.count != 0)
+      {
+        executed.push_back({extended, static_cast<std::uint8_t>(opcode), &entry});
+        totalCount += entry.count;
+        totalNanoseconds += entry.EstimatedNanoseconds();
+      }
+    }
+  }
+
+  std::sort(executed.begin(), executed.end(), [](const Row& lhs, const Row& rhs)
+            { return lhs.stats->EstimatedNanoseconds() > rhs.stats->EstimatedNanoseconds(); });
+
+  stream << totalCount << " instructions, about " << std::fixed << std::setprecision(1) << totalNanoseconds / 1e6
+         << " ms in handlers, 1 in " << sampleInterval << " timed.\n\n";
+  stream << std::left << std::setw(7) << "opcode" << std::setw(14) << "mnemonic" << std::right << std::setw(14)
+         << "count" << std::setw(8) << "count%" << std::setw(8) << "time%" << std::setw(8) << "ns" << std::setw(12)
+         << "taken" << std::setw(12) << "not taken" << "  cycles\n";
+
+  for (std::size_t i = 0; i < std::min(rows, executed.size()); ++i)
+  {
+    const Row& row = executed[i];
+    const OpcodeStats& entry = *row.stats;
+    const char* mnemonic = row.extended ? opcodes::extendedMnemonics[row.opcode] : opcodes::mnemonics[row.opcode];
+    double nanoseconds = (entry.samples == 0) ? 0.0 : static_cast<double>(entry.sampledNanoseconds) / entry.samples;
+
+    stream << std::left << std::setw(7) << OpcodeName(row.extended, row.opcode) << std::setw(14) << mnemonic
+           << std::right << std::setw(14) << entry.count << std::setw(8) << std::setprecision(2)
+           << 100.0 * entry.count / totalCount << std::setw(8)
+           << ((totalNanoseconds > 0.0) ? 100.0 * entry.EstimatedNanoseconds() / totalNanoseconds : 0.0)
+           << std::setw(8) << std::setprecision(1) << nanoseconds;
+
+    if (entry.taken + entry.notTaken != 0)
+    {
+      stream << std::setw(12) << entry.taken << std::setw(12) << entry.notTaken;
+    }
+    else
+    {
+      stream << std::setw(24) << "";
+    }
+    stream << "  " << CycleHistogram(entry) << "\n";
+  }
+}
+
+/**
+ * @brief Writes one line per executed opcode with all counters, for spreadsheets and scripts.
+ */
+void Profiler::WriteCSV(std::ostream& stream) const
+{
+  stream << "table,opcode,mnemonic,count,taken,not_taken,samples,sampled_ns,estimated_ns";
+  for (std::size_t bucket = 0; bucket < stats[0][0].cycles.size(); ++bucket)
+  {
+    stream << ",cycles_" << bucket * 4;
+  }
+  stream << "\n";
+
+  for (bool extended : {false, true})
+  {
+    for (int opcode = 0; opcode < 256; ++opcode)
+    {
+      const OpcodeStats& entry = stats[extended][opcode];
+      if (entry.count == 0)
+      {
+        continue;
+      }
+
+      const char* mnemonic = extended ? opcodes::extendedMnemonics[opcode] : opcodes::mnemonics[opcode];
+      stream << (extended ? "cb" : "main") << "," << opcode << ",\"" << mnemonic << "\"," << entry.count << ","
+             << entry.taken << "," << entry.notTaken << "," << entry.samples << "," << entry.sampledNanoseconds << ","
+             << static_cast<std::uint64_t>(entry.EstimatedNanoseconds());
+      for (std::uint64_t bucket : entry.cycles)
+      {
+        stream << "," << bucket;
+      }
+      stream << "\n";
+    }
+  }
+}
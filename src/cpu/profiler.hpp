@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Builds with GBE_PROFILE=1 profile the interpreter, everywhere else the hooks compile away.
+#ifndef GBE_PROFILE
+#define GBE_PROFILE 0
+#endif
+
+/**
+ * @brief Execution counts, branch outcomes, cycle histograms and sampled host time per opcode.
+ *
+ * Every instruction is counted but only every sampleInterval-th one is timed, reading the clock costs more than most
+ * handlers do. The clock's own overhead is measured once and taken off every sample.
+ */
+class Profiler
+{
+public:
+  static constexpr bool compiledIn = GBE_PROFILE;
+  static constexpr std::uint32_t sampleInterval = 64;
+
+  struct OpcodeStats
+  {
+    std::uint64_t count = 0;
+    std::uint64_t taken = 0;
+    std::uint64_t notTaken = 0;
+    std::uint64_t samples = 0;
+    std::uint64_t sampledNanoseconds = 0;
+    // Executions by T-cycles / 4, conditional instructions spread over two buckets.
+    std::array<std::uint64_t, 7> cycles{};
+
+    [[nodiscard]] double EstimatedNanoseconds() const;
+  };
+
+  Profiler();
+
+  /**
+   * @brief Returns the host time for instructions that get sampled and 0 for all others.
+   */
+  std::uint64_t Begin()
+  {
+    if ((++sampleCounter & (sampleInterval - 1)) != 0)
+    {
+      return 0;
+    }
+    return Now();
+  }
+
+  void End(bool extended, std::uint8_t opcode, int cycles, bool conditional, bool taken, std::uint64_t start)
+  {
+    OpcodeStats& entry = stats[extended][opcode];
+    ++entry.count;
+    ++entry.cycles[cycles / 4];
+
+    if (conditional)
+    {
+      ++(taken ? entry.taken : entry.notTaken);
+    }
+
+    if (start != 0)
+    {
+      std::uint64_t elapsed = Now() - start;
+      ++entry.samples;
+      entry.sampledNanoseconds += (elapsed > clockOverhead) ? elapsed - clockOverhead : 0;
+    }
+  }
+
+  [[nodiscard]] const OpcodeStats& Get(bool extended, std::uint8_t opcode) const { return stats[extended][opcode]; }
+  void Reset();
+
+  void WriteReport(std::ostream& stream, std::size_t rows = 40) const;
+  void WriteCSV(std::ostream& stream) const;
+
+private:
+  std::array<std::array<OpcodeStats, 256>, 2> stats{};
+  std::uint32_t sampleCounter = 0;
+  std::uint64_t clockOverhead = 0;
+
+  static std::uint64_t Now();
+};
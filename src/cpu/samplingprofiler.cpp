@@ -0,0 +1,162 @@
+#include "samplingprofiler.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+
+SamplingProfiler::SamplingProfiler(std::uint64_t interval, Symbols symbols)
+    : interval(interval), symbols(std::move(symbols))
+{
+}
+
+void SamplingProfiler::OnCall(std::uint16_t bank, std::uint16_t target, std::uint16_t stackPointer)
+{
+  if (stack.size() == maxDepth)
+  {
+    ++overflow;
+    return;
+  }
+  stack.push_back({(Routine{bank} << 16) | target, stackPointer});
+}
+
+/**
+ * @brief Drops the frames whose return address slot lies below the stack pointer after the pop.
+ */
+void SamplingProfiler::OnReturn(std::uint16_t stackPointer)
+{
+  if (overflow > 0)
+  {
+    --overflow;
+    return;
+  }
+
+  while (!stack.empty() && stack.back().stackPointer < stackPointer)
+  {
+    stack.pop_back();
+  }
+}
+
+/**
+ * @brief Charges cycles to the current call stack, ending in the routine PC lies in if symbols say so.
+ *
+ * With symbols every frame is the labelled routine it lies in, so the stack reads like the source.
+ */
+void SamplingProfiler::Sample(std::uint16_t bank, std::uint16_t pc, std::uint64_t cycles)
+{
+  std::vector<Routine> key;
+  key.reserve(stack.size() + 1);
+  for (const Frame& frame : stack)
+  {
+    key.push_back(RoutineAt(static_cast<std::uint16_t>(frame.routine >> 16), frame.routine & 0xFFFF));
+  }
+
+  Routine leaf = RoutineAt(bank, pc);
+  if (!symbols.IsEmpty() && (key.empty() || key.back() != leaf))
+  {
+    key.push_back(leaf);
+  }
+
+  if (key.empty())
+  {
+    key.push_back(root);
+  }
+
+  stacks[key] += cycles;
+  sampledCycles += cycles;
+}
+
+/**
+ * @brief The labelled routine the address lies in, or the address itself without a label before it.
+ */
+SamplingProfiler::Routine SamplingProfiler::RoutineAt(std::uint16_t bank, std::uint16_t address) const
+{
+  if (auto routine = symbols.FindRoutine(bank, address))
+  {
+    return (Routine{routine->bank} << 16) | routine->address;
+  }
+  return (Routine{bank} << 16) | address;
+}
+
+std::string SamplingProfiler::Name(Routine routine) const
+{
+  if (routine == root)
+  {
+    return "(root)";
+  }
+
+  auto bank = static_cast<std::uint16_t>(routine >> 16);
+  auto address = static_cast<Address>(routine & 0xFFFF);
+
+  if (auto symbol = symbols.Find(bank, address))
+  {
+    return *symbol->name;
+  }
+
+  std::ostringstream name;
+  name << std::hex << std::uppercase << std::setfill('0') << std::setw(2) << bank << ":" << std::setw(4) << address;
+  if (auto symbol = symbols.FindRoutine(bank, address))
+  {
+    name << " (" << *symbol->name << "+" << std::dec << address - symbol->address << ")";
+  }
+  return name.str();
+}
+
+/**
+ * @brief Writes the routines with the most inclusive cycles, the ones spent in them and everything they called.
+ */
+void SamplingProfiler::WriteReport(std::ostream& stream, std::size_t rows) const
+{
+  struct Cycles
+  {
+    std::uint64_t exclusive = 0;
+    std::uint64_t inclusive = 0;
+  };
+
+  std::unordered_map<Routine, Cycles> routines;
+  for (const auto& [key, cycles] : stacks)
+  {
+    routines[key.back()].exclusive += cycles;
+
+    // Recursion must not count the same cycles twice.
+    for (Routine routine : std::set<Routine>(key.begin(), key.end()))
+    {
+      routines[routine].inclusive += cycles;
+    }
+  }
+
+  std::vector<std::pair<Routine, Cycles>> sorted(routines.begin(), routines.end());
+  std::sort(sorted.begin(), sorted.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.second.inclusive > rhs.second.inclusive; });
+
+  double total = (sampledCycles == 0) ? 1.0 : static_cast<double>(sampledCycles);
+
+  stream << sampledCycles << " cycles sampled every " << interval << ".\n\n";
+  stream << std::right << std::setw(14) << "inclusive" << std::setw(8) << "%" << std::setw(14) << "exclusive"
+         << std::setw(8) << "%" << "  routine\n";
+  stream << std::fixed << std::setprecision(2);
+
+  for (std::size_t i = 0; i < std::min(rows, sorted.size()); ++i)
+  {
+    const auto& [routine, cycles] = sorted[i];
+    stream << std::setw(14) << cycles.inclusive << std::setw(8) << 100.0 * cycles.inclusive / total << std::setw(14)
+           << cycles.exclusive << std::setw(8) << 100.0 * cycles.exclusive / total << "  " << Name(routine) << "\n";
+  }
+}
+
+/**
+ * @brief Writes one "outer;inner;leaf cycles" line per distinct stack, the input flamegraph.pl and speedscope take.
+ */
+void SamplingProfiler::WriteFolded(std::ostream& stream) const
+{
+  for (const auto& [key, cycles] : stacks)
+  {
+    for (std::size_t i = 0; i < key.size(); ++i)
+    {
+      stream << (i == 0 ? "" : ";") << Name(key[i]);
+    }
+    stream << " " << cycles << "\n";
+  }
+}
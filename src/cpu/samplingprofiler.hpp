@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "../symbols.hpp"
+
+/**
+ * @brief Samples PC and a shadow call stack every interval emulated cycles, for routine and flamegraph reports.
+ *
+ * CALL, RST and interrupt entry push a frame, RET and RETI drop every frame whose return address was at or below
+ * the popped slot. Unwinding by stack pointer keeps the shadow stack in line with routines that discard their
+ * return address or reset SP.
+ *
+ * Without symbols routines are the call targets, named BB:AAAA after bank and address. With symbols every frame and
+ * PC itself map to the global label they lie in.
+ */
+class SamplingProfiler
+{
+public:
+  static constexpr std::size_t maxDepth = 256;
+
+  SamplingProfiler(std::uint64_t interval, Symbols symbols);
+
+  [[nodiscard]] std::uint64_t GetInterval() const { return interval; }
+
+  void OnCall(std::uint16_t bank, std::uint16_t target, std::uint16_t stackPointer);
+  void OnReturn(std::uint16_t stackPointer);
+  void Sample(std::uint16_t bank, std::uint16_t pc, std::uint64_t cycles);
+
+  [[nodiscard]] std::uint64_t GetSampledCycles() const { return sampledCycles; }
+
+  void WriteReport(std::ostream& stream, std::size_t rows = 30) const;
+  void WriteFolded(std::ostream& stream) const;
+
+private:
+  // Bank in the high half, address in the low half.
+  using Routine = std::uint32_t;
+  static constexpr Routine root = 0xFFFFFFFF;
+
+  struct Frame
+  {
+    Routine routine;
+    std::uint16_t stackPointer;
+  };
+
+  std::uint64_t interval;
+  Symbols symbols;
+
+  std::vector<Frame> stack;
+  // Frames beyond maxDepth are only counted, so that their returns do not unwind the frames that are kept.
+  std::size_t overflow = 0;
+
+  std::map<std::vector<Routine>, std::uint64_t> stacks;
+  std::uint64_t sampledCycles = 0;
+
+  [[nodiscard]] Routine RoutineAt(std::uint16_t bank, std::uint16_t address) const;
+  [[nodiscard]] std::string Name(Routine routine) const;
+};
@@ -0,0 +1,99 @@
+#include "trace.hpp"
+
+#include <algorithm>
+
+void Trace::Enable(std::size_t capacity, Filter filter)
+{
+  std::size_t size = 1;
+  while (size < capacity)
+  {
+    size *= 2;
+  }
+
+  records = std::make_unique<TraceRecord[]>(size);
+  mask = size - 1;
+  head.store(0, std::memory_order_relaxed);
+  tail = 0;
+  dropped = 0;
+
+  this->filter = filter;
+  enabled = true;
+}
+
+/**
+ * @brief Appends every record since the last drain to out and returns how many were appended.
+ *
+ * Records the producer overwrote before or while they were copied are left out and counted as dropped.
+ */
+std::size_t Trace::Drain(std::vector<TraceRecord>& out)
+{
+  if (!records)
+  {
+    return 0;
+  }
+
+  const std::uint64_t capacity = mask + 1;
+  std::uint64_t end = head.load(std::memory_order_acquire);
+  std::uint64_t begin = tail;
+
+  if (end - begin > capacity)
+  {
+    dropped += end - begin - capacity;
+    begin = end - capacity;
+  }
+
+  std::size_t offset = out.size();
+  for (std::uint64_t index = begin; index < end; ++index)
+  {
+    out.push_back(records[index & mask]);
+  }
+
+  // Whatever the producer got to in the meantime may have overwritten the oldest copies. It writes slot after before
+  // publishing after + 1, so the record sharing that slot may be half written as well.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  std::uint64_t after = head.load(std::memory_order_relaxed);
+  if (after + 1 - begin > capacity)
+  {
+    std::uint64_t torn = std::min(after + 1 - begin - capacity, end - begin);
+    out.erase(out.begin() + offset, out.begin() + offset + torn);
+    dropped += torn;
+  }
+
+  tail = end;
+  return out.size() - offset;
+}
+
+/**
+ * @brief Drains into a trace file that already has its header, returns the records written.
+ */
+std::size_t Trace::DrainTo(std::ostream& stream)
+{
+  std::vector<TraceRecord> drained;
+  Drain(drained);
+  stream.write(reinterpret_cast<const char*>(drained.data()), drained.size() * sizeof(TraceRecord));
+  return drained.size();
+}
+
+void Trace::WriteHeader(std::ostream& stream)
+{
+  std::uint32_t recordSize = sizeof(TraceRecord);
+  stream.write(fileMagic.data(), fileMagic.size());
+  stream.write(reinterpret_cast<const char*>(&fileVersion), sizeof(fileVersion));
+  stream.write(reinterpret_cast<const char*>(&recordSize), sizeof(recordSize));
+}
+
+/**
+ * @brief Reads and checks the header of a trace file, the records follow right after it.
+ */
+bool Trace::ReadHeader(std::istream& stream)
+{
+  std::array<char, 8> magic{};
+  std::uint32_t version = 0;
+  std::uint32_t recordSize = 0;
+
+  stream.read(magic.data(), magic.size());
+  stream.read(reinterpret_cast<char*>(&version), sizeof(version));
+  stream.read(reinterpret_cast<char*>(&recordSize), sizeof(recordSize));
+
+  return stream && magic == fileMagic && version == fileVersion && recordSize == sizeof(TraceRecord);
+}
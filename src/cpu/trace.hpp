@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+// Builds with GBE_TRACE=1 record the trace, everywhere else the recording compiles away.
+#ifndef GBE_TRACE
+#define GBE_TRACE 0
+#endif
+
+/**
+ * @brief CPU state right before an instruction executes, what a gameboy-doctor log line holds plus a cycle stamp.
+ */
+struct TraceRecord
+{
+  std::uint64_t cycle;
+  std::uint8_t A, F, B, C, D, E, H, L;
+  std::uint16_t SP;
+  std::uint16_t PC;
+  std::array<std::uint8_t, 4> pcMemory;
+  std::uint16_t bank;
+  std::array<std::uint8_t, 6> reserved;
+};
+
+static_assert(sizeof(TraceRecord) == 32, "Trace files store records as they are laid out in memory.");
+
+/**
+ * @brief Which instructions get traced, by address range and the bank mapped there.
+ */
+struct TraceFilter
+{
+  static constexpr int anyBank = -1;
+
+  std::uint16_t first = 0x0000;
+  std::uint16_t last = 0xFFFF;
+  int bank = anyBank;
+
+  [[nodiscard]] bool Contains(std::uint16_t address) const { return address >= first && address <= last; }
+};
+
+/**
+ * @brief Fixed size ring buffer of trace records that keeps the latest ones.
+ *
+ * One thread records, another one may drain at the same time. Recording never waits, it overwrites the oldest
+ * records once the buffer is full and Drain counts them as dropped.
+ *
+ * Trace files are a header followed by raw records in host byte order.
+ */
+class Trace
+{
+public:
+  static constexpr bool compiledIn = GBE_TRACE;
+  static constexpr int anyBank = TraceFilter::anyBank;
+
+  using Filter = TraceFilter;
+
+  /**
+   * @brief Starts recording into a buffer of at least capacity records, not allowed while recording.
+   */
+  void Enable(std::size_t capacity, Filter filter = {});
+  void Disable() { enabled = false; }
+  [[nodiscard]] bool IsEnabled() const { return enabled; }
+  [[nodiscard]] const Filter& GetFilter() const { return filter; }
+
+  void Record(const TraceRecord& record)
+  {
+    std::uint64_t index = head.load(std::memory_order_relaxed);
+    records[index & mask] = record;
+    head.store(index + 1, std::memory_order_release);
+  }
+
+  std::size_t Drain(std::vector<TraceRecord>& out);
+  std::size_t DrainTo(std::ostream& stream);
+  [[nodiscard]] std::uint64_t GetDropped() const { return dropped; }
+
+  static void WriteHeader(std::ostream& stream);
+  static bool ReadHeader(std::istream& stream);
+
+private:
+  static constexpr std::array<char, 8> fileMagic{'G', 'B', 'E', 'T', 'R', 'A', 'C', 'E'};
+  static constexpr std::uint32_t fileVersion = 1;
+
+  bool enabled = false;
+  Filter filter;
+
+  std::unique_ptr<TraceRecord[]> records;
+  std::uint64_t mask = 0;
+
+  std::atomic<std::uint64_t> head{0};
+  std::uint64_t tail = 0;
+  std::uint64_t dropped = 0;
+};
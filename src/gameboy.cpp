@@ -1,11 +1,17 @@
 #include "gameboy.hpp"
 
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
 #include <plog/Log.h>
 
 #include "cpu/cpu.hpp"
 #include "controls.hpp"
 #include "mmu.hpp"
 #include "ppu.hpp"
+#include "serial.hpp"
+#include "symbols.hpp"
 
 std::unique_ptr<GameBoy> GameBoy::Create()
 {
@@ -14,20 +20,59 @@ std::unique_ptr<GameBoy> GameBoy::Create()
 }
 
 GameBoy::GameBoy(std::unique_ptr<MMU> mmu, std::unique_ptr<CPU> cpu, std::unique_ptr<Controls> controls)
-    : mmu(std::move(mmu)), cpu(std::move(cpu)), controls(std::move(controls))
+    : mmu(std::move(mmu)), cpu(std::move(cpu)), controls(std::move(controls)),
+      serial(std::make_unique<Serial>(*this->mmu, *this->cpu))
 {
+  // Test ROMs report their results over the serial port.
+  serial->SetSink([](std::uint8_t byte) { std::cout << static_cast<char>(byte) << std::flush; });
 }
 GameBoy::~GameBoy()
 {
   TurnOff();
+
+  // Profiling builds report where the interpreter spent its time.
+  if (Profiler* profiler = cpu->GetProfiler())
+  {
+    profiler->WriteReport(std::cerr);
+    std::ofstream csv{"profile.csv"};
+    profiler->WriteCSV(csv);
+    PLOG(plog::info) << "Wrote opcode profile to profile.csv.";
+  }
+
+  if (SamplingProfiler* sampler = cpu->GetSampler())
+  {
+    sampler->WriteReport(std::cerr);
+    std::ofstream folded{"samples.folded"};
+    sampler->WriteFolded(folded);
+    PLOG(plog::info) << "Wrote folded stacks to samples.folded.";
+  }
 }
 
+/**
+ * @brief Loads the ROM, cartridge RAM stays private to this instance until AttachSave.
+ */
 void GameBoy::LoadROM(const std::string& path)
 {
   mmu->LoadROM(path);
+  romPath = path;
   PLOG(plog::info) << "Loaded ROM.";
 }
 
+/**
+ * @brief Keeps battery powered RAM in the save file from now on, returns false for cartridges without one.
+ *
+ * Instances attaching the same file share one RAM, so batch runs of a ROM should leave their RAM private.
+ */
+bool GameBoy::AttachSave(const std::string& savePath)
+{
+  if (!mmu->LoadSave(savePath))
+  {
+    return false;
+  }
+  PLOG(plog::info) << "Saving to " << savePath << ".";
+  return true;
+}
+
 void GameBoy::HandleInputs()
 {
   controls->Update();
@@ -54,8 +99,11 @@ void GameBoy::TurnOn()
   {
     // HandleInputs();
 
-    cpu->Tick();
-    if (cpu->IsHalted())
+    RunFrame();
+    DrainTrace();
+
+    // A halted CPU without any scheduled event has nothing left that could wake it.
+    if (cpu->IsHalted() && cpu->GetScheduler().NextCycle() == Scheduler::never)
     {
       TurnOff();
     }
@@ -64,6 +112,64 @@ void GameBoy::TurnOn()
   }
 }
 
+/**
+ * @brief Runs at least cycles T-cycles without blocking and returns the exact number executed.
+ */
+std::uint64_t GameBoy::RunCycles(std::uint64_t cycles)
+{
+  return cpu->RunCycles(cycles);
+}
+
+/**
+ * @brief Runs up to where the next VBlank starts and returns the cycles executed.
+ *
+ * Frames end on multiples of cyclesPerFrame, so the overrun of one frame is taken off the next one. Every
+ * saveInterval frames battery RAM is flushed to the save file here, between frames rather than on each write.
+ */
+std::uint64_t GameBoy::RunFrame()
+{
+  std::uint64_t now = cpu->GetCycles();
+  std::uint64_t executed = cpu->RunCycles((now / cyclesPerFrame + 1) * cyclesPerFrame - now);
+
+  if (saveInterval != 0 && ++framesSinceSave >= saveInterval)
+  {
+    mmu->FlushSave();
+    framesSinceSave = 0;
+  }
+
+  return executed;
+}
+
+/**
+ * @brief Whether RunUntil has to give up: the debugger paused, or the CPU is halted and no event is left to wake it.
+ */
+bool GameBoy::IsStopped() const
+{
+  return cpu->IsPaused() || (cpu->IsHalted() && cpu->GetScheduler().NextCycle() == Scheduler::never);
+}
+
+/**
+ * @brief Runs one instruction through the selected dispatch via CPU::Run and returns the T-cycles it took.
+ *
+ * Breakpoints and events behave as in RunCycles. A halted CPU sleeps up to its next event instead.
+ */
+std::uint64_t GameBoy::RunInstruction()
+{
+  std::uint64_t before = cpu->GetCycles();
+  cpu->Run(1);
+  return cpu->GetCycles() - before;
+}
+
+int GameBoy::Step()
+{
+  return cpu->Tick();
+}
+
+std::uint64_t GameBoy::GetCycles() const
+{
+  return cpu->GetCycles();
+}
+
 void GameBoy::TurnOff()
 {
   if (turnedOn)
@@ -71,4 +177,59 @@ void GameBoy::TurnOff()
     PLOG(plog::info) << "Turning off GameBoy.";
     turnedOn = false;
   }
+
+  mmu->FlushSave();
+  DrainTrace();
+}
+
+/**
+ * @brief Records every instruction the filter matches into a binary trace file, see gbe-trace-dump.
+ */
+void GameBoy::StartTrace(const std::string& path, Trace::Filter filter)
+{
+  if (!Trace::compiledIn)
+  {
+    throw std::runtime_error{"Tracing needs a build with GBE_TRACE enabled."};
+  }
+
+  traceFile.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!traceFile)
+  {
+    throw std::runtime_error{"Unable to open trace file."};
+  }
+
+  Trace::WriteHeader(traceFile);
+  cpu->GetTrace().Enable(traceCapacity, filter);
+  PLOG(plog::info) << "Tracing to " << path << ".";
+}
+
+/**
+ * @brief Profiles the emulated code every interval cycles, naming routines after the ROM's .sym file if it has one.
+ */
+void GameBoy::StartSampling(std::uint64_t interval)
+{
+  Symbols symbols;
+  std::string symbolPath = Symbols::PathForROM(romPath);
+  if (std::filesystem::exists(symbolPath))
+  {
+    symbols = Symbols::Load(symbolPath);
+    PLOG(plog::info) << "Loaded symbols from " << symbolPath << ".";
+  }
+
+  cpu->StartSampling(interval, std::move(symbols));
+}
+
+void GameBoy::DrainTrace()
+{
+  if (!traceFile.is_open())
+  {
+    return;
+  }
+
+  Trace& trace = cpu->GetTrace();
+  trace.DrainTo(traceFile);
+  if (trace.GetDropped() > 0)
+  {
+    PLOG(plog::warning) << "Trace dropped " << trace.GetDropped() << " records.";
+  }
 }
\ No newline at end of file
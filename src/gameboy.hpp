@@ -1,34 +1,103 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <limits>
 #include <string>
 #include <memory>
 
+#include "cpu/trace.hpp"
+
 class CPU;
 class MMU;
 class PPU;
 class Controls;
+class Serial;
 
 class GameBoy
 {
   static constexpr int displayWidth = 160;
   static constexpr int displayHeight = 144;
+  static constexpr std::uint64_t cyclesPerFrame = 70224;
+  static constexpr std::uint64_t cyclesPerLine = 456;
+  static constexpr std::size_t traceCapacity = 1 << 16;
 
   std::unique_ptr<MMU> mmu;
   std::unique_ptr<CPU> cpu;
   // std::unique_ptr<PPU> ppu;
   std::unique_ptr<Controls> controls;
+  std::unique_ptr<Serial> serial;
 
   bool turnedOn = false;
 
+  std::string romPath;
+  std::ofstream traceFile;
+
+  // Battery RAM is flushed to the save file every saveInterval frames, 0 only flushes on turning off.
+  std::uint64_t saveInterval = defaultSaveInterval;
+  std::uint64_t framesSinceSave = 0;
+
   void HandleInputs();
+  void DrainTrace();
+  bool IsStopped() const;
+  std::uint64_t RunInstruction();
 
 public:
+  // About a second of emulated time.
+  static constexpr std::uint64_t defaultSaveInterval = 60;
+
   GameBoy(std::unique_ptr<MMU> mmu, std::unique_ptr<CPU> cpu, std::unique_ptr<Controls> controls);
   ~GameBoy();
 
   static std::unique_ptr<GameBoy> Create();
 
   void LoadROM(const std::string& path);
+  bool AttachSave(const std::string& savePath);
   void TurnOn();
   void TurnOff();
+
+  void StartTrace(const std::string& path, Trace::Filter filter = {});
+  void StartSampling(std::uint64_t interval);
+  void SetSaveInterval(std::uint64_t frames) { saveInterval = frames; }
+
+  std::uint64_t RunCycles(std::uint64_t cycles);
+  std::uint64_t RunFrame();
+
+  /**
+   * @brief Runs RunCycles batches of checkInterval T-cycles until predicate(*this) holds or maxCycles have passed.
+   *
+   * Batches go through the selected dispatch and stop at breakpoints like RunCycles does, the predicate is only
+   * checked between them, so it may hold up to a batch before RunUntil notices. A checkInterval of 0 is the exact
+   * mode: the predicate is checked after every instruction, or every sleep of a halted CPU, at the cost of entering
+   * the dispatch once per instruction. Also stops on a debugger pause and when the CPU is halted with nothing left
+   * that could wake it. Returns the T-cycles executed.
+   */
+  template <typename Predicate>
+  std::uint64_t RunUntil(Predicate predicate, std::uint64_t maxCycles = std::numeric_limits<std::uint64_t>::max(),
+                         std::uint64_t checkInterval = cyclesPerLine)
+  {
+    std::uint64_t executed = 0;
+    while (executed < maxCycles && !predicate(*this))
+    {
+      executed += checkInterval == 0 ? RunInstruction() : RunCycles(std::min(checkInterval, maxCycles - executed));
+      if (IsStopped())
+      {
+        break;
+      }
+    }
+    return executed;
+  }
+
+  /**
+   * @brief Executes a single instruction or wakes from HALT through table dispatch, ignoring breakpoints.
+   *
+   * The slow path for stepping in a debugger, returns 0 if the CPU is halted for good.
+   */
+  int Step();
+
+  std::uint64_t GetCycles() const;
+  CPU& GetCPU() { return *cpu; }
+  MMU& GetMMU() { return *mmu; }
+  Serial& GetSerial() { return *serial; }
 };
\ No newline at end of file
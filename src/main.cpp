@@ -1,11 +1,47 @@
+#include <cstdint>
+#include <string>
+
+#include "cartridge.hpp"
 #include "logger.hpp"
 #include "gameboy.hpp"
 
 int main(int argc, char** argv)
 {
-  if (argc != 2)
+  std::string romPath;
+  std::string tracePath;
+  std::uint64_t sampleInterval = 0;
+  std::uint64_t saveInterval = GameBoy::defaultSaveInterval;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string argument = argv[i];
+
+    if (argument == "--trace" && i + 1 < argc)
+    {
+      tracePath = argv[++i];
+    }
+    else if (argument == "--sample" && i + 1 < argc)
+    {
+      sampleInterval = std::stoull(argv[++i]);
+    }
+    else if (argument == "--save-interval" && i + 1 < argc)
+    {
+      saveInterval = std::stoull(argv[++i]);
+    }
+    else if (romPath.empty())
+    {
+      romPath = argument;
+    }
+    else
+    {
+      romPath.clear();
+      break;
+    }
+  }
+
+  if (romPath.empty())
   {
-    std::cerr << "Usage: GBE PathToRom." << std::endl;
+    std::cerr << "Usage: GBE [--trace PathToTrace] [--sample Cycles] [--save-interval Frames] PathToRom." << std::endl;
     std::exit(EXIT_FAILURE);
   }
 
@@ -13,7 +49,17 @@ int main(int argc, char** argv)
   PLOG(plog::info) << "Starting application.";
 
   auto gameBoy = GameBoy::Create();
-  gameBoy->LoadROM(argv[1]);
+  gameBoy->LoadROM(romPath);
+  gameBoy->AttachSave(Cartridge::SavePathForROM(romPath));
+  gameBoy->SetSaveInterval(saveInterval);
+  if (!tracePath.empty())
+  {
+    gameBoy->StartTrace(tracePath);
+  }
+  if (sampleInterval != 0)
+  {
+    gameBoy->StartSampling(sampleInterval);
+  }
   gameBoy->TurnOn();
 
   PLOG(plog::info) << "Finished application.";
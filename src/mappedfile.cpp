@@ -0,0 +1,189 @@
+#include "mappedfile.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Maps the file, an empty read-only file maps to no data.
+ */
+MappedFile::MappedFile(const std::string& filePath, Mode mode, std::size_t size, std::uint8_t fill)
+    : writable(mode == Mode::ReadWrite)
+{
+  std::size_t fileSize = 0;
+
+#if defined(_WIN32)
+  HANDLE handle = CreateFileA(filePath.c_str(), writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+                              FILE_SHARE_READ, nullptr, writable ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+  if (handle == INVALID_HANDLE_VALUE)
+  {
+    throw std::runtime_error{"Unable to open " + filePath + "."};
+  }
+
+  LARGE_INTEGER length{};
+  if (!GetFileSizeEx(handle, &length))
+  {
+    CloseHandle(handle);
+    throw std::runtime_error{"Unable to read " + filePath + "."};
+  }
+  fileSize = static_cast<std::size_t>(length.QuadPart);
+  this->size = writable ? size : fileSize;
+
+  if (this->size != 0)
+  {
+    // A read-write mapping of the requested size extends the file. The view keeps the mapping open on its own.
+    auto mappingSize = static_cast<std::uint64_t>(writable ? std::max(fileSize, size) : 0);
+    HANDLE mapping = CreateFileMappingA(handle, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                        static_cast<DWORD>(mappingSize >> 32), static_cast<DWORD>(mappingSize),
+                                        nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, this->size)
+                         : nullptr;
+    if (mapping)
+    {
+      CloseHandle(mapping);
+    }
+    if (!view)
+    {
+      CloseHandle(handle);
+      throw std::runtime_error{"Unable to map " + filePath + "."};
+    }
+    data = static_cast<std::uint8_t*>(view);
+  }
+
+  if (writable)
+  {
+    file = handle;
+  }
+  else
+  {
+    CloseHandle(handle);
+  }
+#else
+  int file = open(filePath.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+  if (file < 0)
+  {
+    throw std::runtime_error{"Unable to open " + filePath + "."};
+  }
+
+  struct stat status{};
+  if (fstat(file, &status) != 0)
+  {
+    close(file);
+    throw std::runtime_error{"Unable to read " + filePath + "."};
+  }
+  fileSize = static_cast<std::size_t>(status.st_size);
+  this->size = writable ? size : fileSize;
+
+  if (writable && fileSize < size && ftruncate(file, static_cast<off_t>(size)) != 0)
+  {
+    close(file);
+    throw std::runtime_error{"Unable to resize " + filePath + "."};
+  }
+
+  if (this->size != 0)
+  {
+    void* memory = mmap(nullptr, this->size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                        writable ? MAP_SHARED : MAP_PRIVATE, file, 0);
+    if (memory == MAP_FAILED)
+    {
+      close(file);
+      throw std::runtime_error{"Unable to map " + filePath + "."};
+    }
+    if (!writable)
+    {
+      // Emulated code jumps between banks rather than streaming through the file, read ahead would only waste memory.
+      madvise(memory, this->size, MADV_RANDOM);
+    }
+    data = static_cast<std::uint8_t*>(memory);
+  }
+  // The mapping stays valid without the descriptor.
+  close(file);
+#endif
+
+  if (writable && fileSize < this->size)
+  {
+    std::fill(data + fileSize, data + this->size, fill);
+  }
+}
+
+MappedFile::~MappedFile()
+{
+  Unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data(std::exchange(other.data, nullptr)), size(std::exchange(other.size, 0)),
+      writable(std::exchange(other.writable, false))
+#if defined(_WIN32)
+      ,
+      file(std::exchange(other.file, nullptr))
+#endif
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+  if (this != &other)
+  {
+    Unmap();
+    data = std::exchange(other.data, nullptr);
+    size = std::exchange(other.size, 0);
+    writable = std::exchange(other.writable, false);
+#if defined(_WIN32)
+    file = std::exchange(other.file, nullptr);
+#endif
+  }
+  return *this;
+}
+
+void MappedFile::Flush()
+{
+  if (!writable || !data)
+  {
+    return;
+  }
+
+#if defined(_WIN32)
+  FlushViewOfFile(data, size);
+  FlushFileBuffers(file);
+#else
+  msync(data, size, MS_SYNC);
+#endif
+}
+
+/**
+ * @brief Unmaps the file, flushing a read-write mapping first.
+ */
+void MappedFile::Unmap()
+{
+  if (data)
+  {
+    Flush();
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif
+  }
+
+#if defined(_WIN32)
+  if (file)
+  {
+    CloseHandle(file);
+  }
+  file = nullptr;
+#endif
+  data = nullptr;
+  size = 0;
+  writable = false;
+}
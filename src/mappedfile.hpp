@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief A file mapped into memory.
+ *
+ * Read-only mappings are private and never written, so every process mapping the same file shares its physical
+ * pages with the page cache. Nothing is read up front, pages fault in on first access.
+ *
+ * Read-write mappings are shared with the file: writes land in the page cache as plain memory stores and reach the
+ * disk on Flush, when unmapping or whenever the OS writes dirty pages back.
+ */
+class MappedFile
+{
+public:
+  enum class Mode
+  {
+    ReadOnly,
+    ReadWrite
+  };
+
+  MappedFile() = default;
+
+  /**
+   * @brief Maps the whole file read-only, or its first size bytes read-write.
+   *
+   * In read-write mode a missing file is created and a short one extended, the added bytes are filled with fill.
+   */
+  explicit MappedFile(const std::string& filePath, Mode mode = Mode::ReadOnly, std::size_t size = 0,
+                      std::uint8_t fill = 0x00);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  [[nodiscard]] const std::uint8_t* GetData() const { return data; }
+  /**
+   * @brief The mapped bytes to write to, null for read-only mappings.
+   */
+  [[nodiscard]] std::uint8_t* GetWritableData() { return writable ? data : nullptr; }
+  [[nodiscard]] std::size_t GetSize() const { return size; }
+
+  /**
+   * @brief Writes modified pages of a read-write mapping to the file and waits for them.
+   */
+  void Flush();
+
+private:
+  std::uint8_t* data = nullptr;
+  std::size_t size = 0;
+  bool writable = false;
+#if defined(_WIN32)
+  // Kept open to flush file metadata along with the view.
+  void* file = nullptr;
+#endif
+
+  void Unmap();
+};
@@ -1,16 +1,107 @@
 #include "mmu.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 #include <filesystem>
 #include <string>
-#include <fstream>
+
+namespace
+{
+
+// Echo RAM at $E000-$FDFF mirrors work RAM at $C000-$DDFF.
+constexpr int echoFirstPage = 0xE0;
+constexpr int echoLastPage = 0xFD;
+constexpr int echoOffset = 0x20;
+
+/**
+ * @brief The page mirroring the given one, or -1 for pages without a mirror.
+ */
+int MirrorPage(int page)
+{
+  if (page >= echoFirstPage && page <= echoLastPage)
+  {
+    return page - echoOffset;
+  }
+  if (page >= echoFirstPage - echoOffset && page <= echoLastPage - echoOffset)
+  {
+    return page + echoOffset;
+  }
+  return -1;
+}
+
+/**
+ * @brief Bits of the DMG IO registers at $FF00-$FF7F that read as 1 whatever was written, 0xFF where nothing is mapped.
+ *
+ * The low nibble of P1 reads as nothing pressed. HRAM and IE after them are plain memory.
+ */
+constexpr std::array<std::uint8_t, 0x80> dmgUnusedBits = {
+    // P1, SB, SC, DIV, TIMA, TMA, TAC and IF.
+    0xCF, 0x00, 0x7E, 0xFF, 0x00, 0x00, 0x00, 0xF8, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xE0,
+    // Sound channels 1-3.
+    0x80, 0x3F, 0x00, 0xFF, 0xBF, 0xFF, 0x3F, 0x00, 0xFF, 0xBF, 0x7F, 0xFF, 0x9F, 0xFF, 0xBF, 0xFF,
+    // Sound channel 4, NR50, NR51 and NR52.
+    0xFF, 0x00, 0x00, 0xBF, 0x00, 0x00, 0x70, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    // Wave RAM.
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    // LCDC, STAT, SCY, SCX, LY, LYC, DMA, BGP, OBP0, OBP1, WY and WX.
+    0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF,
+    // Color Game Boy registers and the boot ROM switch.
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+// LY until there is a PPU to own it.
+constexpr Address lcdYAddress = 0xFF44;
+constexpr std::uint8_t firstVBlankLine = 0x90;
+
+} // namespace
 
 MMU::MMU()
 {
-  std::fill(memmory.begin(), memmory.end(), 0xFF);
+  videoRAM.fill(0xFF);
+  workRAM.fill(0xFF);
+  objectAttributes.fill(0xFF);
+  highPage.fill(0xFF);
+  unmapped.fill(0xFF);
+
+  for (int page = 0x80; page < 0xA0; ++page)
+  {
+    pages[page] = &videoRAM[(page - 0x80) * pageSize];
+  }
+  for (int page = 0xC0; page < 0xE0; ++page)
+  {
+    pages[page] = &workRAM[(page - 0xC0) * pageSize];
+  }
+  for (int page = echoFirstPage; page <= echoLastPage; ++page)
+  {
+    pages[page] = pages[page - echoOffset];
+  }
+  pages[0xFE] = objectAttributes.data();
+  pages[0xFF] = highPage.data();
+
+  // Get and Set check the registers in the last page one by one.
+  pageFlags[ioPageIndex] = ioPage;
+  std::copy(dmgUnusedBits.begin(), dmgUnusedBits.end(), ioUnusedBits.begin());
+  // Without a PPU, LY stays on the first VBlank line so code waiting for VBlank moves on.
+  SetIOReadHandler(lcdYAddress, [](void*) { return firstVBlankLine; }, nullptr);
+
+  for (int page = 0; page < 2 * romBankPages; ++page)
+  {
+    pageFlags[page] = romPage;
+  }
+
+  MapCartridge();
+  for (int page = 0; page < pageCount; ++page)
+  {
+    UpdatePage(page);
+  }
 }
 
+/**
+ * @brief Maps the ROM file instead of reading it, so loading takes the same time whatever its size.
+ */
 void MMU::LoadROM(const std::string& filePath)
 {
   std::filesystem::path path{filePath};
@@ -19,33 +110,339 @@ void MMU::LoadROM(const std::string& filePath)
     throw std::runtime_error{"ROM file does not exist."};
   }
 
-  std::fstream romFile{path.c_str(), std::ios::in | std::ios::binary | std::ios::ate};
+  cartridge = Cartridge{MappedFile{filePath}};
+  mappedRAMBank = unmapped.data();
+  MapCartridge();
+}
+
+/**
+ * @brief Loads a ROM image built in memory, like the synthetic benchmark ROMs.
+ *
+ * The cartridge header picks the memory bank controller and the size of external RAM.
+ */
+void MMU::LoadROM(const std::vector<std::uint8_t>& image)
+{
+  cartridge = Cartridge{image};
+  mappedRAMBank = unmapped.data();
+  MapCartridge();
+}
+
+/**
+ * @brief Keeps battery powered cartridge RAM in the save file, see Cartridge::LoadSave.
+ */
+bool MMU::LoadSave(const std::string& savePath)
+{
+  if (!cartridge.LoadSave(savePath))
+  {
+    return false;
+  }
+
+  mappedRAMBank = unmapped.data();
+  MapExternalRAM();
+  return true;
+}
+
+/**
+ * @brief Points the ROM and external RAM windows at the banks the cartridge selects.
+ */
+void MMU::MapCartridge()
+{
+  MapROMBank(0, cartridge.GetLowROMBank());
+  MapROMBank(firstHighROMPage, cartridge.GetHighROMBank());
+  MapExternalRAM();
+}
+
+/**
+ * @brief Repoints a 16 KiB ROM window at the bank.
+ *
+ * ROM pages have no mirror and always write through the slow path, so only the read table follows. That also means
+ * nothing ever writes through these pointers, which may point into a read-only mapping.
+ */
+void MMU::MapROMBank(int firstPage, std::uint16_t bank)
+{
+  auto* memory = const_cast<std::uint8_t*>(cartridge.GetROMBank(bank));
+  for (int page = firstPage; page < firstPage + romBankPages; ++page, memory += pageSize)
+  {
+    pages[page] = memory;
+    readPages[page] = (pageFlags[page] & readWatchedPage) ? nullptr : memory;
+  }
+}
+
+/**
+ * @brief Maps enabled plain RAM directly, anything else in $A000-$BFFF is left to the cartridge.
+ *
+ * Nothing changes while the same bank stays selected. These pages have no mirror.
+ */
+void MMU::MapExternalRAM()
+{
+  std::uint8_t* bank = cartridge.GetRAMBank();
+  if (bank == mappedRAMBank)
+  {
+    return;
+  }
+  mappedRAMBank = bank;
+
+  std::size_t bankMask = cartridge.GetRAMBankSize() - 1;
+  for (int page = firstExternalRAMPage; page < firstExternalRAMPage + externalRAMPages; ++page)
+  {
+    if (bank)
+    {
+      // RAM sizes are powers of two, smaller banks repeat.
+      pages[page] = bank + ((static_cast<std::size_t>(page - firstExternalRAMPage) * pageSize) & bankMask);
+      pageFlags[page] = static_cast<std::uint8_t>(pageFlags[page] & ~cartridgeRAMPage);
+    }
+    else
+    {
+      pages[page] = unmapped.data();
+      pageFlags[page] = static_cast<std::uint8_t>(pageFlags[page] | cartridgeRAMPage);
+    }
+
+    std::uint8_t flags = pageFlags[page];
+    readPages[page] = (flags & (readWatchedPage | cartridgeRAMPage)) ? nullptr : pages[page];
+    writePages[page] = (flags & (codePage | writeWatchedPage | cartridgeRAMPage)) ? nullptr : pages[page];
+  }
+}
+
+/**
+ * @brief Derives the page table entries from the host memory and flags of the page.
+ *
+ * Writes to a mirrored page also take the slow path while its mirror holds code.
+ */
+void MMU::UpdatePage(int page)
+{
+  std::uint8_t flags = pageFlags[page];
+  int mirror = MirrorPage(page);
+  bool mirrorHoldsCode = mirror >= 0 && (pageFlags[mirror] & codePage);
+
+  readPages[page] = (flags & (ioPage | readWatchedPage | cartridgeRAMPage)) ? nullptr : pages[page];
+  writePages[page] = ((flags & (ioPage | codePage | writeWatchedPage | romPage | cartridgeRAMPage)) || mirrorHoldsCode)
+                         ? nullptr
+                         : pages[page];
+
+  if (page == ioPageIndex)
+  {
+    UpdateIOPage();
+  }
+}
+
+/**
+ * @brief Derives which IO page addresses Get and Set have to hand to the slow path.
+ */
+void MMU::UpdateIOPage()
+{
+  bool holdsCode = pageFlags[ioPageIndex] & codePage;
+
+  for (int offset = 0; offset < pageSize; ++offset)
+  {
+    Address address = ioFirstAddress + offset;
+    const IOHandlers* handlers = ioHandlerIndex[offset] ? &ioHandlers[ioHandlerIndex[offset] - 1] : nullptr;
+
+    ioReadSlow[offset] = (handlers && handlers->read) || IsReadWatched(address);
+    ioWriteSlow[offset] = (handlers && handlers->write) || IsWriteWatched(address) || holdsCode;
+  }
+}
+
+MMU::IOHandlers& MMU::GetIOHandlers(Address address)
+{
+  std::uint8_t& index = ioHandlerIndex[address & 0xFF];
+  if (index == 0)
+  {
+    ioHandlers.emplace_back();
+    index = static_cast<std::uint8_t>(ioHandlers.size());
+  }
+  return ioHandlers[index - 1];
+}
+
+void MMU::SetIOReadHandler(Address address, IOReadHandler handler, void* context)
+{
+  IOHandlers& handlers = GetIOHandlers(address);
+  handlers.read = handler;
+  handlers.readContext = context;
+  UpdateIOPage();
+}
+
+void MMU::SetIOWriteHandler(Address address, IOWriteHandler handler, void* context)
+{
+  IOHandlers& handlers = GetIOHandlers(address);
+  handlers.write = handler;
+  handlers.writeContext = context;
+  UpdateIOPage();
+}
+
+void MMU::SetPageFlag(int page, PageFlags flag, bool set)
+{
+  pageFlags[page] = static_cast<std::uint8_t>(set ? (pageFlags[page] | flag) : (pageFlags[page] & ~flag));
+  UpdatePage(page);
+
+  if (int mirror = MirrorPage(page); mirror >= 0)
+  {
+    UpdatePage(mirror);
+  }
+}
+
+/**
+ * @brief Writes to a page the table does not map directly and reports the write to whoever hooked into it.
+ *
+ * Writes to ROM go to the memory bank controller instead, a bank switch only repoints the pages of the windows whose
+ * bank changed. ROM itself never changes, so cached code in it stays valid.
+ */
+void MMU::SetSlow(Address address, std::uint8_t value)
+{
+  int page = address >> 8;
+  std::uint8_t flags = pageFlags[page];
+
+  if (flags & romPage)
+  {
+    std::uint16_t lowBank = cartridge.GetLowROMBank();
+    std::uint16_t highBank = cartridge.GetHighROMBank();
+
+    if (cartridge.Control(address, value))
+    {
+      ++bankSwitches;
+      if (cartridge.GetLowROMBank() != lowBank)
+      {
+        MapROMBank(0, cartridge.GetLowROMBank());
+      }
+      if (cartridge.GetHighROMBank() != highBank)
+      {
+        MapROMBank(firstHighROMPage, cartridge.GetHighROMBank());
+      }
+      MapExternalRAM();
+    }
+  }
+  else if (flags & cartridgeRAMPage)
+  {
+    cartridge.WriteRAM(address, value);
+  }
+  else
+  {
+    pages[page][address & 0xFF] = value;
+  }
+
+  if (codeWriteHandler && !(flags & romPage))
+  {
+    if (flags & codePage)
+    {
+      codeWriteHandler(address);
+    }
+    if (int mirror = MirrorPage(page); mirror >= 0 && (pageFlags[mirror] & codePage))
+    {
+      codeWriteHandler(static_cast<Address>((mirror << 8) | (address & 0xFF)));
+    }
+  }
+
+  if (page == ioPageIndex)
+  {
+    if (std::uint8_t index = ioHandlerIndex[address & 0xFF]; index != 0 && ioHandlers[index - 1].write)
+    {
+      const IOHandlers& handlers = ioHandlers[index - 1];
+      handlers.write(handlers.writeContext, value);
+    }
+  }
+
+  if ((flags & writeWatchedPage) && IsWriteWatched(address) && watchHandler)
+  {
+    watchHandler(address, value, true);
+  }
+}
+
+std::uint8_t MMU::PeekSlow(Address address) const
+{
+  if (address >= ioFirstAddress)
+  {
+    std::uint8_t offset = address & 0xFF;
+    if (std::uint8_t index = ioHandlerIndex[offset]; index != 0 && ioHandlers[index - 1].read)
+    {
+      const IOHandlers& handlers = ioHandlers[index - 1];
+      return handlers.read(handlers.readContext);
+    }
+    return highPage[offset] | ioUnusedBits[offset];
+  }
+  if (pageFlags[address >> 8] & cartridgeRAMPage)
+  {
+    return cartridge.ReadRAM(address);
+  }
+  return pages[address >> 8][address & 0xFF];
+}
+
+std::uint8_t MMU::GetSlow(Address address)
+{
+  std::uint8_t value = Peek(address);
+
+  if (IsReadWatched(address) && watchHandler)
+  {
+    watchHandler(address, value, false);
+  }
+
+  return value;
+}
 
-  if (!romFile)
+void MMU::AddWatchpoint(Address address, Access access)
+{
+  if (!watchpoints)
   {
-    throw std::runtime_error{"Unable to open ROM."};
+    watchpoints = std::make_unique<Watchpoints>();
   }
 
-  std::streamsize fileSize = romFile.tellg();
-  romFile.seekg(0, std::iostream::beg);
+  if (static_cast<std::uint8_t>(access) & static_cast<std::uint8_t>(Access::Read))
+  {
+    watchpoints->read.set(address);
+  }
+  if (static_cast<std::uint8_t>(access) & static_cast<std::uint8_t>(Access::Write))
+  {
+    watchpoints->write.set(address);
+  }
+  UpdateWatchedPage(address >> 8);
+  watchpointCount = watchpoints->read.count() + watchpoints->write.count();
+}
 
-  if (!romFile.read(reinterpret_cast<char*>(memmory.data()), fileSize))
+void MMU::RemoveWatchpoint(Address address, Access access)
+{
+  if (!watchpoints)
   {
-    throw std::runtime_error{"Unable to read ROM."};
+    return;
+  }
+
+  if (static_cast<std::uint8_t>(access) & static_cast<std::uint8_t>(Access::Read))
+  {
+    watchpoints->read.reset(address);
+  }
+  if (static_cast<std::uint8_t>(access) & static_cast<std::uint8_t>(Access::Write))
+  {
+    watchpoints->write.reset(address);
+  }
+  UpdateWatchedPage(address >> 8);
+  watchpointCount = watchpoints->read.count() + watchpoints->write.count();
+
+  if (watchpointCount == 0)
+  {
+    watchpoints.reset();
   }
 }
 
-void MMU::Set(Address address, std::uint8_t value)
+void MMU::ClearWatchpoints()
 {
-  memmory[address] = value;
+  watchpoints.reset();
+  watchpointCount = 0;
+  for (int page = 0; page < pageCount; ++page)
+  {
+    UpdateWatchedPage(page);
+  }
 }
 
-std::uint8_t MMU::Get(Address address)
+/**
+ * @brief Flags the page for the slow path while any address in it is still watched.
+ */
+void MMU::UpdateWatchedPage(int page)
 {
-  if (address == 0xFF44)
+  bool read = false;
+  bool write = false;
+  for (int address = page << 8; address < (page + 1) << 8; ++address)
   {
-    return 0x90;
+    read = read || IsReadWatched(static_cast<Address>(address));
+    write = write || IsWriteWatched(static_cast<Address>(address));
   }
 
-  return memmory[address];
+  SetPageFlag(page, readWatchedPage, read);
+  SetPageFlag(page, writeWatchedPage, write);
 }
@@ -4,19 +4,263 @@
 #include <cstdint>
 #include <limits>
 #include <array>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <bitset>
+
+#include "cartridge.hpp"
 
 using Address = std::uint16_t;
 
+/**
+ * @brief The DMG memory map as a table of 256 byte pages.
+ *
+ * Each page points at the host memory behind it: a ROM bank, video RAM, an external RAM bank, work RAM with its echo,
+ * OAM or the IO page. Get and Set index the table inline and only call out for pages that need more than a memory
+ * access, ROM writes, cartridge RAM that is not plain memory, pages holding pre-decoded code and watched pages.
+ * Switching a bank repoints the pages of its window.
+ *
+ * The IO page has a second table per address. IO registers without a handler, HRAM and IE are served inline from
+ * storage, only registers a component handles call out, through a plain function pointer.
+ */
 class MMU
 {
   static constexpr int memorySize = std::numeric_limits<std::uint16_t>::max() + 1;
-  std::array<std::uint8_t, memorySize> memmory;
+  static constexpr int pageSize = 256;
+  static constexpr int pageCount = memorySize / pageSize;
+  static constexpr int romBankPages = Cartridge::romBankSize / pageSize;
+  static constexpr int firstHighROMPage = 0x40;
+  static constexpr int firstExternalRAMPage = 0xA0;
+  static constexpr int externalRAMPages = Cartridge::ramBankSize / pageSize;
+  static constexpr int ioPageIndex = 0xFF;
+  static constexpr Address ioFirstAddress = 0xFF00;
+
+  Cartridge cartridge;
+  std::array<std::uint8_t, 0x2000> videoRAM;
+  std::array<std::uint8_t, 0x2000> workRAM;
+  // OAM and the unusable area after it.
+  std::array<std::uint8_t, pageSize> objectAttributes;
+  // IO registers, HRAM and IE.
+  std::array<std::uint8_t, pageSize> highPage;
+  // Read where the cartridge does not map memory.
+  std::array<std::uint8_t, pageSize> unmapped;
+  // RAM bank mapped at $A000, null while the cartridge handles accesses there and unmapped before the first mapping.
+  std::uint8_t* mappedRAMBank = unmapped.data();
+  // Writes that changed which banks are mapped, code running from a bank compares it to notice being switched out.
+  std::uint64_t bankSwitches = 0;
+
+  // Host memory behind every page, whatever else happens on access.
+  std::array<std::uint8_t*, pageCount> pages{};
+
+  // What Get and Set have to do per page besides accessing memory.
+  enum PageFlags : std::uint8_t
+  {
+    ioPage = 1 << 0,
+    codePage = 1 << 1,
+    readWatchedPage = 1 << 2,
+    writeWatchedPage = 1 << 3,
+    romPage = 1 << 4,
+    cartridgeRAMPage = 1 << 5
+  };
+  std::array<std::uint8_t, pageCount> pageFlags{};
+
+  // The page table Get and Set go through, null where a flag asks for the slow path.
+  std::array<std::uint8_t*, pageCount> readPages{};
+  std::array<std::uint8_t*, pageCount> writePages{};
+
+  // Writes to pages that hold pre-decoded code are reported to codeWriteHandler.
+  std::function<void(Address)> codeWriteHandler;
+
+  // Accesses to watched addresses are reported to watchHandler. Allocated with the first watchpoint.
+  struct Watchpoints
+  {
+    std::bitset<memorySize> read;
+    std::bitset<memorySize> write;
+  };
+  std::unique_ptr<Watchpoints> watchpoints;
+  std::size_t watchpointCount = 0;
+  std::function<void(Address, std::uint8_t, bool)> watchHandler;
+
+public:
+  using IOReadHandler = std::uint8_t (*)(void* context);
+  using IOWriteHandler = void (*)(void* context, std::uint8_t value);
+
+private:
+  // Handlers of the components owning IO registers, ioHandlerIndex holds 1 + their index for each address.
+  struct IOHandlers
+  {
+    IOReadHandler read = nullptr;
+    void* readContext = nullptr;
+    IOWriteHandler write = nullptr;
+    void* writeContext = nullptr;
+  };
+  std::vector<IOHandlers> ioHandlers;
+  std::array<std::uint8_t, pageSize> ioHandlerIndex{};
+
+  // Bits that read as 1 from storage in the IO page, the unused bits of registers and all of unmapped addresses.
+  std::array<std::uint8_t, pageSize> ioUnusedBits{};
+
+  // Addresses in the IO page Get and Set cannot serve from storage, because of a handler, a watchpoint or code.
+  std::array<bool, pageSize> ioReadSlow{};
+  std::array<bool, pageSize> ioWriteSlow{};
+
+  void MapCartridge();
+  void MapROMBank(int firstPage, std::uint16_t bank);
+  void MapExternalRAM();
+  void UpdatePage(int page);
+  void SetPageFlag(int page, PageFlags flag, bool set);
+  void UpdateIOPage();
+  IOHandlers& GetIOHandlers(Address address);
+
+  std::uint8_t GetSlow(Address address);
+  [[nodiscard]] std::uint8_t PeekSlow(Address address) const;
+  void SetSlow(Address address, std::uint8_t value);
+  void UpdateWatchedPage(int page);
+  [[nodiscard]] bool IsReadWatched(Address address) const { return watchpoints && watchpoints->read[address]; }
+  [[nodiscard]] bool IsWriteWatched(Address address) const { return watchpoints && watchpoints->write[address]; }
 
 public:
   MMU();
 
+  // The page table points into the MMU itself.
+  MMU(const MMU&) = delete;
+  MMU& operator=(const MMU&) = delete;
+
   void LoadROM(const std::string& filePath);
+  void LoadROM(const std::vector<std::uint8_t>& image);
+  bool LoadSave(const std::string& savePath);
+  void FlushSave() { cartridge.FlushSave(); }
+
+  void Set(Address address, std::uint8_t value)
+  {
+    if (std::uint8_t* page = writePages[address >> 8])
+    {
+      page[address & 0xFF] = value;
+      return;
+    }
+    if (address >= ioFirstAddress && !ioWriteSlow[address & 0xFF])
+    {
+      highPage[address & 0xFF] = value;
+      return;
+    }
+    SetSlow(address, value);
+  }
+
+  std::uint8_t Get(Address address)
+  {
+    if (const std::uint8_t* page = readPages[address >> 8])
+    {
+      return page[address & 0xFF];
+    }
+    if (address >= ioFirstAddress && !ioReadSlow[address & 0xFF])
+    {
+      return highPage[address & 0xFF] | ioUnusedBits[address & 0xFF];
+    }
+    return GetSlow(address);
+  }
+
+  /**
+   * @brief Little-endian word, with a single page lookup unless it straddles two pages. Used for operand fetch.
+   */
+  std::uint16_t Get16(Address address)
+  {
+    const std::uint8_t* page = readPages[address >> 8];
+    if (page && (address & 0xFF) != 0xFF)
+    {
+      return static_cast<std::uint16_t>(page[address & 0xFF] | (page[(address & 0xFF) + 1] << 8));
+    }
+    std::uint8_t low = Get(address);
+    return static_cast<std::uint16_t>(low | (Get(static_cast<Address>(address + 1)) << 8));
+  }
+
+  /**
+   * @brief Reads like Get but never reports to a watchpoint, for tracing and debuggers looking at memory.
+   */
+  std::uint8_t Peek(Address address) const
+  {
+    if (pageFlags[address >> 8] & (ioPage | cartridgeRAMPage))
+    {
+      return PeekSlow(address);
+    }
+    return pages[address >> 8][address & 0xFF];
+  }
+
+  /**
+   * @brief The page tables behind Get and Set, for native code doing the same lookup. They never move.
+   */
+  const std::uint8_t* const* GetReadPages() const { return readPages.data(); }
+  std::uint8_t* const* GetWritePages() const { return writePages.data(); }
+
+  /**
+   * @brief ROM or external RAM bank mapped at the address, 0 for memory that is not banked.
+   */
+  std::uint16_t GetBank(Address address) const
+  {
+    if (address < 0x4000)
+    {
+      return cartridge.GetLowROMBank();
+    }
+    if (address < 0x8000)
+    {
+      return cartridge.GetHighROMBank();
+    }
+    if (address >= 0xA000 && address < 0xC000)
+    {
+      return cartridge.GetRAMBank();
+    }
+    return 0;
+  }
+
+  [[nodiscard]] std::uint64_t GetBankSwitches() const { return bankSwitches; }
+
+  [[nodiscard]] const Cartridge& GetCartridge() const { return cartridge; }
+
+  void WatchCodePage(int page, bool watched) { SetPageFlag(page, codePage, watched); }
+  void SetCodeWriteHandler(std::function<void(Address)> handler) { codeWriteHandler = std::move(handler); }
+
+  /**
+   * @brief Lets the component owning the IO register at address produce its value, unused bits included.
+   *
+   * Read handlers must not change any state, Peek calls them too.
+   */
+  void SetIOReadHandler(Address address, IOReadHandler handler, void* context);
+
+  /**
+   * @brief Reports every write to the IO register at address to the component owning it, after storing the value.
+   */
+  void SetIOWriteHandler(Address address, IOWriteHandler handler, void* context);
+
+  /**
+   * @brief Makes a member function of owner the handler, called directly from a function generated for it.
+   */
+  template <auto Method, typename Owner> void SetIOReadHandler(Address address, Owner& owner)
+  {
+    SetIOReadHandler(address, [](void* context) { return (static_cast<Owner*>(context)->*Method)(); }, &owner);
+  }
+
+  template <auto Method, typename Owner> void SetIOWriteHandler(Address address, Owner& owner)
+  {
+    SetIOWriteHandler(
+        address, [](void* context, std::uint8_t value) { (static_cast<Owner*>(context)->*Method)(value); }, &owner);
+  }
+
+  enum class Access : std::uint8_t
+  {
+    Read = 1,
+    Write = 2,
+    ReadWrite = 3
+  };
+
+  void AddWatchpoint(Address address, Access access);
+  void RemoveWatchpoint(Address address, Access access = Access::ReadWrite);
+  void ClearWatchpoints();
+  [[nodiscard]] bool HasWatchpoints() const { return watchpointCount != 0; }
 
-  void Set(Address address, std::uint8_t value);
-  std::uint8_t Get(Address address);
-};
\ No newline at end of file
+  /**
+   * @brief Called with address, value and whether it was a write on every access to a watched address.
+   *
+   * Writes are reported after memory changed, reads before the value is returned.
+   */
+  void SetWatchHandler(std::function<void(Address, std::uint8_t, bool)> handler) { watchHandler = std::move(handler); }
+};
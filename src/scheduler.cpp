@@ -0,0 +1,130 @@
+#include "scheduler.hpp"
+
+#include <utility>
+
+Scheduler::EventId Scheduler::Register(Handler handler)
+{
+  events.push_back({std::move(handler)});
+  return static_cast<EventId>(events.size() - 1);
+}
+
+/**
+ * @brief Schedules the event for the given cycle, an already scheduled event is moved there.
+ */
+void Scheduler::Schedule(EventId event, std::uint64_t cycle)
+{
+  Event& entry = events[event];
+  entry.cycle = cycle;
+  entry.sequence = nextSequence++;
+
+  if (entry.heapIndex == notQueued)
+  {
+    heap.push_back(event);
+    entry.heapIndex = static_cast<std::uint32_t>(heap.size() - 1);
+  }
+
+  // The new key may be earlier or later than the old one.
+  SiftUp(entry.heapIndex);
+  SiftDown(entry.heapIndex);
+  UpdateNextCycle();
+}
+
+void Scheduler::Cancel(EventId event)
+{
+  if (IsScheduled(event))
+  {
+    Remove(event);
+  }
+}
+
+/**
+ * @brief Runs every event due at or before now, handlers may schedule and cancel events themselves.
+ */
+void Scheduler::RunDue(std::uint64_t now)
+{
+  while (!heap.empty() && events[heap.front()].cycle <= now)
+  {
+    EventId event = heap.front();
+    std::uint64_t cycle = events[event].cycle;
+
+    Remove(event);
+    ++dispatchCount;
+    events[event].handler(cycle);
+  }
+}
+
+bool Scheduler::IsBefore(EventId lhs, EventId rhs) const
+{
+  const Event& a = events[lhs];
+  const Event& b = events[rhs];
+  return a.cycle < b.cycle || (a.cycle == b.cycle && a.sequence < b.sequence);
+}
+
+void Scheduler::Place(std::uint32_t index, EventId event)
+{
+  heap[index] = event;
+  events[event].heapIndex = index;
+}
+
+void Scheduler::SiftUp(std::uint32_t index)
+{
+  EventId event = heap[index];
+
+  while (index > 0)
+  {
+    std::uint32_t parent = (index - 1) / 2;
+    if (!IsBefore(event, heap[parent]))
+    {
+      break;
+    }
+    Place(index, heap[parent]);
+    index = parent;
+  }
+
+  Place(index, event);
+}
+
+void Scheduler::SiftDown(std::uint32_t index)
+{
+  EventId event = heap[index];
+  const std::uint32_t size = static_cast<std::uint32_t>(heap.size());
+
+  while (true)
+  {
+    std::uint32_t child = 2 * index + 1;
+    if (child >= size)
+    {
+      break;
+    }
+    if (child + 1 < size && IsBefore(heap[child + 1], heap[child]))
+    {
+      ++child;
+    }
+    if (!IsBefore(heap[child], event))
+    {
+      break;
+    }
+    Place(index, heap[child]);
+    index = child;
+  }
+
+  Place(index, event);
+}
+
+void Scheduler::Remove(EventId event)
+{
+  std::uint32_t index = events[event].heapIndex;
+  EventId last = heap.back();
+
+  heap.pop_back();
+  events[event].heapIndex = notQueued;
+
+  if (last != event)
+  {
+    Place(index, last);
+    SiftUp(index);
+    SiftDown(events[last].heapIndex);
+  }
+
+  UpdateNextCycle();
+}
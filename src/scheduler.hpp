@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+/**
+ * @brief Timestamp ordered events keyed on the CPU cycle counter.
+ *
+ * Components register an event once and then schedule, reschedule or cancel it. Due events run in cycle order and
+ * events due on the same cycle in the order they were scheduled, so dispatch is deterministic. Events are kept in a
+ * binary min-heap that remembers where every event sits, which makes rescheduling and cancelling O(log n).
+ */
+class Scheduler
+{
+public:
+  using EventId = std::uint32_t;
+
+  // Called with the cycle the event was scheduled for, which may lie slightly before the current cycle.
+  using Handler = std::function<void(std::uint64_t cycle)>;
+
+  static constexpr std::uint64_t never = std::numeric_limits<std::uint64_t>::max();
+
+  /**
+   * @brief Adds an unscheduled event, not allowed from within a handler.
+   */
+  EventId Register(Handler handler);
+
+  void Schedule(EventId event, std::uint64_t cycle);
+  void Cancel(EventId event);
+  [[nodiscard]] bool IsScheduled(EventId event) const { return events[event].heapIndex != notQueued; }
+  [[nodiscard]] std::uint64_t GetCycle(EventId event) const { return events[event].cycle; }
+
+  [[nodiscard]] std::uint64_t NextCycle() const { return nextCycle; }
+  [[nodiscard]] std::uint64_t DispatchCount() const { return dispatchCount; }
+
+  void RunDue(std::uint64_t now);
+
+private:
+  static constexpr std::uint32_t notQueued = std::numeric_limits<std::uint32_t>::max();
+
+  struct Event
+  {
+    Handler handler;
+    std::uint64_t cycle = never;
+    std::uint64_t sequence = 0;
+    std::uint32_t heapIndex = notQueued;
+  };
+
+  std::vector<Event> events;
+  std::vector<EventId> heap;
+
+  std::uint64_t nextCycle = never;
+  std::uint64_t nextSequence = 0;
+  std::uint64_t dispatchCount = 0;
+
+  [[nodiscard]] bool IsBefore(EventId lhs, EventId rhs) const;
+  void Place(std::uint32_t index, EventId event);
+  void SiftUp(std::uint32_t index);
+  void SiftDown(std::uint32_t index);
+  void Remove(EventId event);
+  void UpdateNextCycle() { nextCycle = heap.empty() ? never : events[heap.front()].cycle; }
+};
@@ -0,0 +1,63 @@
+#include "serial.hpp"
+
+#include "cpu/cpu.hpp"
+
+Serial::Serial(MMU& mmu, CPU& cpu) : mmu(mmu), cpu(cpu)
+{
+  transferEvent = cpu.GetScheduler().Register([this](std::uint64_t) { CompleteTransfer(); });
+  mmu.SetIOWriteHandler<&Serial::WriteControl>(controlAddress, *this);
+}
+
+std::string Serial::GetOutput() const
+{
+  std::string text;
+  text.reserve(outputSize);
+
+  std::size_t start = (outputEnd + outputCapacity - outputSize) % outputCapacity;
+  for (std::size_t i = 0; i < outputSize; ++i)
+  {
+    text.push_back(static_cast<char>(output[(start + i) % outputCapacity]));
+  }
+
+  return text;
+}
+
+/**
+ * @brief Starts a transfer on the internal clock, clearing bit 7 aborts a running one.
+ */
+void Serial::WriteControl(std::uint8_t value)
+{
+  Scheduler& scheduler = cpu.GetScheduler();
+
+  if (!(value & transferStart))
+  {
+    scheduler.Cancel(transferEvent);
+    return;
+  }
+
+  if ((value & internalClock) && !scheduler.IsScheduled(transferEvent))
+  {
+    outgoing = mmu.Get(dataAddress);
+    scheduler.Schedule(transferEvent, cpu.GetCycles() + transferCycles);
+  }
+}
+
+void Serial::CompleteTransfer()
+{
+  output[outputEnd] = outgoing;
+  outputEnd = (outputEnd + 1) % outputCapacity;
+  if (outputSize < outputCapacity)
+  {
+    ++outputSize;
+  }
+  ++bytesSent;
+
+  if (sink)
+  {
+    sink(outgoing);
+  }
+
+  mmu.Set(dataAddress, 0xFF);
+  mmu.Set(controlAddress, mmu.Get(controlAddress) & ~transferStart);
+  cpu.RequestInterrupt(interrupts::bitpos::SERIAL);
+}
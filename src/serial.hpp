@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "mmu.hpp"
+#include "scheduler.hpp"
+
+class CPU;
+
+/**
+ * @brief Serial port (SB 0xFF01, SC 0xFF02) without a link partner.
+ *
+ * Setting bit 7 of SC with the internal clock selected shifts SB out over 8 bits at 8192 Hz. When the transfer
+ * completes SB reads 0xFF, as nothing was shifted in, bit 7 of SC is cleared and the SERIAL interrupt is requested.
+ * Transfers on the external clock never complete, there is no partner driving it.
+ *
+ * Every byte sent is kept in a ring buffer and handed to the sink if one is set, nothing runs per instruction.
+ */
+class Serial
+{
+public:
+  static constexpr std::uint64_t transferCycles = 8 * 512;
+  static constexpr std::size_t outputCapacity = 4096;
+
+  using Sink = std::function<void(std::uint8_t)>;
+
+  Serial(MMU& mmu, CPU& cpu);
+
+  Serial(const Serial&) = delete;
+  Serial& operator=(const Serial&) = delete;
+
+  void SetSink(Sink sink) { this->sink = std::move(sink); }
+
+  /**
+   * @brief Bytes sent since the last ClearOutput, only the latest outputCapacity of them are kept.
+   */
+  [[nodiscard]] std::string GetOutput() const;
+  void ClearOutput() { outputSize = 0; }
+  [[nodiscard]] std::uint64_t GetBytesSent() const { return bytesSent; }
+
+private:
+  static constexpr Address dataAddress = 0xFF01;
+  static constexpr Address controlAddress = 0xFF02;
+  static constexpr std::uint8_t transferStart = 0x80;
+  static constexpr std::uint8_t internalClock = 0x01;
+
+  MMU& mmu;
+  CPU& cpu;
+
+  Scheduler::EventId transferEvent;
+  std::uint8_t outgoing = 0;
+
+  Sink sink;
+  std::array<std::uint8_t, outputCapacity> output{};
+  std::size_t outputEnd = 0;
+  std::size_t outputSize = 0;
+  std::uint64_t bytesSent = 0;
+
+  void WriteControl(std::uint8_t value);
+  void CompleteTransfer();
+};
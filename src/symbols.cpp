@@ -0,0 +1,93 @@
+#include "symbols.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+Symbols Symbols::Load(const std::string& filePath)
+{
+  std::ifstream file{filePath};
+  if (!file)
+  {
+    throw std::runtime_error{"Unable to open symbol file."};
+  }
+
+  Symbols symbols;
+  std::string line;
+  while (std::getline(file, line))
+  {
+    line = line.substr(0, line.find(';'));
+
+    std::istringstream fields{line};
+    std::string location;
+    std::string name;
+    if (!(fields >> location >> name))
+    {
+      continue;
+    }
+
+    std::size_t colon = location.find(':');
+    if (colon == std::string::npos)
+    {
+      continue;
+    }
+
+    try
+    {
+      auto bank = static_cast<std::uint16_t>(std::stoul(location.substr(0, colon), nullptr, 16));
+      auto address = static_cast<Address>(std::stoul(location.substr(colon + 1), nullptr, 16));
+      symbols.Add(bank, address, std::move(name));
+    }
+    catch (const std::logic_error&)
+    {
+      // Not a label line, RGBDS only writes comments besides them.
+    }
+  }
+
+  return symbols;
+}
+
+std::string Symbols::PathForROM(const std::string& romPath)
+{
+  return std::filesystem::path{romPath}.replace_extension(".sym").string();
+}
+
+void Symbols::Add(std::uint16_t bank, Address address, std::string name)
+{
+  if (name.find('.') == std::string::npos)
+  {
+    routines.emplace(Key(bank, address), name);
+  }
+  labels.emplace(Key(bank, address), std::move(name));
+}
+
+std::optional<Symbols::Symbol> Symbols::Find(std::uint16_t bank, Address address) const
+{
+  auto label = labels.find(Key(bank, address));
+  if (label == labels.end())
+  {
+    return std::nullopt;
+  }
+  return Symbol{bank, address, &label->second};
+}
+
+/**
+ * @brief The closest global label at or before the address in the same bank, the routine the address belongs to.
+ */
+std::optional<Symbols::Symbol> Symbols::FindRoutine(std::uint16_t bank, Address address) const
+{
+  auto next = routines.upper_bound(Key(bank, address));
+  if (next == routines.begin())
+  {
+    return std::nullopt;
+  }
+
+  auto routine = std::prev(next);
+  if ((routine->first >> 16) != bank)
+  {
+    return std::nullopt;
+  }
+  return Symbol{bank, static_cast<Address>(routine->first & 0xFFFF), &routine->second};
+}
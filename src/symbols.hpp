@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+
+#include "mmu.hpp"
+
+/**
+ * @brief Labels from an RGBDS .sym file, keyed on bank and address.
+ *
+ * Lines look like "01:4000 Label", everything after a ';' is a comment. Local labels ("Parent.local") are kept for
+ * exact lookups, but only global labels start a routine for FindRoutine.
+ */
+class Symbols
+{
+public:
+  struct Symbol
+  {
+    std::uint16_t bank;
+    Address address;
+    const std::string* name;
+  };
+
+  static Symbols Load(const std::string& filePath);
+
+  /**
+   * @brief Path of the .sym file RGBDS writes next to a ROM, which may not exist.
+   */
+  static std::string PathForROM(const std::string& romPath);
+
+  void Add(std::uint16_t bank, Address address, std::string name);
+
+  [[nodiscard]] std::optional<Symbol> Find(std::uint16_t bank, Address address) const;
+  [[nodiscard]] std::optional<Symbol> FindRoutine(std::uint16_t bank, Address address) const;
+
+  [[nodiscard]] bool IsEmpty() const { return labels.empty(); }
+
+private:
+  static std::uint32_t Key(std::uint16_t bank, Address address) { return (std::uint32_t{bank} << 16) | address; }
+
+  std::map<std::uint32_t, std::string> labels;
+  std::map<std::uint32_t, std::string> routines;
+};
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cpu/cpu.hpp"
+#include "mappedfile.hpp"
+#include "mmu.hpp"
+#include "serial.hpp"
+
+namespace
+{
+
+constexpr int defaultContextLines = 8;
+
+// "A:01 F:B0 B:00 C:13 D:00 E:D8 H:01 L:4D SP:FFFE PC:0100 PCMEM:00,C3,13,02"
+constexpr std::size_t lineLength = 73;
+using Line = std::array<char, lineLength>;
+
+char* WriteHex(char* out, unsigned value, int digits)
+{
+  static constexpr char hexDigits[] = "0123456789ABCDEF";
+  for (int shift = 4 * (digits - 1); shift >= 0; shift -= 4)
+  {
+    *out++ = hexDigits[(value >> shift) & 0xF];
+  }
+  return out;
+}
+
+char* WriteField(char* out, const char* name, unsigned value, int digits)
+{
+  while (*name)
+  {
+    *out++ = *name++;
+  }
+  return WriteHex(out, value, digits);
+}
+
+/**
+ * @brief Formats the state before the next instruction exactly like a gameboy-doctor log line.
+ *
+ * This runs for every instruction, so it writes the digits by hand instead of going through printf.
+ */
+Line FormatState(const CPU::State& state, MMU& mmu)
+{
+  Line line;
+  char* out = line.data();
+  out = WriteField(out, "A:", state.A, 2);
+  out = WriteField(out, " F:", state.F, 2);
+  out = WriteField(out, " B:", state.B, 2);
+  out = WriteField(out, " C:", state.C, 2);
+  out = WriteField(out, " D:", state.D, 2);
+  out = WriteField(out, " E:", state.E, 2);
+  out = WriteField(out, " H:", state.H, 2);
+  out = WriteField(out, " L:", state.L, 2);
+  out = WriteField(out, " SP:", state.SP, 4);
+  out = WriteField(out, " PC:", state.PC, 4);
+  out = WriteField(out, " PCMEM:", mmu.Get(state.PC), 2);
+  for (int i = 1; i < 4; ++i)
+  {
+    out = WriteField(out, ",", mmu.Get(state.PC + i), 2);
+  }
+  return line;
+}
+
+bool SameCharacter(char actual, char expected)
+{
+  return actual == std::toupper(static_cast<unsigned char>(expected));
+}
+
+bool SameLine(const Line& actual, const char* expected, std::size_t expectedLength)
+{
+  return expectedLength == lineLength &&
+         (std::memcmp(actual.data(), expected, lineLength) == 0 ||
+          std::equal(actual.begin(), actual.end(), expected, SameCharacter));
+}
+
+/**
+ * @brief Runs the ROM and compares the state before every instruction with the next line of the log.
+ *
+ * Stops at the first line that differs and prints the lines leading up to it, which matched.
+ */
+bool Compare(const std::string& romPath, const std::string& logPath, int contextLines)
+{
+  MMU mmu;
+  mmu.LoadROM(romPath);
+
+  CPU cpu{mmu};
+  Serial serial{mmu, cpu};
+  // The log has a line for every iteration of an idle loop.
+  cpu.SetIdleLoopSkipping(false);
+
+  MappedFile log{logPath};
+  // Lines that matched, they are only read again to show what led up to a divergence.
+  std::vector<std::string_view> context;
+  std::uint64_t lineNumber = 0;
+
+  const char* begin = reinterpret_cast<const char*>(log.GetData());
+  const char* end = begin + log.GetSize();
+  for (const char* line = begin; line < end;)
+  {
+    const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+    const char* next = lineEnd ? lineEnd + 1 : end;
+    lineEnd = lineEnd ? lineEnd : end;
+    std::size_t length = lineEnd - line;
+    if (length > 0 && line[length - 1] == '\r')
+    {
+      --length;
+    }
+    ++lineNumber;
+
+    if (length == 0)
+    {
+      line = next;
+      continue;
+    }
+
+    // Waking from HALT is a step of its own, the log only has the instructions.
+    while (cpu.IsHalted())
+    {
+      if (cpu.Tick() == 0)
+      {
+        std::fprintf(stderr, "%s: halted for good before log line %llu\n", romPath.c_str(),
+                     static_cast<unsigned long long>(lineNumber));
+        return false;
+      }
+    }
+
+    Line actual = FormatState(cpu.GetState(), mmu);
+    if (!SameLine(actual, line, length))
+    {
+      std::string_view expected(line, length);
+      std::fprintf(stderr, "%s: diverged at log line %llu, cycle %llu\n", romPath.c_str(),
+                   static_cast<unsigned long long>(lineNumber), static_cast<unsigned long long>(cpu.GetCycles()));
+      for (std::string_view previous : context)
+      {
+        std::fprintf(stderr, "            %.*s\n", static_cast<int>(previous.size()), previous.data());
+      }
+      std::fprintf(stderr, "  expected: %.*s\n  actual:   %.*s\n            ", static_cast<int>(expected.size()),
+                   expected.data(), static_cast<int>(lineLength), actual.data());
+      for (std::size_t i = 0; i < std::max(expected.size(), lineLength); ++i)
+      {
+        bool same = i < expected.size() && i < lineLength && SameCharacter(actual[i], expected[i]);
+        std::fputc(same ? ' ' : '^', stderr);
+      }
+      std::fputc('\n', stderr);
+      return false;
+    }
+
+    if (contextLines > 0)
+    {
+      if (context.size() == static_cast<std::size_t>(contextLines))
+      {
+        context.erase(context.begin());
+      }
+      context.emplace_back(line, length);
+    }
+
+    cpu.Tick();
+    line = next;
+  }
+
+  std::fprintf(stderr, "%s: matches all %llu lines of the log\n", romPath.c_str(),
+               static_cast<unsigned long long>(lineNumber));
+  std::string output = serial.GetOutput();
+  if (!output.empty())
+  {
+    std::fprintf(stderr, "Serial output:\n%s\n", output.c_str());
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  int contextLines = defaultContextLines;
+  std::vector<std::string> paths;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string argument = argv[i];
+
+    if (argument == "--context" && i + 1 < argc)
+    {
+      contextLines = std::stoi(argv[++i]);
+    }
+    else
+    {
+      paths.push_back(argument);
+    }
+  }
+
+  if (paths.size() != 2)
+  {
+    std::cerr << "Usage: gbe-doctor [--context N] PathToRom PathToLog." << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  return Compare(paths[0], paths[1], contextLines) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,178 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "cpu/cpu.hpp"
+#include "mmu.hpp"
+
+namespace
+{
+
+constexpr std::uint64_t defaultInstructionCount = 30'000'000;
+constexpr std::uint64_t defaultStep = 1000;
+
+// Comparing all of memory is expensive, so it only happens every few steps.
+constexpr std::uint64_t memoryCompareInterval = 64;
+
+void PrintState(const char* name, const CPU::State& state)
+{
+  std::fprintf(stderr, "  %-11s A:%02X F:%02X B:%02X C:%02X D:%02X E:%02X H:%02X L:%02X SP:%04X PC:%04X IME:%d HALT:%d\n",
+               name, state.A, state.F, state.B, state.C, state.D, state.E, state.H, state.L, state.SP, state.PC,
+               state.IME, state.halted);
+}
+
+double Percent(std::uint64_t part, std::uint64_t total)
+{
+  return (total != 0) ? 100.0 * static_cast<double>(part) / static_cast<double>(total) : 0.0;
+}
+
+/**
+ * @brief How much of the ROM ran as native code, and why the rest was interpreted.
+ */
+void PrintCoverage(const CPU::JitCoverage& coverage)
+{
+  std::uint64_t total = coverage.native + coverage.Interpreted();
+  const std::pair<const char*, std::uint64_t> rows[] = {{"native", coverage.native},
+                                                        {"cold", coverage.cold},
+                                                        {"untranslated", coverage.untranslated},
+                                                        {"interrupt due", coverage.interruptDue},
+                                                        {"limited", coverage.limited},
+                                                        {"exited", coverage.exited}};
+
+  std::fprintf(stderr, "  native coverage %.1f%%\n", Percent(coverage.native, total));
+  for (auto [name, count] : rows)
+  {
+    std::fprintf(stderr, "  %-14s %12llu %5.1f%%\n", name, static_cast<unsigned long long>(count),
+                 Percent(count, total));
+  }
+}
+
+int FindMemoryMismatch(MMU& a, MMU& b)
+{
+  for (int address = 0; address <= 0xFFFF; ++address)
+  {
+    if (a.Get(address) != b.Get(address))
+    {
+      return address;
+    }
+  }
+
+  return -1;
+}
+
+/**
+ * @brief Runs the ROM on the JIT and the threaded interpreter in lockstep and reports the first divergence.
+ */
+bool CompareROM(const std::string& romPath, std::uint64_t instructionCount, std::uint64_t step)
+{
+  MMU referenceMMU;
+  MMU jitMMU;
+  referenceMMU.LoadROM(romPath);
+  jitMMU.LoadROM(romPath);
+
+  CPU reference{referenceMMU};
+  CPU jit{jitMMU};
+  reference.SetDispatch(CPU::Dispatch::Threaded);
+  jit.SetDispatch(CPU::Dispatch::Jit);
+
+  std::uint64_t executed = 0;
+  std::uint64_t steps = 0;
+
+  while (executed < instructionCount && !reference.IsHalted())
+  {
+    std::uint64_t referenceExecuted = reference.Run(step);
+    std::uint64_t jitExecuted = jit.Run(step);
+
+    CPU::State referenceState = reference.GetState();
+    CPU::State jitState = jit.GetState();
+
+    int mismatch = -1;
+    if (++steps % memoryCompareInterval == 0 || referenceState != jitState)
+    {
+      mismatch = FindMemoryMismatch(referenceMMU, jitMMU);
+    }
+
+    bool cyclesDiffer = reference.GetCycles() != jit.GetCycles();
+
+    if (referenceExecuted != jitExecuted || referenceState != jitState || cyclesDiffer || mismatch >= 0)
+    {
+      std::fprintf(stderr, "\n%s: diverged between instruction %llu and %llu\n", romPath.c_str(),
+                   static_cast<unsigned long long>(executed),
+                   static_cast<unsigned long long>(executed + referenceExecuted));
+      PrintState("interpreter", referenceState);
+      PrintState("jit", jitState);
+      if (cyclesDiffer)
+      {
+        std::fprintf(stderr, "  cycles: interpreter %llu, jit %llu\n",
+                     static_cast<unsigned long long>(reference.GetCycles()),
+                     static_cast<unsigned long long>(jit.GetCycles()));
+      }
+      if (mismatch >= 0)
+      {
+        std::fprintf(stderr, "  memory at %04X: interpreter %02X, jit %02X\n", mismatch, referenceMMU.Get(mismatch),
+                     jitMMU.Get(mismatch));
+      }
+      return false;
+    }
+
+    executed += referenceExecuted;
+  }
+
+  std::fprintf(stderr, "\n%s: identical for %llu instructions\n", romPath.c_str(),
+               static_cast<unsigned long long>(executed));
+  PrintCoverage(jit.GetJitCoverage());
+  return true;
+}
+
+void Usage()
+{
+  std::cerr << "Usage: gbe-jit-diff [--instructions N] [--step N] PathToRom..." << std::endl;
+  std::exit(EXIT_FAILURE);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    Usage();
+  }
+
+  if (!Jit::IsAvailable())
+  {
+    std::cerr << "The JIT is not available on this platform." << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  std::uint64_t instructionCount = defaultInstructionCount;
+  std::uint64_t step = defaultStep;
+  bool identical = true;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string argument = argv[i];
+
+    if (argument == "--instructions" && i + 1 < argc)
+    {
+      instructionCount = std::stoull(argv[++i]);
+    }
+    else if (argument == "--step" && i + 1 < argc)
+    {
+      step = std::stoull(argv[++i]);
+    }
+    else if (argument.rfind("--", 0) == 0)
+    {
+      Usage();
+    }
+    else
+    {
+      identical = CompareROM(argument, instructionCount, step) && identical;
+    }
+  }
+
+  return identical ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,64 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cpu/trace.hpp"
+
+namespace
+{
+
+// Records are read in chunks, so even long traces only take a fixed amount of memory.
+constexpr std::size_t chunkSize = 4096;
+
+/**
+ * @brief Prints a record as a gameboy-doctor log line, optionally prefixed with its cycle stamp and bank.
+ */
+void PrintRecord(const TraceRecord& record, bool withCycles)
+{
+  if (withCycles)
+  {
+    std::printf("%12llu %04X ", static_cast<unsigned long long>(record.cycle), record.bank);
+  }
+
+  std::printf("A:%02X F:%02X B:%02X C:%02X D:%02X E:%02X H:%02X L:%02X SP:%04X PC:%04X PCMEM:%02X,%02X,%02X,%02X\n",
+              record.A, record.F, record.B, record.C, record.D, record.E, record.H, record.L, record.SP, record.PC,
+              record.pcMemory[0], record.pcMemory[1], record.pcMemory[2], record.pcMemory[3]);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc < 2 || argc > 3 || (argc == 3 && std::string(argv[1]) != "--cycles"))
+  {
+    std::cerr << "Usage: gbe-trace-dump [--cycles] PathToTrace." << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  bool withCycles = (argc == 3);
+  std::ifstream file{argv[argc - 1], std::ios::in | std::ios::binary};
+
+  if (!file || !Trace::ReadHeader(file))
+  {
+    std::cerr << "Not a trace file: " << argv[argc - 1] << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  std::vector<TraceRecord> records(chunkSize);
+  while (file)
+  {
+    file.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(TraceRecord));
+    std::size_t count = static_cast<std::size_t>(file.gcount()) / sizeof(TraceRecord);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      PrintRecord(records[i], withCycles);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}